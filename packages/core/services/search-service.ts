@@ -1,14 +1,14 @@
 
-import { DocumentEngine, SearchResult } from '@papyrus-sdk/types';
+import { DocumentEngine, SearchOptions, SearchResult } from '@papyrus-sdk/types';
 
 export class SearchService {
   private engine: DocumentEngine;
   constructor(engine: DocumentEngine) { this.engine = engine; }
 
-  async search(query: string): Promise<SearchResult[]> {
+  async search(query: string, options?: SearchOptions): Promise<SearchResult[]> {
     if (!query || query.length < 2) return [];
     if (typeof this.engine.searchText === 'function') {
-      return await this.engine.searchText(query);
+      return await this.engine.searchText(query, options);
     }
     const results: SearchResult[] = [];
     const pageCount = this.engine.getPageCount();
@@ -0,0 +1,802 @@
+// Per-operation latency and throughput of the native core across document
+// sizes. Runs against the synthetic PDFium stand-in by default, or against a
+// real PDFium build and file:
+//
+//   papyrus_bench [--pages 10,100,1000] [--iterations 20] [--workers N] [--seed S] [--stats 1]
+//   papyrus_bench --pdfium /path/libpdfium.so --file doc.pdf [--iterations 20]
+//   papyrus_bench --check 1 [--seed S]
+//
+// Latencies are wall-clock per run; throughput counts the unit of the
+// operation (pages, tiles or calls) per second over all runs. --stats 1 also prints
+// the per-phase breakdown (papyrus_stats.h) collected over each document.
+// --check 1 only compares kernels of the core with naive references, exiting
+// non-zero on a mismatch.
+
+#include "papyrus_approx_match.h"
+#include "papyrus_metadata.h"
+#include "papyrus_outline.h"
+#include "papyrus_pdfium.h"
+#include "papyrus_progressive.h"
+#include "papyrus_render.h"
+#include "papyrus_search_index.h"
+#include "papyrus_session.h"
+#include "papyrus_source.h"
+#include "papyrus_stats.h"
+#include "papyrus_stub_pdfium.h"
+#include "papyrus_term_matcher.h"
+#include "papyrus_text_cache.h"
+#include "papyrus_text_export.h"
+#include "papyrus_text_match.h"
+#include "papyrus_text_runs.h"
+#include "papyrus_text_search.h"
+#include "papyrus_text_select.h"
+#include "papyrus_thumbnail.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Mirrors SEARCH_TEXT_BATCH_PAGES / SEARCH_TEXT_MAX_HITS in the module; a
+// batch is kSearchBatchPages per worker.
+constexpr int kSearchBatchPages = 8;
+constexpr int kSearchMaxHits = 200;
+
+struct Options {
+  std::vector<int> pageCounts = {10, 100, 1000};
+  int iterations = 20;
+  int workers = 0;
+  uint32_t seed = 1;
+  bool stats = false;
+  bool check = false;
+  const char *pdfiumLibrary = nullptr;
+  const char *file = nullptr;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double Milliseconds(Clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+void PrintHeader() {
+  std::printf("%-26s %7s %6s %10s %10s %10s %14s\n", "operation", "pages", "runs", "mean ms", "p50 ms", "p95 ms", "throughput");
+}
+
+// Times run() iterations times; each run processes unitsPerRun units.
+void Measure(const char *operation, int pages, int iterations, double unitsPerRun, const char *unit, const std::function<void()> &run) {
+  std::vector<double> samples;
+  samples.reserve(iterations);
+  double total = 0;
+  for (int i = 0; i < iterations; i++) {
+    Clock::time_point start = Clock::now();
+    run();
+    samples.push_back(Milliseconds(start));
+    total += samples.back();
+  }
+  std::sort(samples.begin(), samples.end());
+  double p50 = samples[samples.size() / 2];
+  double p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+  double throughput = total > 0 ? unitsPerRun * iterations / (total / 1000.0) : 0;
+  char rate[32];
+  std::snprintf(rate, sizeof(rate), "%.0f %s/s", throughput, unit);
+  std::printf("%-26s %7d %6d %10.3f %10.3f %10.3f %14s\n", operation, pages, iterations, total / iterations, p50, p95, rate);
+}
+
+std::vector<unsigned short> Wide(const char *ascii) {
+  return std::vector<unsigned short>(ascii, ascii + std::strlen(ascii));
+}
+
+// Scans the whole document the way searchNext does and returns the hit count.
+int SearchAll(PapyrusSession *session, const char *query, int flags, int workers) {
+  std::vector<unsigned short> wide = Wide(query);
+  SearchCursor *cursor = OpenSearchCursor(session, wide.data(), static_cast<int>(wide.size()), flags);
+  if (!cursor) return 0;
+  int hits = 0;
+  while (SearchCursorPosition(cursor) >= 0) {
+    int found = SearchCursorNext(cursor, kSearchBatchPages * workers, workers, kSearchMaxHits);
+    if (found < 0) break;
+    hits += found;
+  }
+  delete cursor;
+  return hits;
+}
+
+// Finds every term in one terms cursor and returns the hit count.
+int SearchAllTerms(PapyrusSession *session, const std::vector<std::vector<unsigned short>> &terms, int workers) {
+  std::vector<const unsigned short *> chars;
+  std::vector<int> lengths;
+  for (const std::vector<unsigned short> &term : terms) {
+    chars.push_back(term.data());
+    lengths.push_back(static_cast<int>(term.size()));
+  }
+  SearchCursor *cursor = OpenTermsCursor(session, chars.data(), lengths.data(), static_cast<int>(terms.size()), 0);
+  if (!cursor) return 0;
+  int hits = 0;
+  while (SearchCursorPosition(cursor) >= 0) {
+    int found = SearchCursorNext(cursor, kSearchBatchPages * workers, workers, kSearchMaxHits);
+    if (found < 0) break;
+    hits += found;
+  }
+  delete cursor;
+  return hits;
+}
+
+void PrintStats(const PapyrusStats &stats) {
+  static const char *const kPhases[kStatPhaseCount] = {
+    "pageLoad", "textLoad", "glyphs", "textIndex", "find", "preview", "marshal", "render",
+  };
+  static const char *const kCounters[kStatCounterCount] = {
+    "textCacheHits", "textCacheMisses", "textCacheEvictions", "pagesScanned", "searchHits", "pagesSkipped",
+    "thumbnailCacheHits", "thumbnailsRendered",
+  };
+  std::vector<int64_t> values;
+  stats.Snapshot(&values);
+  size_t at = 3;
+  for (const char *phase : kPhases) {
+    int64_t count = values[at];
+    if (count > 0) {
+      std::printf("  %-12s %10lld calls %12.3f ms total %10.3f us mean %10.3f ms max\n", phase, static_cast<long long>(count),
+                  values[at + 1] / 1e6, values[at + 1] / 1e3 / count, values[at + 2] / 1e6);
+    }
+    at += 3 + kStatBuckets;
+  }
+  for (const char *counter : kCounters) {
+    std::printf("  %-20s %lld\n", counter, static_cast<long long>(values[at++]));
+  }
+}
+
+// A temp file holding content; empty on failure.
+std::string WriteTempFile(const std::string &content) {
+  char name[] = "/tmp/papyrus_benchXXXXXX";
+  int fd = mkstemp(name);
+  if (fd < 0) return "";
+  bool written = write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size());
+  close(fd);
+  if (!written) {
+    unlink(name);
+    return "";
+  }
+  return name;
+}
+
+void BenchDocument(const std::string &path, const Options &options) {
+  PapyrusStats stats;
+  PapyrusSession *session = OpenSession(path.c_str());
+  if (!session) {
+    std::fprintf(stderr, "papyrus_bench: cannot open %s\n", path.c_str());
+    return;
+  }
+  if (options.stats) session->stats = &stats;
+  const int pages = session->pageCount;
+  const int iterations = options.iterations;
+  // Cold runs re-extract every page, so they get fewer iterations on big files.
+  const int coldIterations = std::max(1, std::min(iterations, 2000 / std::max(1, pages)));
+
+  Measure("open+close", pages, iterations, 1, "ops", [&] { CloseSession(OpenSession(path.c_str())); });
+  {
+    // The same document read in place: from a mapped file, from memory and
+    // while downloading. Synthetic documents live in a file holding their path.
+    std::string file = options.file ? options.file : WriteTempFile(path);
+    int fd = file.empty() ? -1 : open(file.c_str(), O_RDONLY);
+    if (fd >= 0) {
+      Measure("open+close.mmap", pages, iterations, 1, "ops", [&] {
+        CloseSession(OpenSession(DocumentSource::MapFile(fd, 0, -1)));
+      });
+      std::shared_ptr<DocumentSource> mapped = DocumentSource::MapFile(fd, 0, -1);
+      std::vector<uint8_t> bytes(mapped->Data(), mapped->Data() + mapped->Size());
+      Measure("open+close.buffer", pages, iterations, 1, "ops", [&] {
+        CloseSession(OpenSession(DocumentSource::Borrow(bytes.data(), bytes.size())));
+      });
+      // A download arriving in order in 16 KiB chunks, polled after each one
+      // until the first page can render.
+      const int64_t chunk = 16 * 1024;
+      const int64_t length = static_cast<int64_t>(bytes.size());
+      Measure("open.progressive.page1", pages, iterations, 1, "ops", [&] {
+        std::shared_ptr<ProgressiveSource> source = ProgressiveSource::Create(fd, length);
+        PapyrusSession *progressive = OpenProgressiveSession(source);
+        if (!progressive) return;
+        for (int64_t received = 0; received < length;) {
+          source->MarkReceived(received, chunk);
+          received += chunk;
+          int status = PollProgressiveDocument(progressive);
+          if (status == kPdfDataError || (status == kPdfDataAvail && PageDataReady(progressive, 0))) break;
+        }
+        CloseSession(progressive);
+      });
+
+      // A cold search for a rare word without and with the persistent index,
+      // which leaves the pages it rules out unextracted.
+      char directory[] = "/tmp/papyrus_indexXXXXXX";
+      PapyrusSession *indexed = mkdtemp(directory) ? OpenSession(DocumentSource::MapFile(fd, 0, -1)) : nullptr;
+      if (indexed) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/%016" PRIx64 ".pidx", DocumentFingerprint(indexed));
+        std::string indexFile = std::string(directory) + name;
+        Measure("index.build", pages, coldIterations, pages, "pages", [&] {
+          unlink(indexFile.c_str());
+          indexed->textCache.reset();
+          AttachSearchIndex(indexed, directory);
+          while (BuildSearchIndex(indexed, kSearchBatchPages) >= 0) {
+          }
+        });
+        Measure("index.attach", pages, iterations, 1, "ops", [&] { AttachSearchIndex(indexed, directory); });
+        indexed->searchIndex.reset();
+        Measure("search.cold.rare", pages, coldIterations, pages, "pages", [&] {
+          indexed->textCache.reset();
+          SearchAll(indexed, kSyntheticRareWord, 0, options.workers);
+        });
+        AttachSearchIndex(indexed, directory);
+        Measure("search.cold.rare.indexed", pages, coldIterations, pages, "pages", [&] {
+          indexed->textCache.reset();
+          SearchAll(indexed, kSyntheticRareWord, 0, options.workers);
+        });
+
+        // Sidebar thumbnails, rendered and then read back from the disk cache.
+        const int thumbnailPages = std::min(pages, 32);
+        const int thumbnailWidth = 180;
+        const int thumbnailHeight = thumbnailWidth * 792 / 612;
+        std::vector<uint16_t> thumbnail(static_cast<size_t>(thumbnailWidth) * thumbnailHeight);
+        Measure("thumbnail.render", pages, iterations, thumbnailPages, "pages", [&] {
+          for (int page = 0; page < thumbnailPages; page++) {
+            RenderThumbnail(indexed, page, thumbnailWidth, thumbnailHeight, &indexed->thumbnailScratch, thumbnail.data(),
+                            thumbnailWidth * 2);
+          }
+        });
+        for (int page = 0; page < thumbnailPages; page++) {
+          LoadThumbnail(indexed, directory, page, thumbnailWidth, thumbnailHeight, thumbnail.data(), thumbnailWidth * 2);
+        }
+        Measure("thumbnail.cached", pages, iterations, thumbnailPages, "pages", [&] {
+          for (int page = 0; page < thumbnailPages; page++) {
+            LoadThumbnail(indexed, directory, page, thumbnailWidth, thumbnailHeight, thumbnail.data(), thumbnailWidth * 2);
+          }
+        });
+        for (int page = 0; page < thumbnailPages; page++) {
+          char thumbnailName[64];
+          std::snprintf(thumbnailName, sizeof(thumbnailName), "/%016" PRIx64 "-%d-%dx%d.ppth", DocumentFingerprint(indexed),
+                        page, thumbnailWidth, thumbnailHeight);
+          unlink((std::string(directory) + thumbnailName).c_str());
+        }
+        CloseSession(indexed);
+        unlink(indexFile.c_str());
+      }
+      rmdir(directory);
+      close(fd);
+    }
+    if (!options.file && !file.empty()) unlink(file.c_str());
+  }
+
+  Measure("extract.cold", pages, coldIterations, pages, "pages", [&] {
+    session->textCache.reset();
+    for (int page = 0; page < pages; page++) GetPageText(session, page);
+  });
+
+  const int warmPages = std::min(pages, 32);
+  for (int page = 0; page < warmPages; page++) GetPageText(session, page);
+  Measure("extract.warm", pages, iterations, warmPages, "pages", [&] {
+    for (int page = 0; page < warmPages; page++) GetPageText(session, page);
+  });
+
+  // Cold pages are extracted one at a time (the text cache's extractMutex_),
+  // so extra workers gain here only by matching while another page extracts.
+  const int workerCounts[] = {1, options.workers};
+  for (int workers : workerCounts) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "search.cold.w%d", workers);
+    Measure(name, pages, coldIterations, pages, "pages", [&] {
+      session->textCache.reset();
+      SearchAll(session, "river", 0, workers);
+    });
+    if (options.workers == 1) break;
+  }
+
+  struct Query {
+    const char *name;
+    const char *text;
+    int flags;
+  };
+  const Query queries[] = {
+    {"common", "the", 0},
+    {"rare", kSyntheticRareWord, 0},
+    {"absent", "xylograph", 0},
+    {"folded", "cafe", 0},
+    {"case", "Papyrus", kMatchCase},
+    {"word", "in", kMatchWholeWord},
+    // The rare word misspelled, found within one and two edits.
+    {"edits1", "quixotik", 1 << kMatchEditsShift},
+    {"edits2", "qiuxotic", 2 << kMatchEditsShift},
+  };
+  for (const Query &query : queries) {
+    for (int workers : workerCounts) {
+      char name[64];
+      std::snprintf(name, sizeof(name), "search.%s.w%d", query.name, workers);
+      Measure(name, pages, iterations, pages, "pages", [&] { SearchAll(session, query.text, query.flags, workers); });
+      if (options.workers == 1) break;
+    }
+  }
+
+  // A 50-term glossary, a few terms of which occur: one pass per page
+  // against one search per term.
+  std::vector<std::vector<unsigned short>> glossary = {Wide("river"), Wide("archive"), Wide("cafe"), Wide(kSyntheticRareWord)};
+  while (glossary.size() < 50) {
+    char term[16];
+    std::snprintf(term, sizeof(term), "lemma%02zu", glossary.size());
+    glossary.push_back(Wide(term));
+  }
+  Measure("search.terms50.batch", pages, iterations, pages, "pages", [&] { SearchAllTerms(session, glossary, options.workers); });
+  Measure("search.terms50.each", pages, iterations, pages, "pages", [&] {
+    for (const std::vector<unsigned short> &term : glossary) {
+      std::string ascii(term.begin(), term.end());
+      SearchAll(session, ascii.c_str(), 0, options.workers);
+    }
+  });
+
+  uint64_t state = options.seed;
+  auto next = [&state] {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<double>(state >> 11) / static_cast<double>(1ull << 53);
+  };
+  const int selections = 100;
+  Measure("select.rect", pages, iterations, selections, "calls", [&] {
+    for (int i = 0; i < selections; i++) {
+      double y = next() * 0.8;
+      SelectText(session, i % warmPages, 0.1, y, 0.8, 0.15);
+    }
+  });
+  Measure("select.word", pages, iterations, selections, "calls", [&] {
+    for (int i = 0; i < selections; i++) SelectWordAt(session, i % warmPages, next(), next());
+  });
+  Measure("select.line", pages, iterations, selections, "calls", [&] {
+    for (int i = 0; i < selections; i++) SelectLineAt(session, i % warmPages, next(), next());
+  });
+
+  Measure("text.runs", pages, iterations, warmPages, "pages", [&] {
+    for (int page = 0; page < warmPages; page++) PackTextRuns(session, page);
+  });
+
+  Measure("outline.full", pages, iterations, 1, "ops", [&] { PackOutline(session); });
+  Measure("outline.root", pages, iterations, 1, "ops", [&] { PackOutlineChildren(session, 0); });
+
+  // Every page's size in one call, against loading each page to measure it as
+  // getPageDimensions does; then taps tested against the indexed links.
+  Measure("metadata.snapshot", pages, iterations, pages, "pages", [&] { PackPageMetadata(session); });
+  Measure("metadata.perpage", pages, coldIterations, pages, "pages", [&] {
+    double width = 0;
+    double height = 0;
+    for (int page = 0; page < pages; page++) PageSize(session, page, &width, &height);
+  });
+  Measure("links.hit", pages, iterations, selections, "calls", [&] {
+    for (int i = 0; i < selections; i++) PackLinkAt(session, i % warmPages, next(), next());
+  });
+
+  // The whole document's text, pulled chunk by chunk and written to a file;
+  // against extract.cold, which keeps every page with its glyph boxes.
+  Measure("export.chunks", pages, coldIterations, pages, "pages", [&] {
+    TextExport textExport(session, kExportPageMarkers, nullptr);
+    while (textExport.Next()) {
+    }
+  });
+  std::string exportFile = "/tmp/papyrus_export_" + std::to_string(getpid()) + ".txt";
+  Measure("export.file", pages, coldIterations, pages, "pages", [&] {
+    TextExport textExport(session, kExportPageMarkers, exportFile.c_str());
+    while (textExport.Write(16) > 0) {
+    }
+  });
+  unlink(exportFile.c_str());
+
+  // A 1080 px wide viewport: the whole page at zoom 1 and 4, against only the
+  // 256 px tiles a 1080x1920 viewport needs at zoom 4.
+  const int viewWidth = 1080;
+  const int viewHeight = 1920;
+  const int tile = 256;
+  const int renderPages = std::min(pages, 8);
+  std::vector<uint8_t> pixels;
+  for (int zoom : {1, 4}) {
+    int pageWidth = viewWidth * zoom;
+    int pageHeight = pageWidth * 792 / 612;
+    pixels.resize(static_cast<size_t>(pageWidth) * pageHeight * 4);
+    char name[64];
+    std::snprintf(name, sizeof(name), "render.page.z%d", zoom);
+    Measure(name, pages, iterations, renderPages, "pages", [&] {
+      for (int page = 0; page < renderPages; page++) {
+        RenderPageRegion(session, page, pageWidth, pageHeight, 0, 0, pixels.data(), pageWidth, pageHeight, pageWidth * 4);
+      }
+    });
+  }
+  {
+    int pageWidth = viewWidth * 4;
+    int pageHeight = pageWidth * 792 / 612;
+    int columns = (viewWidth + tile - 1) / tile;
+    int rows = (viewHeight + tile - 1) / tile;
+    pixels.resize(static_cast<size_t>(tile) * tile * 4);
+    Measure("render.viewport.z4", pages, iterations, renderPages * columns * rows, "tiles", [&] {
+      for (int page = 0; page < renderPages; page++) {
+        // The viewport sits in the middle of the zoomed page.
+        int left = (pageWidth - viewWidth) / 2;
+        int top = (pageHeight - viewHeight) / 2;
+        for (int row = 0; row < rows; row++) {
+          for (int column = 0; column < columns; column++) {
+            RenderPageRegion(session, page, pageWidth, pageHeight, left + column * tile, top + row * tile, pixels.data(),
+                             tile, tile, tile * 4);
+          }
+        }
+      }
+    });
+  }
+
+  CloseSession(session);
+  if (options.stats) PrintStats(stats);
+}
+
+// Deterministic checks of the hand-tuned kernels against naive references,
+// run by --check 1 (and ctest on host builds) before anything is timed.
+// Each prints one line and returns false on the first disagreement.
+
+using Units = std::vector<unsigned short>;
+
+Units RandomUnits(std::mt19937 &rng, int length, unsigned short first, int alphabet) {
+  Units units(length);
+  for (unsigned short &unit : units) unit = static_cast<unsigned short>(first + rng() % alphabet);
+  return units;
+}
+
+bool Report(const char *check, bool ok, const std::string &detail) {
+  if (ok) {
+    std::printf("check %-22s ok\n", check);
+  } else {
+    std::printf("check %-22s FAILED: %s\n", check, detail.c_str());
+  }
+  return ok;
+}
+
+bool CheckFindFolded(uint32_t seed) {
+  std::mt19937 rng(seed);
+  for (int trial = 0; trial < 4000; trial++) {
+    // Lengths past a few vector widths reach every unrolled path and tail.
+    Units haystack = RandomUnits(rng, rng() % 300, 'a', 2 + trial % 3);
+    Units needle = RandomUnits(rng, 1 + rng() % 6, 'a', 2 + trial % 3);
+    int from = haystack.empty() ? 0 : static_cast<int>(rng() % (haystack.size() + 1));
+    auto naive = std::search(haystack.begin() + from, haystack.end(), needle.begin(), needle.end());
+    int expected = naive == haystack.end() ? -1 : static_cast<int>(naive - haystack.begin());
+    int found = FindFolded(haystack.data(), static_cast<int>(haystack.size()), needle.data(),
+                           static_cast<int>(needle.size()), from);
+    if (found != expected) {
+      return Report("FindFolded", false, "trial " + std::to_string(trial) + ": " + std::to_string(found) +
+                                             " instead of " + std::to_string(expected));
+    }
+  }
+  return Report("FindFolded", true, "");
+}
+
+bool CheckTermMatcher(uint32_t seed) {
+  std::mt19937 rng(seed);
+  for (int trial = 0; trial < 600; trial++) {
+    // Two letters or a few thousand CJK units: the dense and sparse automatons.
+    bool sparse = trial % 4 == 3;
+    unsigned short first = sparse ? 0x4E00 : 'a';
+    int alphabet = sparse ? 3000 : 2 + trial % 3;
+    std::vector<Units> patterns(1 + rng() % (sparse ? 400 : 12));
+    for (Units &pattern : patterns) pattern = RandomUnits(rng, rng() % (sparse ? 3 : 5), first, alphabet);
+    // Random units with patterns spliced in, so that most patterns occur.
+    Units text;
+    while (text.size() < 400) {
+      if (rng() % 2) {
+        const Units &pattern = patterns[rng() % patterns.size()];
+        text.insert(text.end(), pattern.begin(), pattern.end());
+      } else {
+        text.push_back(static_cast<unsigned short>(first + rng() % alphabet));
+      }
+    }
+
+    std::vector<std::pair<int, int>> found;
+    TermMatcher matcher(patterns);
+    bool ordered = true;
+    matcher.Scan(text.data(), static_cast<int>(text.size()), [&](int pattern, int end) {
+      if (!found.empty()) {
+        const std::pair<int, int> &last = found.back();
+        ordered = ordered && (last.second < end ||
+                              (last.second == end && patterns[last.first].size() >= patterns[pattern].size()));
+      }
+      found.emplace_back(pattern, end);
+    });
+    std::vector<std::pair<int, int>> expected;
+    for (int end = 0; end < static_cast<int>(text.size()); end++) {
+      for (int pattern = 0; pattern < static_cast<int>(patterns.size()); pattern++) {
+        int length = static_cast<int>(patterns[pattern].size());
+        if (length > 0 && length <= end + 1 &&
+            std::equal(patterns[pattern].begin(), patterns[pattern].end(), text.begin() + end + 1 - length)) {
+          expected.emplace_back(pattern, end);
+        }
+      }
+    }
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    if (!ordered || found != expected) {
+      return Report("TermMatcher", false, "trial " + std::to_string(trial) + ": " + std::to_string(found.size()) +
+                                              " matches instead of " + std::to_string(expected.size()) +
+                                              (ordered ? "" : ", out of order"));
+    }
+  }
+  return Report("TermMatcher", true, "");
+}
+
+int EditDistance(const Units &pattern, const unsigned short *text, int length) {
+  std::vector<int> row(length + 1);
+  for (int j = 0; j <= length; j++) row[j] = j;
+  for (size_t i = 1; i <= pattern.size(); i++) {
+    int diagonal = row[0];
+    row[0] = static_cast<int>(i);
+    for (int j = 1; j <= length; j++) {
+      int above = row[j];
+      row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (pattern[i - 1] == text[j - 1] ? 0 : 1)});
+      diagonal = above;
+    }
+  }
+  return row[length];
+}
+
+bool CheckApproximateMatcher(uint32_t seed) {
+  std::mt19937 rng(seed);
+  for (int trial = 0; trial < 1500; trial++) {
+    int maxEdits = trial % (ApproximateMatcher::kMaxEdits + 1);
+    int patternLength = maxEdits + 1 + static_cast<int>(rng() % (trial % 10 == 0 ? 64 - maxEdits : 10));
+    Units pattern = RandomUnits(rng, patternLength, 'a', 3 + trial % 2);
+    Units text = RandomUnits(rng, rng() % 300, 'a', 3 + trial % 2);
+    // Plant a few edited copies of the pattern so there is something to find.
+    for (int copy = 0; copy < 3 && text.size() > pattern.size(); copy++) {
+      size_t at = rng() % (text.size() - pattern.size());
+      std::copy(pattern.begin(), pattern.end(), text.begin() + at);
+      for (int edit = rng() % (maxEdits + 1); edit > 0; edit--) text[at + rng() % pattern.size()] = 'a' + rng() % 4;
+    }
+    int length = static_cast<int>(text.size());
+
+    // best[j]: fewest edits of the pattern into any text span ending at j.
+    std::vector<int> best(length);
+    std::vector<int> column(patternLength + 1);
+    for (int i = 0; i <= patternLength; i++) column[i] = i;
+    for (int j = 0; j < length; j++) {
+      int diagonal = column[0];
+      column[0] = 0;
+      for (int i = 1; i <= patternLength; i++) {
+        int left = column[i];
+        column[i] = std::min({left + 1, column[i - 1] + 1, diagonal + (pattern[i - 1] == text[j] ? 0 : 1)});
+        diagonal = left;
+      }
+      best[j] = column[patternLength];
+    }
+
+    ApproximateMatcher matcher(pattern.data(), patternLength, maxEdits);
+    std::vector<ApproximateHit> hits;
+    matcher.Find(text.data(), length, &hits);
+    std::string problem;
+    for (size_t h = 0; h < hits.size() && problem.empty(); h++) {
+      const ApproximateHit &hit = hits[h];
+      if (hit.start < 0 || hit.start > hit.end || hit.end >= length) {
+        problem = "hit out of range";
+      } else if (h > 0 && hit.start <= hits[h - 1].end) {
+        problem = "hits overlap";
+      } else if (hit.distance > maxEdits || hit.distance != best[hit.end] ||
+                 EditDistance(pattern, text.data() + hit.start, hit.end - hit.start + 1) != hit.distance) {
+        problem = "hit at " + std::to_string(hit.start) + " has the wrong distance";
+      }
+    }
+    // Consecutive ends within reach make one hit, which stays unless it
+    // overlaps a hit kept before it or gives way to a closer one overlapping
+    // it, itself perhaps replaced in turn, each time by a closer hit.
+    for (int j = 0; j < length && problem.empty(); j++) {
+      if (best[j] > maxEdits) continue;
+      int last = j;
+      int closest = best[j];
+      while (last + 1 < length && best[last + 1] <= maxEdits) closest = std::min(closest, best[++last]);
+      int earliest = j - patternLength - maxEdits + 1;
+      int reach = last + closest * (patternLength + maxEdits);
+      bool covered = std::any_of(hits.begin(), hits.end(), [&](const ApproximateHit &hit) {
+        return hit.end >= earliest && (hit.start <= last || (hit.distance < closest && hit.start <= reach));
+      });
+      if (!covered) problem = "no hit near ends " + std::to_string(j) + " .. " + std::to_string(last);
+      j = last;
+    }
+    if (!problem.empty()) return Report("ApproximateMatcher", false, "trial " + std::to_string(trial) + ": " + problem);
+  }
+  return Report("ApproximateMatcher", true, "");
+}
+
+bool CheckThumbnailCodec(uint32_t seed) {
+  std::mt19937 rng(seed);
+  for (int trial = 0; trial < 500; trial++) {
+    int width = 1 + rng() % 70;
+    int height = 1 + rng() % 40;
+    int stride = (width + static_cast<int>(rng() % 3)) * 2;
+
+    // Downscale: every vector path and its scalar tail against the formula.
+    int sourceStride = width * 8 + static_cast<int>(rng() % 3) * 4;
+    std::vector<uint8_t> source(static_cast<size_t>(sourceStride) * height * 2);
+    for (uint8_t &byte : source) byte = static_cast<uint8_t>(rng());
+    std::vector<uint16_t> pixels(static_cast<size_t>(stride / 2) * height);
+    DownscaleToRgb565(source.data(), sourceStride, width, height, pixels.data(), stride);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t *top = source.data() + static_cast<size_t>(2 * y) * sourceStride + x * 8;
+        const uint8_t *bottom = top + sourceStride;
+        int channel[3];
+        for (int c = 0; c < 3; c++) channel[c] = (top[c] + top[c + 4] + bottom[c] + bottom[c + 4] + 2) / 4;
+        uint16_t expected = static_cast<uint16_t>((channel[0] >> 3) << 11 | (channel[1] >> 2) << 5 | channel[2] >> 3);
+        if (pixels[static_cast<size_t>(y) * (stride / 2) + x] != expected) {
+          return Report("thumbnail codec", false, "trial " + std::to_string(trial) + ": downscaled pixel (" +
+                                                      std::to_string(x) + ", " + std::to_string(y) + ") differs");
+        }
+      }
+    }
+
+    // Encode and decode: runs, literals and both mixed, through padded rows.
+    for (uint16_t &pixel : pixels) pixel = static_cast<uint16_t>(rng() % (trial % 3 == 0 ? 2 : 65536));
+    std::vector<uint8_t> payload;
+    EncodeThumbnail(pixels.data(), width, height, stride, &payload);
+    std::vector<uint16_t> decoded(pixels.size(), 0);
+    bool ok = DecodeThumbnail(payload.data(), payload.size(), decoded.data(), width, height, stride);
+    for (int y = 0; ok && y < height; y++) {
+      ok = std::equal(pixels.begin() + static_cast<size_t>(y) * (stride / 2),
+                      pixels.begin() + static_cast<size_t>(y) * (stride / 2) + width,
+                      decoded.begin() + static_cast<size_t>(y) * (stride / 2));
+    }
+    if (!ok || DecodeThumbnail(payload.data(), payload.size() - 1, decoded.data(), width, height, stride)) {
+      return Report("thumbnail codec", false, "trial " + std::to_string(trial) + ": round trip differs");
+    }
+  }
+  return Report("thumbnail codec", true, "");
+}
+
+void AppendUtf8(std::string *out, uint32_t code) {
+  if (code < 0x80) {
+    out->push_back(static_cast<char>(code));
+  } else if (code < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | code >> 6));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | code >> 12));
+    out->push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | code >> 18));
+    out->push_back(static_cast<char>(0x80 | (code >> 12 & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  }
+}
+
+bool CheckTextExport(uint32_t seed) {
+  // Enough pages to span several chunks.
+  PapyrusSession *session = OpenSession(SyntheticDocumentPath(60, seed).c_str());
+  if (!session) return Report("TextExport", false, "cannot open the synthetic document");
+  const PdfiumFns &fns = Pdfium();
+  std::string expected;
+  std::vector<int64_t> pageBytes;
+  for (int pageIndex = 0; pageIndex < session->pageCount; pageIndex++) {
+    pageBytes.push_back(static_cast<int64_t>(expected.size()));
+    FPDF_PAGE page = fns.loadPage(session->document, pageIndex);
+    FPDF_TEXTPAGE textPage = page ? fns.textLoadPage(page) : nullptr;
+    int count = textPage ? fns.textCountChars(textPage) : 0;
+    for (int i = 0; i < count; i++) {
+      unsigned int code = fns.textGetUnicode(textPage, i);
+      if (code == '\r' && i + 1 < count && fns.textGetUnicode(textPage, i + 1) == '\n') continue;
+      AppendUtf8(&expected, code);
+    }
+    if (textPage) fns.textClosePage(textPage);
+    if (page) fns.closePage(page);
+    expected.push_back('\f');
+  }
+
+  std::string exported;
+  TextExport textExport(session, kExportPageMarkers, nullptr);
+  while (textExport.Next()) {
+    exported.append(reinterpret_cast<const char *>(textExport.Chunk()), textExport.ChunkSize());
+  }
+  bool ok = exported == expected && textExport.PageBytes() == pageBytes &&
+            textExport.Bytes() == static_cast<int64_t>(expected.size());
+  CloseSession(session);
+  return Report("TextExport", ok, std::to_string(exported.size()) + " bytes instead of " + std::to_string(expected.size()));
+}
+
+bool RunChecks(uint32_t seed) {
+  bool ok = CheckFindFolded(seed);
+  ok = CheckTermMatcher(seed) && ok;
+  ok = CheckApproximateMatcher(seed) && ok;
+  ok = CheckThumbnailCodec(seed) && ok;
+  ok = CheckTextExport(seed) && ok;
+  return ok;
+}
+
+bool ParseOptions(int argc, char **argv, Options *options) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) return false;
+    if (std::strcmp(arg, "--pages") == 0) {
+      options->pageCounts.clear();
+      for (const char *at = value; *at;) {
+        char *end = nullptr;
+        long count = std::strtol(at, &end, 10);
+        if (end == at || count <= 0) return false;
+        options->pageCounts.push_back(static_cast<int>(count));
+        at = *end == ',' ? end + 1 : end;
+      }
+    } else if (std::strcmp(arg, "--iterations") == 0) {
+      options->iterations = std::max(1, std::atoi(value));
+    } else if (std::strcmp(arg, "--workers") == 0) {
+      options->workers = std::max(1, std::atoi(value));
+    } else if (std::strcmp(arg, "--seed") == 0) {
+      options->seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(arg, "--stats") == 0) {
+      options->stats = std::atoi(value) != 0;
+    } else if (std::strcmp(arg, "--check") == 0) {
+      options->check = std::atoi(value) != 0;
+    } else if (std::strcmp(arg, "--pdfium") == 0) {
+      options->pdfiumLibrary = value;
+    } else if (std::strcmp(arg, "--file") == 0) {
+      options->file = value;
+    } else {
+      return false;
+    }
+    i++;
+  }
+  return !options->pdfiumLibrary == !options->file;
+}
+
+// A standalone PDFium build needs FPDF_InitLibrary; on Android PdfiumCore
+// does that before the core runs.
+bool InstallRealPdfium(const char *path) {
+  void *library = dlopen(path, RTLD_NOW);
+  if (!library) {
+    std::fprintf(stderr, "papyrus_bench: %s\n", dlerror());
+    return false;
+  }
+  auto init = reinterpret_cast<void (*)()>(dlsym(library, "FPDF_InitLibrary"));
+  if (init) init();
+  return LoadPdfiumLibrary(path);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: papyrus_bench [--pages 10,100,1000] [--iterations N] [--workers N] [--seed S] [--stats 1]\n"
+                 "                     [--pdfium libpdfium.so --file doc.pdf] [--check 1]\n");
+    return 2;
+  }
+  if (options.workers == 0) {
+    options.workers = std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+  }
+
+  if (options.check) {
+    SetPdfium(StubPdfium());
+    return RunChecks(options.seed) ? 0 : 1;
+  }
+
+  PrintHeader();
+  if (options.pdfiumLibrary) {
+    if (!InstallRealPdfium(options.pdfiumLibrary)) return 1;
+    BenchDocument(options.file, options);
+    return 0;
+  }
+
+  SetPdfium(StubPdfium());
+  for (int pageCount : options.pageCounts) {
+    BenchDocument(SyntheticDocumentPath(pageCount, options.seed), options);
+  }
+  return 0;
+}
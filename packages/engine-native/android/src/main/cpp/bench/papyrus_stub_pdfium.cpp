@@ -0,0 +1,495 @@
+#include "papyrus_stub_pdfium.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr double kPageWidth = 612;
+constexpr double kPageHeight = 792;
+constexpr double kMargin = 72;
+constexpr double kFontSize = 10;
+constexpr double kLeading = 14;
+constexpr int kPagesPerChapter = 10;
+constexpr int kPagesPerSection = 2;
+// Pages labelled with roman numerals before arabic numbering starts at 1.
+constexpr int kFrontMatterPages = 4;
+// Every page links to others from the start of some lines, plus one URI in
+// the footer.
+constexpr int kLinesPerLink = 8;
+const char *const kSyntheticUri = "https://example.com/papyrus";
+
+const char *const kWords[] = {
+  "the", "of", "and", "to", "in", "a", "is", "that", "for", "it", "as", "was", "with", "be", "by",
+  "on", "not", "he", "this", "are", "or", "his", "from", "at", "which", "but", "have", "an", "had",
+  "they", "you", "were", "their", "one", "all", "we", "can", "her", "has", "there", "been", "if",
+  "more", "when", "will", "would", "who", "so", "no", "document", "papyrus", "Papyrus", "reader",
+  "page", "margin", "river", "archive", "scroll", "ink", "library", "engine", "render", "search",
+  "caf\xC3\xA9", "na\xC3\xAFve", "fa\xC3\xA7" "ade", "Stra\xC3\x9F" "e", "\xEF\xAC\x81" "nal", "r\xC3\xA9sum\xC3\xA9",
+};
+constexpr int kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+struct Bookmark {
+  std::vector<unsigned short> title;
+  int pageIndex;
+  int firstChild;
+  int nextSibling;
+};
+
+struct Document {
+  int pageCount;
+  uint32_t seed;
+  std::vector<Bookmark> bookmarks;
+};
+
+struct Link {
+  // The link's destination, a bookmark no outline reaches.
+  Bookmark target;
+  FS_RECTF rect;
+  bool uri;
+};
+
+struct Page {
+  std::vector<Link> links;
+  std::vector<unsigned short> text;
+  std::vector<double> left;
+  std::vector<double> right;
+  std::vector<double> top;
+  std::vector<double> bottom;
+  std::vector<uint8_t> hasBox;
+};
+
+uint64_t SplitMix(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// UTF-8 literal to UTF-16; the vocabulary stays inside the BMP.
+std::vector<unsigned short> Widen(const char *utf8) {
+  std::vector<unsigned short> out;
+  const unsigned char *at = reinterpret_cast<const unsigned char *>(utf8);
+  while (*at) {
+    unsigned int c = *at++;
+    if (c >= 0xE0) {
+      c = ((c & 0x0F) << 12) | ((at[0] & 0x3F) << 6) | (at[1] & 0x3F);
+      at += 2;
+    } else if (c >= 0xC0) {
+      c = ((c & 0x1F) << 6) | (at[0] & 0x3F);
+      at += 1;
+    }
+    out.push_back(static_cast<unsigned short>(c));
+  }
+  return out;
+}
+
+double Advance(unsigned short c) {
+  if (c == ' ' || c == 'i' || c == 'l' || c == 't' || c == 'f') return kFontSize * 0.3;
+  if (c == 'm' || c == 'w' || c == 'W' || c == 'M') return kFontSize * 0.78;
+  if (c >= 'A' && c <= 'Z') return kFontSize * 0.65;
+  return kFontSize * 0.5;
+}
+
+void Append(Page *page, unsigned short c, double x, double baseline, bool boxed) {
+  page->text.push_back(c);
+  page->left.push_back(x);
+  page->right.push_back(boxed ? x + Advance(c) : x);
+  page->top.push_back(boxed ? baseline + kFontSize * 0.72 : baseline);
+  page->bottom.push_back(boxed ? baseline - kFontSize * 0.22 : baseline);
+  page->hasBox.push_back(boxed ? 1 : 0);
+}
+
+Page *GeneratePage(const Document &doc, int pageIndex) {
+  static const std::vector<std::vector<unsigned short>> words = [] {
+    std::vector<std::vector<unsigned short>> all;
+    for (const char *word : kWords) all.push_back(Widen(word));
+    all.push_back(Widen(kSyntheticRareWord));
+    return all;
+  }();
+
+  uint64_t state = (static_cast<uint64_t>(doc.seed) << 32) ^ static_cast<uint64_t>(pageIndex) * 0x2545F4914F6CDD1Dull;
+  Page *page = new Page();
+  page->text.reserve(4096);
+  double baseline = kPageHeight - kMargin;
+  double x = kMargin;
+  bool lineStart = true;
+  int line = 0;
+  while (baseline > kMargin) {
+    uint64_t roll = SplitMix(&state);
+    const std::vector<unsigned short> &word = roll % 2000 == 0 ? words[kWordCount] : words[(roll >> 16) % kWordCount];
+    double width = 0;
+    for (unsigned short c : word) width += Advance(c);
+    if (!lineStart && x + Advance(' ') + width > kPageWidth - kMargin) {
+      Append(page, '\r', x, baseline, false);
+      Append(page, '\n', x, baseline, false);
+      baseline -= kLeading;
+      x = kMargin;
+      lineStart = true;
+      if (baseline <= kMargin) break;
+      if (++line % kLinesPerLink == kLinesPerLink / 2) {
+        int target = (pageIndex + 1 + line * 37) % doc.pageCount;
+        FS_RECTF rect = {static_cast<float>(kMargin), static_cast<float>(baseline + kFontSize * 0.78),
+                         static_cast<float>(kMargin + 60), static_cast<float>(baseline - kFontSize * 0.22)};
+        page->links.push_back({{{}, target, -1, -1}, rect, false});
+      }
+    }
+    if (!lineStart) {
+      Append(page, ' ', x, baseline, true);
+      x += Advance(' ');
+    }
+    for (unsigned short c : word) {
+      Append(page, c, x, baseline, true);
+      x += Advance(c);
+    }
+    lineStart = false;
+  }
+  FS_RECTF footer = {static_cast<float>(kMargin), static_cast<float>(kMargin / 2 + kFontSize),
+                     static_cast<float>(kPageWidth - kMargin), static_cast<float>(kMargin / 2)};
+  page->links.push_back({{{}, -1, -1, -1}, footer, true});
+  return page;
+}
+
+void BuildOutline(Document *doc) {
+  int chapters = (doc->pageCount + kPagesPerChapter - 1) / kPagesPerChapter;
+  doc->bookmarks.reserve(chapters * (1 + kPagesPerChapter / kPagesPerSection));
+  int previousChapter = -1;
+  for (int chapter = 0; chapter < chapters; chapter++) {
+    int firstPage = chapter * kPagesPerChapter;
+    char title[64];
+    std::snprintf(title, sizeof(title), "Chapter %d", chapter + 1);
+    int chapterIndex = static_cast<int>(doc->bookmarks.size());
+    doc->bookmarks.push_back({Widen(title), firstPage, -1, -1});
+    if (previousChapter >= 0) doc->bookmarks[previousChapter].nextSibling = chapterIndex;
+    previousChapter = chapterIndex;
+
+    int previousSection = -1;
+    for (int page = firstPage; page < doc->pageCount && page < firstPage + kPagesPerChapter; page += kPagesPerSection) {
+      std::snprintf(title, sizeof(title), "Section %d.%d", chapter + 1, (page - firstPage) / kPagesPerSection + 1);
+      int sectionIndex = static_cast<int>(doc->bookmarks.size());
+      doc->bookmarks.push_back({Widen(title), page, -1, -1});
+      if (previousSection >= 0) {
+        doc->bookmarks[previousSection].nextSibling = sectionIndex;
+      } else {
+        doc->bookmarks[chapterIndex].firstChild = sectionIndex;
+      }
+      previousSection = sectionIndex;
+    }
+  }
+}
+
+FPDF_DOCUMENT LoadDocument(const char *path, const char *) {
+  int pageCount = 0;
+  unsigned int seed = 0;
+  if (!path || std::sscanf(path, "synthetic:%d:%u", &pageCount, &seed) < 1 || pageCount <= 0) return nullptr;
+  Document *doc = new Document();
+  doc->pageCount = pageCount;
+  doc->seed = seed;
+  BuildOutline(doc);
+  return doc;
+}
+
+// The file holds the synthetic path itself.
+FPDF_DOCUMENT LoadCustomDocument(FPDF_FILEACCESS *access, const char *password) {
+  if (!access || access->m_FileLen == 0 || access->m_FileLen > 256) return nullptr;
+  std::string path(access->m_FileLen, '\0');
+  if (!access->m_GetBlock(access->m_Param, 0, reinterpret_cast<unsigned char *>(&path[0]), access->m_FileLen)) return nullptr;
+  return LoadDocument(path.c_str(), password);
+}
+
+// FPDFAvail over the same files. They are tiny, so the stand-in acts like a
+// linearized file whose first-page data is the whole file: the document is
+// available once every byte is, and then so is every page.
+struct Avail {
+  FX_FILEAVAIL *fileAvail;
+  FPDF_FILEACCESS *access;
+};
+
+FPDF_AVAIL AvailCreate(FX_FILEAVAIL *fileAvail, FPDF_FILEACCESS *access) {
+  if (!fileAvail || !access) return nullptr;
+  return new Avail{fileAvail, access};
+}
+
+void AvailDestroy(FPDF_AVAIL avail) {
+  delete static_cast<Avail *>(avail);
+}
+
+int AvailIsDocAvail(FPDF_AVAIL handle, FX_DOWNLOADHINTS *hints) {
+  Avail *avail = static_cast<Avail *>(handle);
+  size_t length = avail->access->m_FileLen;
+  if (avail->fileAvail->IsDataAvail(avail->fileAvail, 0, length)) return kPdfDataAvail;
+  if (hints) hints->AddSegment(hints, 0, length);
+  return kPdfDataNotAvail;
+}
+
+FPDF_DOCUMENT AvailGetDocument(FPDF_AVAIL handle, const char *password) {
+  return LoadCustomDocument(static_cast<Avail *>(handle)->access, password);
+}
+
+int AvailIsPageAvail(FPDF_AVAIL handle, int, FX_DOWNLOADHINTS *hints) {
+  return AvailIsDocAvail(handle, hints);
+}
+
+void CloseDocument(FPDF_DOCUMENT doc) {
+  delete static_cast<Document *>(doc);
+}
+
+int GetPageCount(FPDF_DOCUMENT doc) {
+  return static_cast<Document *>(doc)->pageCount;
+}
+
+FPDF_PAGE LoadPage(FPDF_DOCUMENT doc, int pageIndex) {
+  const Document *document = static_cast<Document *>(doc);
+  if (pageIndex < 0 || pageIndex >= document->pageCount) return nullptr;
+  return GeneratePage(*document, pageIndex);
+}
+
+void ClosePage(FPDF_PAGE page) {
+  delete static_cast<Page *>(page);
+}
+
+double GetPageWidth(FPDF_PAGE) {
+  return kPageWidth;
+}
+
+double GetPageHeight(FPDF_PAGE) {
+  return kPageHeight;
+}
+
+int GetPageSizeByIndex(FPDF_DOCUMENT doc, int pageIndex, double *width, double *height) {
+  if (pageIndex < 0 || pageIndex >= static_cast<Document *>(doc)->pageCount) return 0;
+  *width = kPageWidth;
+  *height = kPageHeight;
+  return 1;
+}
+
+unsigned long GetPageLabel(FPDF_DOCUMENT doc, int pageIndex, void *buffer, unsigned long length) {
+  static const char *const kRoman[kFrontMatterPages] = {"i", "ii", "iii", "iv"};
+  if (pageIndex < 0 || pageIndex >= static_cast<Document *>(doc)->pageCount) return 0;
+  char label[16];
+  if (pageIndex < kFrontMatterPages) {
+    std::snprintf(label, sizeof(label), "%s", kRoman[pageIndex]);
+  } else {
+    std::snprintf(label, sizeof(label), "%d", pageIndex - kFrontMatterPages + 1);
+  }
+  std::vector<unsigned short> units = Widen(label);
+  unsigned long bytes = (units.size() + 1) * sizeof(unsigned short);
+  if (buffer && length >= bytes) {
+    std::memcpy(buffer, units.data(), units.size() * sizeof(unsigned short));
+    static_cast<unsigned short *>(buffer)[units.size()] = 0;
+  }
+  return bytes;
+}
+
+int PageGetRotation(FPDF_PAGE) {
+  return 0;
+}
+
+FPDF_BOOL LinkEnumerate(FPDF_PAGE pageHandle, int *position, FPDF_LINK *link) {
+  Page *page = static_cast<Page *>(pageHandle);
+  if (*position < 0 || *position >= static_cast<int>(page->links.size())) return 0;
+  *link = &page->links[(*position)++];
+  return 1;
+}
+
+FPDF_BOOL LinkGetAnnotRect(FPDF_LINK link, FS_RECTF *rect) {
+  *rect = static_cast<Link *>(link)->rect;
+  return 1;
+}
+
+FPDF_DEST LinkGetDest(FPDF_DOCUMENT, FPDF_LINK link) {
+  Link *entry = static_cast<Link *>(link);
+  return entry->uri ? nullptr : &entry->target;
+}
+
+// A link's action is the link itself.
+FPDF_ACTION LinkGetAction(FPDF_LINK link) {
+  return static_cast<Link *>(link)->uri ? link : nullptr;
+}
+
+unsigned long ActionGetType(FPDF_ACTION action) {
+  return static_cast<Link *>(action)->uri ? kPdfActionUri : 0;
+}
+
+unsigned long ActionGetUriPath(FPDF_DOCUMENT, FPDF_ACTION, void *buffer, unsigned long length) {
+  unsigned long bytes = std::strlen(kSyntheticUri) + 1;
+  if (buffer && length >= bytes) std::memcpy(buffer, kSyntheticUri, bytes);
+  return bytes;
+}
+
+double TextGetFontSize(FPDF_TEXTPAGE, int) {
+  return kFontSize;
+}
+
+// The text page is the page itself; it is released with ClosePage.
+FPDF_TEXTPAGE TextLoadPage(FPDF_PAGE page) {
+  return page;
+}
+
+void TextClosePage(FPDF_TEXTPAGE) {}
+
+int TextCountChars(FPDF_TEXTPAGE textPage) {
+  return static_cast<int>(static_cast<Page *>(textPage)->text.size());
+}
+
+int TextGetCharBox(FPDF_TEXTPAGE textPage, int index, double *left, double *right, double *bottom, double *top) {
+  const Page *page = static_cast<Page *>(textPage);
+  if (index < 0 || index >= static_cast<int>(page->text.size())) return 0;
+  *left = page->left[index];
+  *right = page->right[index];
+  *bottom = page->bottom[index];
+  *top = page->top[index];
+  return page->hasBox[index];
+}
+
+int TextGetText(FPDF_TEXTPAGE textPage, int start, int count, unsigned short *out) {
+  const Page *page = static_cast<Page *>(textPage);
+  int total = static_cast<int>(page->text.size());
+  if (start < 0 || start > total || count < 0) return 0;
+  count = count < total - start ? count : total - start;
+  std::memcpy(out, page->text.data() + start, count * sizeof(unsigned short));
+  out[count] = 0;
+  return count + 1;
+}
+
+unsigned int TextGetUnicode(FPDF_TEXTPAGE textPage, int index) {
+  const Page *page = static_cast<Page *>(textPage);
+  return index >= 0 && index < static_cast<int>(page->text.size()) ? page->text[index] : 0;
+}
+
+FPDF_BOOKMARK BookmarkGetFirstChild(FPDF_DOCUMENT doc, FPDF_BOOKMARK bookmark) {
+  Document *document = static_cast<Document *>(doc);
+  if (document->bookmarks.empty()) return nullptr;
+  if (!bookmark) return &document->bookmarks[0];
+  int child = static_cast<Bookmark *>(bookmark)->firstChild;
+  return child >= 0 ? &document->bookmarks[child] : nullptr;
+}
+
+FPDF_BOOKMARK BookmarkGetNextSibling(FPDF_DOCUMENT doc, FPDF_BOOKMARK bookmark) {
+  Document *document = static_cast<Document *>(doc);
+  int sibling = bookmark ? static_cast<Bookmark *>(bookmark)->nextSibling : -1;
+  return sibling >= 0 ? &document->bookmarks[sibling] : nullptr;
+}
+
+unsigned long BookmarkGetTitle(FPDF_BOOKMARK bookmark, void *buffer, unsigned long length) {
+  const std::vector<unsigned short> &title = static_cast<Bookmark *>(bookmark)->title;
+  unsigned long bytes = (title.size() + 1) * sizeof(unsigned short);
+  if (buffer && length >= bytes) {
+    std::memcpy(buffer, title.data(), title.size() * sizeof(unsigned short));
+    static_cast<unsigned short *>(buffer)[title.size()] = 0;
+  }
+  return bytes;
+}
+
+// Destinations are the bookmarks themselves.
+FPDF_DEST BookmarkGetDest(FPDF_DOCUMENT, FPDF_BOOKMARK bookmark) {
+  return bookmark;
+}
+
+int DestGetPageIndex(FPDF_DOCUMENT, FPDF_DEST dest) {
+  return static_cast<Bookmark *>(dest)->pageIndex;
+}
+
+FPDF_BOOL DestGetLocationInPage(FPDF_DEST, FPDF_BOOL *hasX, FPDF_BOOL *hasY, FPDF_BOOL *hasZoom, float *x, float *y, float *) {
+  *hasX = 1;
+  *hasY = 1;
+  *hasZoom = 0;
+  *x = static_cast<float>(kMargin);
+  *y = static_cast<float>(kPageHeight - kMargin);
+  return 1;
+}
+
+struct Bitmap {
+  int width;
+  int height;
+  int stride;
+  uint8_t *pixels;
+};
+
+FPDF_BITMAP BitmapCreateEx(int width, int height, int, void *buffer, int stride) {
+  if (!buffer || width <= 0 || height <= 0) return nullptr;
+  return new Bitmap{width, height, stride, static_cast<uint8_t *>(buffer)};
+}
+
+void BitmapDestroy(FPDF_BITMAP bitmap) {
+  delete static_cast<Bitmap *>(bitmap);
+}
+
+// Paints every boxed glyph as a solid dark rectangle, mapped like PDFium maps
+// the page into (startX, startY, sizeX, sizeY) and clipped to the bitmap.
+void RenderPageBitmap(FPDF_BITMAP bitmap, FPDF_PAGE pageHandle, int startX, int startY, int sizeX, int sizeY, int, int) {
+  const Bitmap *target = static_cast<Bitmap *>(bitmap);
+  const Page *page = static_cast<Page *>(pageHandle);
+  double scaleX = sizeX / kPageWidth;
+  double scaleY = sizeY / kPageHeight;
+  for (size_t i = 0; i < page->text.size(); i++) {
+    if (!page->hasBox[i] || page->text[i] == ' ') continue;
+    int x0 = startX + static_cast<int>(page->left[i] * scaleX);
+    int x1 = startX + static_cast<int>(page->right[i] * scaleX);
+    int y0 = startY + static_cast<int>((kPageHeight - page->top[i]) * scaleY);
+    int y1 = startY + static_cast<int>((kPageHeight - page->bottom[i]) * scaleY);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > target->width) x1 = target->width;
+    if (y1 > target->height) y1 = target->height;
+    for (int y = y0; y < y1; y++) {
+      uint8_t *row = target->pixels + static_cast<size_t>(y) * target->stride;
+      for (int x = x0; x < x1; x++) {
+        row[x * 4] = 0x30;
+        row[x * 4 + 1] = 0x30;
+        row[x * 4 + 2] = 0x30;
+        row[x * 4 + 3] = 0xFF;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+PdfiumFns StubPdfium() {
+  PdfiumFns fns = {};
+  fns.loadDocument = LoadDocument;
+  fns.loadCustomDocument = LoadCustomDocument;
+  fns.closeDocument = CloseDocument;
+  fns.getDocPageCount = GetPageCount;
+  fns.loadPage = LoadPage;
+  fns.closePage = ClosePage;
+  fns.getPageWidth = GetPageWidth;
+  fns.getPageHeight = GetPageHeight;
+  fns.textLoadPage = TextLoadPage;
+  fns.textClosePage = TextClosePage;
+  fns.textGetCharBox = TextGetCharBox;
+  fns.textCountChars = TextCountChars;
+  fns.textGetText = TextGetText;
+  fns.textGetUnicode = TextGetUnicode;
+  fns.textGetFontSize = TextGetFontSize;
+  fns.bitmapCreateEx = BitmapCreateEx;
+  fns.bitmapDestroy = BitmapDestroy;
+  fns.renderPageBitmap = RenderPageBitmap;
+  fns.bookmarkGetFirstChild = BookmarkGetFirstChild;
+  fns.bookmarkGetNextSibling = BookmarkGetNextSibling;
+  fns.bookmarkGetTitle = BookmarkGetTitle;
+  fns.bookmarkGetDest = BookmarkGetDest;
+  fns.destGetPageIndex = DestGetPageIndex;
+  fns.destGetLocationInPage = DestGetLocationInPage;
+  fns.availCreate = AvailCreate;
+  fns.availDestroy = AvailDestroy;
+  fns.availIsDocAvail = AvailIsDocAvail;
+  fns.availGetDocument = AvailGetDocument;
+  fns.availIsPageAvail = AvailIsPageAvail;
+  fns.getPageSizeByIndex = GetPageSizeByIndex;
+  fns.getPageLabel = GetPageLabel;
+  fns.pageGetRotation = PageGetRotation;
+  fns.linkEnumerate = LinkEnumerate;
+  fns.linkGetAnnotRect = LinkGetAnnotRect;
+  fns.linkGetDest = LinkGetDest;
+  fns.linkGetAction = LinkGetAction;
+  fns.actionGetType = ActionGetType;
+  fns.actionGetUriPath = ActionGetUriPath;
+  return fns;
+}
+
+std::string SyntheticDocumentPath(int pageCount, uint32_t seed) {
+  return "synthetic:" + std::to_string(pageCount) + ":" + std::to_string(seed);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "papyrus_pdfium.h"
+
+// A PDFium stand-in serving generated documents, so the core can be built,
+// profiled and benchmarked on a host without a PDFium build. loadDocument
+// accepts paths from SyntheticDocumentPath, and loadCustomDocument and
+// FPDFAvail files whose content is such a path; every page's text, glyph
+// boxes and the outline are derived from (seed, pageIndex), so runs are
+// reproducible.
+//
+// Pages are US Letter with a single column of 10pt text, lines ending in a
+// box-less "\r\n" as PDFium reports them. The vocabulary mixes plain words
+// with accented ones, a ligature and a rare word (kSyntheticRareWord, about
+// one in 2000 words) so search exercises folding and early exits. The first
+// pages are labelled i .. iv, and every page carries a few links to other
+// pages and one URI link.
+PdfiumFns StubPdfium();
+
+std::string SyntheticDocumentPath(int pageCount, uint32_t seed);
+
+constexpr const char *kSyntheticRareWord = "quixotic";
@@ -0,0 +1,137 @@
+#include "papyrus_approx_match.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "papyrus_text_match.h"
+
+ApproximateMatcher::ApproximateMatcher(const unsigned short *pattern, int length, int maxEdits)
+    : pattern_(pattern, pattern + std::min(length, kMaxPatternLength)),
+      maxEdits_(std::max(0, std::min(maxEdits, kMaxEdits))),
+      classOf_(65536, 0),
+      peq_(1, 0) {
+  for (size_t i = 0; i < pattern_.size(); i++) {
+    uint8_t &inputClass = classOf_[pattern_[i]];
+    if (inputClass == 0) {
+      inputClass = static_cast<uint8_t>(peq_.size());
+      peq_.push_back(0);
+    }
+    peq_[inputClass] |= 1ull << i;
+  }
+}
+
+void ApproximateMatcher::Find(const unsigned short *text, int length, std::vector<ApproximateHit> *hits) const {
+  const int m = static_cast<int>(pattern_.size());
+  if (m == 0) return;
+  // A hit within k edits contains one of k + 1 pieces of the pattern
+  // verbatim, so the vectorized exact search finds every place one can be and
+  // the bit-parallel kernel only runs over the windows around those.
+  const int pieces = maxEdits_ + 1;
+  std::vector<std::pair<int, int>> windows;
+  for (int p = 0; p < pieces; p++) {
+    int pieceStart = m * p / pieces;
+    int pieceLength = m * (p + 1) / pieces - pieceStart;
+    if (pieceLength == 0) {
+      Scan(text, 0, length, hits);
+      return;
+    }
+    for (int at = FindFolded(text, length, pattern_.data() + pieceStart, pieceLength, 0); at >= 0;
+         at = FindFolded(text, length, pattern_.data() + pieceStart, pieceLength, at + 1)) {
+      windows.emplace_back(std::max(0, at - pieceStart - maxEdits_), std::min(length, at - pieceStart + m + maxEdits_));
+    }
+  }
+  std::sort(windows.begin(), windows.end());
+  int begin = -1;
+  int end = -1;
+  for (const auto &window : windows) {
+    if (window.first > end) {
+      if (begin >= 0) Scan(text, begin, end, hits);
+      begin = window.first;
+    }
+    end = std::max(end, window.second);
+  }
+  if (begin >= 0) Scan(text, begin, end, hits);
+}
+
+void ApproximateMatcher::Scan(const unsigned short *text, int begin, int end, std::vector<ApproximateHit> *hits) const {
+  const int m = static_cast<int>(pattern_.size());
+  const uint64_t last = 1ull << (m - 1);
+  // Vertical deltas of the distance column: +1 where pv, -1 where mv. The
+  // first row stays 0, so a hit may start anywhere.
+  uint64_t pv = ~0ull;
+  uint64_t mv = 0;
+  int score = m;
+  // The lowest end of the current run of ends within maxEdits, if any.
+  int bestEnd = -1;
+  int bestScore = 0;
+  // Ends of the last hit found and of the one before it.
+  int lastEnd = begin - 1;
+  int previousEnd = begin - 1;
+
+  // A hit overlapping the last one replaces it when closer, so a near miss
+  // just before an exact occurrence does not hide it.
+  auto emit = [&] {
+    int start = 0;
+    int distance = Align(text, begin, bestEnd, &start);
+    if (start > lastEnd) {
+      hits->push_back({start, bestEnd, distance});
+      previousEnd = lastEnd;
+      lastEnd = bestEnd;
+    } else if (distance < hits->back().distance && start > previousEnd) {
+      hits->back() = {start, bestEnd, distance};
+      lastEnd = bestEnd;
+    }
+    bestEnd = -1;
+  };
+
+  for (int j = begin; j < end; j++) {
+    uint64_t eq = peq_[classOf_[text[j]]];
+    uint64_t xv = eq | mv;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    if (ph & last) {
+      score++;
+    } else if (mh & last) {
+      score--;
+    }
+    ph <<= 1;
+    mh <<= 1;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+
+    // Exact hits right after one another (a one-unit pattern) are not one run.
+    if (bestEnd >= 0 && (score > bestScore || (score == 0 && bestScore == 0))) emit();
+    if (score <= maxEdits_ && (bestEnd < 0 || score < bestScore)) {
+      bestEnd = j;
+      bestScore = score;
+    }
+  }
+  if (bestEnd >= 0) emit();
+}
+
+int ApproximateMatcher::Align(const unsigned short *text, int begin, int end, int *start) const {
+  // Distances between pattern suffixes and the text ending at end, both read
+  // backwards: row i compares the last i pattern units with the last j units
+  // of the window.
+  const int m = static_cast<int>(pattern_.size());
+  const int window = std::min(end - begin + 1, m + maxEdits_);
+  int previous[kMaxPatternLength + 3] = {};
+  int current[kMaxPatternLength + 3];
+  for (int j = 0; j <= window; j++) previous[j] = j;
+  for (int i = 1; i <= m; i++) {
+    current[0] = i;
+    unsigned short unit = pattern_[m - i];
+    for (int j = 1; j <= window; j++) {
+      int substitute = previous[j - 1] + (text[end - j + 1] == unit ? 0 : 1);
+      current[j] = std::min({substitute, previous[j] + 1, current[j - 1] + 1});
+    }
+    std::copy(current, current + window + 1, previous);
+  }
+  int best = 1;
+  for (int j = 2; j <= window; j++) {
+    if (previous[j] < previous[best]) best = j;
+  }
+  *start = end - best + 1;
+  return previous[best];
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// An occurrence of a pattern within maxEdits insertions, deletions and
+// substitutions: text units [start, end], distance edits away.
+struct ApproximateHit {
+  int start;
+  int end;
+  int distance;
+};
+
+// Approximate matching of one folded pattern with Myers' bit-vector
+// algorithm: the edit distance column of the whole pattern lives in one
+// 64-bit word and advances by a handful of bitwise operations per text unit,
+// whatever the number of edits allowed. The start of each hit is recovered
+// afterwards with a small dynamic program over the pattern-sized window
+// before its end. Only the windows around exact occurrences of pieces of the
+// pattern are scanned at all, so a page without a near hit costs about as
+// much as an exact search. Immutable once built, so search workers share it.
+class ApproximateMatcher {
+ public:
+  // Patterns longer than this cannot be matched approximately.
+  static constexpr int kMaxPatternLength = 64;
+  static constexpr int kMaxEdits = 2;
+
+  // pattern is already folded, 1 .. kMaxPatternLength units; maxEdits is
+  // clamped to 0 .. kMaxEdits.
+  ApproximateMatcher(const unsigned short *pattern, int length, int maxEdits);
+
+  ApproximateMatcher(const ApproximateMatcher &) = delete;
+  ApproximateMatcher &operator=(const ApproximateMatcher &) = delete;
+
+  int MaxEdits() const { return maxEdits_; }
+
+  // Appends the hits in text, in order and without overlaps: of the ends
+  // within maxEdits that follow one another, the closest one, at its
+  // shortest alignment, and of overlapping hits the closest.
+  void Find(const unsigned short *text, int length, std::vector<ApproximateHit> *hits) const;
+
+ private:
+  // Find over text[begin, end) alone.
+  void Scan(const unsigned short *text, int begin, int end, std::vector<ApproximateHit> *hits) const;
+  // Edit distance of the pattern to text[start .. end] for the best start
+  // within reach of end but not before begin; sets *start.
+  int Align(const unsigned short *text, int begin, int end, int *start) const;
+
+  std::vector<unsigned short> pattern_;
+  int maxEdits_;
+  // Bit i of peq_[c] is set when pattern unit i is in class c; class 0 holds
+  // every unit absent from the pattern.
+  std::vector<uint8_t> classOf_;
+  std::vector<uint64_t> peq_;
+};
@@ -0,0 +1,209 @@
+#include "papyrus_glyph_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+constexpr int kMaxBands = 512;
+constexpr float kMinBandHeight = 4.0f;
+
+bool IsWordChar(unsigned short c) {
+  if (c < 0x80) {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || c == '\'';
+  }
+  if (c == 0x2019) return true;
+  if (c == 0xA0 || c == 0xAB || c == 0xBB || c == 0xD7 || c == 0xF7) return false;
+  if (c >= 0x2000 && c <= 0x206F) return false;
+  if (c >= 0x3000 && c <= 0x303F) return false;
+  if (c == 0xFEFF || c == 0xFFFD) return false;
+  return true;
+}
+
+static bool IsLineBreak(unsigned short c) {
+  return c == '\r' || c == '\n' || c == 0x2028 || c == 0x2029;
+}
+
+void GlyphIndex::Build(const unsigned short *text,
+                       const float *left,
+                       const float *right,
+                       const float *top,
+                       const float *bottom,
+                       const uint8_t *hasBox,
+                       int count) {
+  left_ = left;
+  right_ = right;
+  top_ = top;
+  bottom_ = bottom;
+  lines_.clear();
+
+  // Text order is reading order for almost every producer, so lines are cut
+  // in one pass: a new line starts on a break char, when the glyph shares
+  // less than half its height with the current band, or when it jumps far
+  // to the right of it (the next column on the same baseline).
+  bool open = false;
+  bool breakPending = false;
+  for (int i = 0; i < count; i++) {
+    if (IsLineBreak(text[i])) {
+      breakPending = true;
+      continue;
+    }
+    if (!hasBox[i] || right[i] < left[i] || top[i] < bottom[i]) continue;
+
+    if (open) {
+      GlyphLine &line = lines_.back();
+      float height = top[i] - bottom[i];
+      float lineHeight = line.top - line.bottom;
+      float overlap = std::min(top[i], line.top) - std::max(bottom[i], line.bottom);
+      float gap = left[i] - right[line.last];
+      bool sameBand = overlap >= 0.5f * std::min(height, lineHeight);
+      if (!breakPending && sameBand && gap <= 3.0f * std::max(height, lineHeight)) {
+        line.last = i;
+        line.left = std::min(line.left, left[i]);
+        line.right = std::max(line.right, right[i]);
+        line.top = std::max(line.top, top[i]);
+        line.bottom = std::min(line.bottom, bottom[i]);
+        continue;
+      }
+    }
+    lines_.push_back({i, i, left[i], right[i], top[i], bottom[i]});
+    open = true;
+    breakPending = false;
+  }
+
+  int lineCount = static_cast<int>(lines_.size());
+  lineGlyphs_.assign(lineCount + 1, 0);
+  byLeft_.clear();
+  sortedLeft_.clear();
+  maxWidth_.assign(lineCount, 0.0f);
+  for (int l = 0; l < lineCount; l++) {
+    const GlyphLine &line = lines_[l];
+    size_t begin = byLeft_.size();
+    for (int i = line.first; i <= line.last; i++) {
+      if (!hasBox[i] || right[i] < left[i] || top[i] < bottom[i]) continue;
+      byLeft_.push_back(i);
+      maxWidth_[l] = std::max(maxWidth_[l], right[i] - left[i]);
+    }
+    std::stable_sort(byLeft_.begin() + begin, byLeft_.end(), [left](int a, int b) { return left[a] < left[b]; });
+    for (size_t k = begin; k < byLeft_.size(); k++) {
+      sortedLeft_.push_back(left[byLeft_[k]]);
+    }
+    lineGlyphs_[l + 1] = static_cast<int>(byLeft_.size());
+  }
+
+  bandStart_.clear();
+  bandLines_.clear();
+  if (lineCount == 0) return;
+
+  float low = lines_[0].bottom;
+  float high = lines_[0].top;
+  std::vector<float> heights;
+  heights.reserve(lineCount);
+  for (const GlyphLine &line : lines_) {
+    low = std::min(low, line.bottom);
+    high = std::max(high, line.top);
+    heights.push_back(line.top - line.bottom);
+  }
+  std::nth_element(heights.begin(), heights.begin() + lineCount / 2, heights.end());
+  float span = std::max(high - low, 1.0f);
+  bandBase_ = low;
+  bandHeight_ = std::max({heights[lineCount / 2], kMinBandHeight, span / kMaxBands});
+  int bandCount = std::max(1, static_cast<int>(std::ceil(span / bandHeight_)));
+
+  // Counting pass, then fill, so the bands share one flat array.
+  bandStart_.assign(bandCount + 1, 0);
+  for (const GlyphLine &line : lines_) {
+    for (int b = BandOf(line.bottom), end = BandOf(line.top); b <= end; b++) {
+      bandStart_[b + 1]++;
+    }
+  }
+  std::partial_sum(bandStart_.begin(), bandStart_.end(), bandStart_.begin());
+  bandLines_.resize(bandStart_[bandCount]);
+  std::vector<int> fill(bandStart_.begin(), bandStart_.end() - 1);
+  for (int l = 0; l < lineCount; l++) {
+    for (int b = BandOf(lines_[l].bottom), end = BandOf(lines_[l].top); b <= end; b++) {
+      bandLines_[fill[b]++] = l;
+    }
+  }
+}
+
+int GlyphIndex::BandOf(float y) const {
+  int bands = static_cast<int>(bandStart_.size()) - 1;
+  int band = static_cast<int>(std::floor((y - bandBase_) / bandHeight_));
+  return std::max(0, std::min(bands - 1, band));
+}
+
+void GlyphIndex::LinesInBand(float bottom, float top, std::vector<int> *out) const {
+  out->clear();
+  if (lines_.empty() || top < bottom) return;
+  for (int b = BandOf(bottom), end = BandOf(top); b <= end; b++) {
+    for (int k = bandStart_[b]; k < bandStart_[b + 1]; k++) {
+      int l = bandLines_[k];
+      if (lines_[l].top >= bottom && lines_[l].bottom <= top) {
+        out->push_back(l);
+      }
+    }
+  }
+  std::sort(out->begin(), out->end());
+  out->erase(std::unique(out->begin(), out->end()), out->end());
+}
+
+int GlyphIndex::LineAt(float x, float y) const {
+  if (lines_.empty()) return -1;
+  float slack = bandHeight_ * 0.5f;
+  std::vector<int> candidates;
+  LinesInBand(y - slack, y + slack, &candidates);
+
+  int best = -1;
+  float bestDistance = 0;
+  for (int l : candidates) {
+    const GlyphLine &line = lines_[l];
+    float height = line.top - line.bottom;
+    float dx = x < line.left ? line.left - x : (x > line.right ? x - line.right : 0.0f);
+    float dy = y < line.bottom ? line.bottom - y : (y > line.top ? y - line.top : 0.0f);
+    if (dx > height || dy > height * 0.5f) continue;
+    float distance = dx + dy;
+    if (best < 0 || distance < bestDistance) {
+      best = l;
+      bestDistance = distance;
+    }
+  }
+  return best;
+}
+
+void GlyphIndex::GlyphsInRect(int line, float left, float right, float bottom, float top, std::vector<int> *out) const {
+  out->clear();
+  if (line < 0 || line >= static_cast<int>(lines_.size())) return;
+  auto begin = sortedLeft_.begin() + lineGlyphs_[line];
+  auto end = sortedLeft_.begin() + lineGlyphs_[line + 1];
+  // A glyph starting before left - maxWidth cannot reach left.
+  auto from = std::lower_bound(begin, end, left - maxWidth_[line]);
+  auto to = std::upper_bound(from, end, right);
+  for (auto it = from; it != to; ++it) {
+    int i = byLeft_[it - sortedLeft_.begin()];
+    if (right_[i] < left || top_[i] < bottom || bottom_[i] > top) continue;
+    out->push_back(i);
+  }
+  std::sort(out->begin(), out->end());
+}
+
+int GlyphIndex::GlyphNear(int line, float x) const {
+  if (line < 0 || line >= static_cast<int>(lines_.size())) return -1;
+  int begin = lineGlyphs_[line];
+  int end = lineGlyphs_[line + 1];
+  if (begin == end) return -1;
+
+  auto first = sortedLeft_.begin();
+  int from = static_cast<int>(std::lower_bound(first + begin, first + end, x - maxWidth_[line]) - first);
+  int to = static_cast<int>(std::upper_bound(first + from, first + end, x) - first);
+  for (int k = from; k < to; k++) {
+    int i = byLeft_[k];
+    if (right_[i] >= x) return i;
+  }
+
+  // In a gap or past either end: pick the closer of the neighbouring glyphs.
+  int before = to > begin ? byLeft_[to - 1] : -1;
+  int after = to < end ? byLeft_[to] : -1;
+  if (before < 0) return after;
+  if (after < 0) return before;
+  return x - right_[before] <= left_[after] - x ? before : after;
+}
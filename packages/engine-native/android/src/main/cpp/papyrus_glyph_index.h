@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A run of glyphs sharing one baseline band, in PDFium text order. first and
+// last are char indices of the first and last boxed glyph on the line; the
+// chars between them (including generated spaces) belong to the line.
+struct GlyphLine {
+  int first;
+  int last;
+  float left;
+  float right;
+  float top;
+  float bottom;
+};
+
+// Spatial index over the glyph boxes of one page, in PDF user space (y grows
+// upwards). Lines are kept in reading order and bucketed into fixed-height
+// horizontal bands; within a line, glyphs are sorted by left edge so x ranges
+// resolve with a binary search. Built once per page alongside its text; the
+// box arrays passed to Build must outlive the index and never reallocate.
+class GlyphIndex {
+ public:
+  void Build(const unsigned short *text,
+             const float *left,
+             const float *right,
+             const float *top,
+             const float *bottom,
+             const uint8_t *hasBox,
+             int count);
+
+  const std::vector<GlyphLine> &Lines() const { return lines_; }
+
+  // Lines whose vertical extent overlaps [bottom, top], in reading order.
+  void LinesInBand(float bottom, float top, std::vector<int> *out) const;
+
+  // Line closest to (x, y), allowing half a line height of slack around each
+  // line box. Returns -1 when nothing is near enough.
+  int LineAt(float x, float y) const;
+
+  // Boxed glyphs of a line that intersect the rectangle, in char order.
+  void GlyphsInRect(int line, float left, float right, float bottom, float top, std::vector<int> *out) const;
+
+  // Char index of the glyph on a line that contains x, or the nearest one.
+  int GlyphNear(int line, float x) const;
+
+  size_t Bytes() const {
+    return lines_.capacity() * sizeof(GlyphLine) +
+           (byLeft_.capacity() + lineGlyphs_.capacity() + bandStart_.capacity() + bandLines_.capacity()) * sizeof(int) +
+           (sortedLeft_.capacity() + maxWidth_.capacity()) * sizeof(float);
+  }
+
+ private:
+  int BandOf(float y) const;
+
+  const float *left_ = nullptr;
+  const float *right_ = nullptr;
+  const float *top_ = nullptr;
+  const float *bottom_ = nullptr;
+
+  std::vector<GlyphLine> lines_;
+  // Per line, its boxed glyphs sorted by left edge: byLeft_[lineGlyphs_[l] ..
+  // lineGlyphs_[l + 1]) with the matching left edges copied to sortedLeft_.
+  std::vector<int> lineGlyphs_;
+  std::vector<int> byLeft_;
+  std::vector<float> sortedLeft_;
+  std::vector<float> maxWidth_;
+
+  // Band b covers [bandBase_ + b * bandHeight_, bandBase_ + (b + 1) * bandHeight_)
+  // and lists its lines in bandLines_[bandStart_[b] .. bandStart_[b + 1]).
+  float bandBase_ = 0;
+  float bandHeight_ = 1;
+  std::vector<int> bandStart_;
+  std::vector<int> bandLines_;
+};
+
+// Word characters for tap-to-word: letters, digits, underscore and apostrophes.
+bool IsWordChar(unsigned short c);
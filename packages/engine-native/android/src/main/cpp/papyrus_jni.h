@@ -0,0 +1,19 @@
+#pragma once
+
+#include <jni.h>
+
+#include "papyrus_session.h"
+
+// Library every JNI entry point resolves PDFium from.
+constexpr const char *kPdfiumLibrary = "libmodpdfium.so";
+
+inline PapyrusSession *SessionFromHandle(jlong handle) {
+  return reinterpret_cast<PapyrusSession *>(handle);
+}
+
+// Wraps the session's packed buffer, just filled by a core call, in a direct
+// ByteBuffer without copying. The buffer stays valid until the next packed
+// result of the same session, so Java decodes it before releasing pdfiumLock.
+inline jobject PackedResult(JNIEnv *env, PapyrusSession *session) {
+  return env->NewDirectByteBuffer(session->packed.data(), static_cast<jlong>(session->packed.size()));
+}
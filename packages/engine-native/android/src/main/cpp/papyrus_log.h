@@ -0,0 +1,11 @@
+#pragma once
+
+// LOGE for the core sources, which also build on the host. Each file defines
+// LOG_TAG before including this header.
+#if defined(__ANDROID__)
+#include <android/log.h>
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGE(...) (std::fprintf(stderr, "%s: ", LOG_TAG), std::fprintf(stderr, __VA_ARGS__), std::fputc('\n', stderr))
+#endif
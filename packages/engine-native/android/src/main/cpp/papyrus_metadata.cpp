@@ -0,0 +1,195 @@
+#include "papyrus_metadata.h"
+
+#include "papyrus_packed.h"
+#include "papyrus_progressive.h"
+
+#include <algorithm>
+#include <utility>
+
+// Labels longer than this are cut; real ones are a few characters.
+constexpr int kMaxLabelUnits = 64;
+constexpr int kMaxUriBytes = 2048;
+// Malformed pages can carry any number of annotations.
+constexpr int kMaxPageLinks = 4096;
+
+static void AddPageLabel(PackedWriter &writer, FPDF_DOCUMENT doc, int pageIndex, int32_t *offset, int32_t *length) {
+  *offset = writer.AddString(nullptr, 0);
+  *length = 0;
+  unsigned short buffer[kMaxLabelUnits + 1];
+  unsigned long bytes = Pdfium().getPageLabel(doc, pageIndex, buffer, sizeof(buffer));
+  // The byte count includes the terminator, also when the label was too long
+  // to be copied at all.
+  if (bytes <= 2 || bytes > sizeof(buffer)) return;
+  int chars = static_cast<int>(bytes / 2) - 1;
+  *offset = writer.AddString(buffer, chars);
+  *length = chars;
+}
+
+void PackPageMetadata(PapyrusSession *session) {
+  const PdfiumFns &fns = Pdfium();
+  // Page dictionaries of a file still downloading may not have arrived, and
+  // asking PDFium for them would wait on the download.
+  bool readable = !session->avail || session->progressive->Complete();
+  PackedWriter writer(kPackedPageMetadata, 3);
+  for (int i = 0; i < session->pageCount; i++) {
+    double width = 0;
+    double height = 0;
+    int32_t labelOffset = writer.AddString(nullptr, 0);
+    int32_t labelLength = 0;
+    if (readable) {
+      if (fns.getPageSizeByIndex && !fns.getPageSizeByIndex(session->document, i, &width, &height)) {
+        width = 0;
+        height = 0;
+      }
+      if (fns.getPageLabel) AddPageLabel(writer, session->document, i, &labelOffset, &labelLength);
+    }
+    int rotation = static_cast<size_t>(i) < session->pageRotation.size() ? session->pageRotation[i] : -1;
+    writer.AddRect(0, 0, static_cast<float>(width), static_cast<float>(height));
+    writer.AddRecord({labelOffset, labelLength, rotation});
+  }
+  writer.Finish(&session->packed);
+}
+
+void NotePageRotation(PapyrusSession *session, int pageIndex, FPDF_PAGE page) {
+  if (!page || !Pdfium().pageGetRotation || pageIndex < 0 || pageIndex >= session->pageCount) return;
+  if (session->pageRotation.empty()) session->pageRotation.assign(session->pageCount, -1);
+  // FPDFPage_GetRotation counts clockwise quarter turns.
+  session->pageRotation[pageIndex] = static_cast<int16_t>((Pdfium().pageGetRotation(page) & 3) * 90);
+}
+
+PageLinks::PageLinks(std::vector<PageLink> links) : links_(std::move(links)), cellFirst_(kGridSize * kGridSize + 1, 0) {
+  auto cellRange = [](float from, float to, int *first, int *last) {
+    *first = std::max(0, std::min(kGridSize - 1, static_cast<int>(from * kGridSize)));
+    *last = std::max(0, std::min(kGridSize - 1, static_cast<int>(to * kGridSize)));
+  };
+  // Two passes: count the links of each cell, then fill them in.
+  for (int pass = 0; pass < 2; pass++) {
+    std::vector<int32_t> fill;
+    if (pass == 1) {
+      for (int c = 0; c < kGridSize * kGridSize; c++) cellFirst_[c + 1] += cellFirst_[c];
+      cellLinks_.resize(cellFirst_.back());
+      fill.assign(cellFirst_.begin(), cellFirst_.end() - 1);
+    }
+    for (int i = 0; i < static_cast<int>(links_.size()); i++) {
+      int column0, column1, row0, row1;
+      cellRange(links_[i].left, links_[i].right, &column0, &column1);
+      cellRange(links_[i].top, links_[i].bottom, &row0, &row1);
+      for (int row = row0; row <= row1; row++) {
+        for (int column = column0; column <= column1; column++) {
+          int cell = row * kGridSize + column;
+          if (pass == 0) {
+            cellFirst_[cell + 1]++;
+          } else {
+            cellLinks_[fill[cell]++] = i;
+          }
+        }
+      }
+    }
+  }
+}
+
+int PageLinks::At(float x, float y) const {
+  if (x < 0 || x > 1 || y < 0 || y > 1) return -1;
+  int column = std::min(kGridSize - 1, static_cast<int>(x * kGridSize));
+  int row = std::min(kGridSize - 1, static_cast<int>(y * kGridSize));
+  int cell = row * kGridSize + column;
+  // Later annotations are drawn over earlier ones.
+  for (int k = cellFirst_[cell + 1] - 1; k >= cellFirst_[cell]; k--) {
+    const PageLink &link = links_[cellLinks_[k]];
+    if (x >= link.left && x <= link.right && y >= link.top && y <= link.bottom) return cellLinks_[k];
+  }
+  return -1;
+}
+
+static int LinkTargetPage(FPDF_DOCUMENT doc, FPDF_LINK link, FPDF_ACTION action) {
+  const PdfiumFns &fns = Pdfium();
+  FPDF_DEST dest = fns.linkGetDest ? fns.linkGetDest(doc, link) : nullptr;
+  if (!dest && action && fns.actionGetType && fns.actionGetDest && fns.actionGetType(action) == kPdfActionGoTo) {
+    dest = fns.actionGetDest(doc, action);
+  }
+  return dest ? fns.destGetPageIndex(doc, dest) : -1;
+}
+
+static void ReadLinkUri(FPDF_DOCUMENT doc, FPDF_ACTION action, std::vector<unsigned short> *uri) {
+  const PdfiumFns &fns = Pdfium();
+  if (!action || !fns.actionGetType || !fns.actionGetUriPath || fns.actionGetType(action) != kPdfActionUri) return;
+  unsigned long bytes = fns.actionGetUriPath(doc, action, nullptr, 0);
+  if (bytes <= 1 || bytes > kMaxUriBytes) return;
+  std::vector<unsigned char> buffer(bytes, 0);
+  fns.actionGetUriPath(doc, action, buffer.data(), bytes);
+  uri->assign(buffer.begin(), buffer.end() - 1);
+}
+
+static std::vector<PageLink> ReadLinks(PapyrusSession *session, FPDF_PAGE page) {
+  const PdfiumFns &fns = Pdfium();
+  std::vector<PageLink> links;
+  double width = fns.getPageWidth(page);
+  double height = fns.getPageHeight(page);
+  if (width <= 0 || height <= 0) return links;
+
+  int position = 0;
+  FPDF_LINK link = nullptr;
+  while (static_cast<int>(links.size()) < kMaxPageLinks && fns.linkEnumerate(page, &position, &link)) {
+    FS_RECTF rect;
+    if (!link || !fns.linkGetAnnotRect(link, &rect)) continue;
+    FPDF_ACTION action = fns.linkGetAction ? fns.linkGetAction(link) : nullptr;
+    PageLink entry;
+    entry.left = static_cast<float>(std::min(rect.left, rect.right) / width);
+    entry.right = static_cast<float>(std::max(rect.left, rect.right) / width);
+    entry.top = static_cast<float>((height - std::max(rect.top, rect.bottom)) / height);
+    entry.bottom = static_cast<float>((height - std::min(rect.top, rect.bottom)) / height);
+    entry.targetPage = LinkTargetPage(session->document, link, action);
+    ReadLinkUri(session->document, action, &entry.uri);
+    if (entry.targetPage < 0 && entry.uri.empty()) continue;
+    links.push_back(std::move(entry));
+  }
+  return links;
+}
+
+std::shared_ptr<const PageLinks> GetPageLinks(PapyrusSession *session, int pageIndex) {
+  if (!session || !session->document || pageIndex < 0 || pageIndex >= session->pageCount) return nullptr;
+  auto cached = session->pageLinks.find(pageIndex);
+  if (cached != session->pageLinks.end()) return cached->second;
+  const PdfiumFns &fns = Pdfium();
+  if (!fns.linkEnumerate || !fns.linkGetAnnotRect || !PageDataReady(session, pageIndex)) return nullptr;
+
+  // The page being rendered is usually the one tapped.
+  bool borrowed = session->renderPage && session->renderPageIndex == pageIndex;
+  FPDF_PAGE page = borrowed ? session->renderPage : nullptr;
+  if (!page) {
+    StatScope timing(session->stats, kStatPageLoad);
+    page = fns.loadPage(session->document, pageIndex);
+  }
+  if (!page) return nullptr;
+  NotePageRotation(session, pageIndex, page);
+  auto links = std::make_shared<const PageLinks>(ReadLinks(session, page));
+  if (!borrowed) fns.closePage(page);
+  session->pageLinks.emplace(pageIndex, links);
+  return links;
+}
+
+static void AddLink(PackedWriter &writer, const PageLink &link) {
+  int32_t rect = writer.AddRect(link.left, link.top, link.right - link.left, link.bottom - link.top);
+  int32_t uriLength = static_cast<int32_t>(link.uri.size());
+  int32_t uriOffset = writer.AddString(link.uri.data(), uriLength);
+  writer.AddRecord({rect, link.targetPage, uriOffset, uriLength});
+}
+
+bool PackPageLinks(PapyrusSession *session, int pageIndex) {
+  std::shared_ptr<const PageLinks> links = GetPageLinks(session, pageIndex);
+  if (!links) return false;
+  PackedWriter writer(kPackedLinks, 4);
+  for (const PageLink &link : links->Links()) AddLink(writer, link);
+  writer.Finish(&session->packed);
+  return true;
+}
+
+bool PackLinkAt(PapyrusSession *session, int pageIndex, float x, float y) {
+  std::shared_ptr<const PageLinks> links = GetPageLinks(session, pageIndex);
+  if (!links) return false;
+  PackedWriter writer(kPackedLinks, 4);
+  int hit = links->At(x, y);
+  if (hit >= 0) AddLink(writer, links->Links()[hit]);
+  writer.Finish(&session->packed);
+  return true;
+}
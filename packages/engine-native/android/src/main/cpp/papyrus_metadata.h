@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "papyrus_session.h"
+
+// Everything a scroll view needs to lay out the whole document, for every
+// page at once (kPackedPageMetadata), without loading any page: sizes come
+// from FPDF_GetPageSizeByIndex, which only reads the page dictionary, and
+// labels from the catalog's /PageLabels. PDFium only reports /Rotate for a
+// loaded page, so rotations are those of the pages loaded so far; sizes
+// already have it applied. Pages of a progressive session still downloading
+// have no size or label yet.
+void PackPageMetadata(PapyrusSession *session);
+
+// Remembers page's /Rotate for the next metadata snapshot.
+void NotePageRotation(PapyrusSession *session, int pageIndex, FPDF_PAGE page);
+
+struct PageLink {
+  // Normalized to the page, y growing downwards.
+  float left;
+  float top;
+  float right;
+  float bottom;
+  // Page the link goes to within the document, or -1.
+  int targetPage;
+  // URI of links leaving the document, as its 7-bit bytes.
+  std::vector<unsigned short> uri;
+};
+
+// The links of one page with a uniform grid over them, so a tap is tested
+// against the few links of its cell instead of every link on the page.
+class PageLinks {
+ public:
+  explicit PageLinks(std::vector<PageLink> links);
+
+  const std::vector<PageLink> &Links() const { return links_; }
+
+  // Index of the topmost link containing the normalized point, or -1.
+  int At(float x, float y) const;
+
+ private:
+  static constexpr int kGridSize = 8;
+
+  std::vector<PageLink> links_;
+  // Links overlapping cell c, in page order: cellLinks_[cellFirst_[c] ..
+  // cellFirst_[c + 1]).
+  std::vector<int32_t> cellFirst_;
+  std::vector<int32_t> cellLinks_;
+};
+
+// The page's links, read from PDFium the first time and kept by the session
+// after that. Null for pages that cannot be loaded.
+std::shared_ptr<const PageLinks> GetPageLinks(PapyrusSession *session, int pageIndex);
+
+// Every link of the page as kPackedLinks.
+bool PackPageLinks(PapyrusSession *session, int pageIndex);
+
+// The link under a normalized point as kPackedLinks: one record, or none when
+// the point is not on a link.
+bool PackLinkAt(PapyrusSession *session, int pageIndex, float x, float y);
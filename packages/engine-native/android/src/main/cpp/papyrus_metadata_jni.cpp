@@ -0,0 +1,28 @@
+#include "papyrus_jni.h"
+#include "papyrus_metadata.h"
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusMetadata_nativeGetPageMetadata(JNIEnv *env, jclass, jlong sessionHandle) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !session->document) return nullptr;
+  PackPageMetadata(session);
+  return PackedResult(env, session);
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusMetadata_nativeGetPageLinks(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !PackPageLinks(session, pageIndex)) return nullptr;
+  return PackedResult(env, session);
+}
+
+// x and y are normalized to the page, y growing downwards.
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusMetadata_nativeGetLinkAt(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex, jfloat x, jfloat y) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !PackLinkAt(session, pageIndex, x, y)) return nullptr;
+  return PackedResult(env, session);
+}
@@ -1,139 +1,144 @@
-#include <jni.h>
-#include <android/log.h>
-#include <dlfcn.h>
+#include "papyrus_outline.h"
 
-#include <algorithm>
-#include <string>
+#include "papyrus_packed.h"
+
+#include <cmath>
+#include <unordered_set>
 #include <vector>
 
-#define LOG_TAG "PapyrusOutline"
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-
-typedef void *FPDF_DOCUMENT;
-typedef void *FPDF_BOOKMARK;
-typedef void *FPDF_DEST;
-
-struct PdfiumFns {
-  FPDF_DOCUMENT (*loadDocument)(const char *, const char *);
-  void (*closeDocument)(FPDF_DOCUMENT);
-  FPDF_BOOKMARK (*bookmarkGetFirstChild)(FPDF_DOCUMENT, FPDF_BOOKMARK);
-  FPDF_BOOKMARK (*bookmarkGetNextSibling)(FPDF_DOCUMENT, FPDF_BOOKMARK);
-  unsigned long (*bookmarkGetTitle)(FPDF_BOOKMARK, void *, unsigned long);
-  FPDF_DEST (*bookmarkGetDest)(FPDF_DOCUMENT, FPDF_BOOKMARK);
-  int (*destGetPageIndex)(FPDF_DOCUMENT, FPDF_DEST);
-};
-
-static void *g_pdfium = nullptr;
-static PdfiumFns g_fns = {};
-static bool g_loaded = false;
-
-static bool LoadPdfium() {
-  if (g_loaded) return g_pdfium != nullptr;
-
-  g_pdfium = dlopen("libmodpdfium.so", RTLD_LAZY);
-  if (!g_pdfium) {
-    LOGE("Failed to load libmodpdfium.so");
-    g_loaded = true;
-    return false;
-  }
+constexpr int kMaxOutlineDepth = 64;
+constexpr int kMaxOutlineItems = 20000;
 
-  g_fns.loadDocument = reinterpret_cast<FPDF_DOCUMENT (*)(const char *, const char *)>(dlsym(g_pdfium, "FPDF_LoadDocument"));
-  g_fns.closeDocument = reinterpret_cast<void (*)(FPDF_DOCUMENT)>(dlsym(g_pdfium, "FPDF_CloseDocument"));
-  g_fns.bookmarkGetFirstChild = reinterpret_cast<FPDF_BOOKMARK (*)(FPDF_DOCUMENT, FPDF_BOOKMARK)>(dlsym(g_pdfium, "FPDFBookmark_GetFirstChild"));
-  g_fns.bookmarkGetNextSibling = reinterpret_cast<FPDF_BOOKMARK (*)(FPDF_DOCUMENT, FPDF_BOOKMARK)>(dlsym(g_pdfium, "FPDFBookmark_GetNextSibling"));
-  g_fns.bookmarkGetTitle = reinterpret_cast<unsigned long (*)(FPDF_BOOKMARK, void *, unsigned long)>(dlsym(g_pdfium, "FPDFBookmark_GetTitle"));
-  g_fns.bookmarkGetDest = reinterpret_cast<FPDF_DEST (*)(FPDF_DOCUMENT, FPDF_BOOKMARK)>(dlsym(g_pdfium, "FPDFBookmark_GetDest"));
-  g_fns.destGetPageIndex = reinterpret_cast<int (*)(FPDF_DOCUMENT, FPDF_DEST)>(dlsym(g_pdfium, "FPDFDest_GetPageIndex"));
-
-  if (!g_fns.loadDocument || !g_fns.closeDocument || !g_fns.bookmarkGetFirstChild ||
-      !g_fns.bookmarkGetNextSibling || !g_fns.bookmarkGetTitle || !g_fns.bookmarkGetDest ||
-      !g_fns.destGetPageIndex) {
-    LOGE("Failed to load required PDFium symbols for outline");
-    g_loaded = true;
-    return false;
-  }
+// A bookmark either carries a destination or a GoTo action pointing at one.
+static FPDF_DEST BookmarkDest(FPDF_DOCUMENT doc, FPDF_BOOKMARK bookmark) {
+  FPDF_DEST dest = Pdfium().bookmarkGetDest(doc, bookmark);
+  if (dest || !Pdfium().bookmarkGetAction || !Pdfium().actionGetDest) return dest;
+  FPDF_ACTION action = Pdfium().bookmarkGetAction(bookmark);
+  return action ? Pdfium().actionGetDest(doc, action) : nullptr;
+}
 
-  g_loaded = true;
-  return true;
+static int BookmarkPageIndex(FPDF_DOCUMENT doc, FPDF_BOOKMARK bookmark) {
+  FPDF_DEST dest = BookmarkDest(doc, bookmark);
+  return dest ? Pdfium().destGetPageIndex(doc, dest) : -1;
 }
 
-static jstring GetBookmarkTitle(JNIEnv *env, FPDF_BOOKMARK bookmark) {
-  unsigned long length = g_fns.bookmarkGetTitle(bookmark, nullptr, 0);
-  if (length <= 2) {
-    return env->NewStringUTF("");
-  }
+static void AddBookmarkTitle(PackedWriter &writer, FPDF_BOOKMARK bookmark, int32_t *offset, int32_t *length) {
+  *offset = writer.AddString(nullptr, 0);
+  *length = 0;
+  unsigned long bytes = Pdfium().bookmarkGetTitle(bookmark, nullptr, 0);
+  if (bytes <= 2) return;
+
+  std::vector<unsigned short> buffer((bytes / 2) + 1, 0);
+  unsigned long written = Pdfium().bookmarkGetTitle(bookmark, buffer.data(), bytes);
+  int chars = written > 0 ? static_cast<int>(written / 2) - 1 : static_cast<int>(bytes / 2) - 1;
+  if (chars <= 0) return;
+  *offset = writer.AddString(buffer.data(), chars);
+  *length = chars;
+}
 
-  std::vector<unsigned short> buffer((length / 2) + 1, 0);
-  unsigned long written = g_fns.bookmarkGetTitle(bookmark, buffer.data(), length);
-  int chars = written > 0 ? static_cast<int>(written / 2) - 1 : static_cast<int>(length / 2) - 1;
-  if (chars <= 0) {
-    return env->NewStringUTF("");
+// Walks the bookmark tree iteratively in pre-order, one record per item with
+// its depth. Malformed files can nest arbitrarily deep or loop back to an
+// ancestor, so depth, item count and revisits are all bounded.
+static void WalkOutline(PackedWriter &writer, FPDF_DOCUMENT doc) {
+  struct Pending {
+    FPDF_BOOKMARK bookmark;
+    int depth;
+  };
+  std::vector<Pending> stack;
+  std::unordered_set<FPDF_BOOKMARK> visited;
+  FPDF_BOOKMARK first = Pdfium().bookmarkGetFirstChild(doc, nullptr);
+  if (first) stack.push_back({first, 0});
+
+  while (!stack.empty() && writer.RecordCount() < kMaxOutlineItems) {
+    Pending item = stack.back();
+    stack.pop_back();
+    if (!visited.insert(item.bookmark).second) continue;
+
+    int32_t titleOffset = 0;
+    int32_t titleLength = 0;
+    AddBookmarkTitle(writer, item.bookmark, &titleOffset, &titleLength);
+    writer.AddRecord({titleOffset, titleLength, BookmarkPageIndex(doc, item.bookmark), item.depth});
+
+    // The sibling goes below the first child so the subtree is emitted first.
+    FPDF_BOOKMARK sibling = Pdfium().bookmarkGetNextSibling(doc, item.bookmark);
+    if (sibling) stack.push_back({sibling, item.depth});
+    FPDF_BOOKMARK child = item.depth + 1 < kMaxOutlineDepth ? Pdfium().bookmarkGetFirstChild(doc, item.bookmark) : nullptr;
+    if (child) stack.push_back({child, item.depth + 1});
   }
-
-  return env->NewString(reinterpret_cast<const jchar *>(buffer.data()), chars);
 }
 
-static jobjectArray BuildOutlineItems(JNIEnv *env, FPDF_DOCUMENT doc, FPDF_BOOKMARK parent, jclass itemClass, jmethodID ctor) {
-  std::vector<jobject> items;
-
-  for (FPDF_BOOKMARK child = g_fns.bookmarkGetFirstChild(doc, parent); child;
-       child = g_fns.bookmarkGetNextSibling(doc, child)) {
-    jstring title = GetBookmarkTitle(env, child);
-    int pageIndex = -1;
-    FPDF_DEST dest = g_fns.bookmarkGetDest(doc, child);
-    if (dest) {
-      pageIndex = g_fns.destGetPageIndex(doc, dest);
-    }
-
-    jobjectArray children = BuildOutlineItems(env, doc, child, itemClass, ctor);
-    jobject item = env->NewObject(itemClass, ctor, title, pageIndex, children);
-
-    if (title) env->DeleteLocalRef(title);
-    if (children) env->DeleteLocalRef(children);
+static int NodeId(PapyrusSession *session, FPDF_BOOKMARK bookmark) {
+  auto found = session->outlineNodeIds.find(bookmark);
+  if (found != session->outlineNodeIds.end()) return found->second;
+  session->outlineNodes.push_back(bookmark);
+  int id = static_cast<int>(session->outlineNodes.size());
+  session->outlineNodeIds.emplace(bookmark, id);
+  return id;
+}
 
-    if (item) {
-      items.push_back(item);
-    }
+// Resolves an id from JS; false for ids this session never handed out.
+static bool NodeFromId(PapyrusSession *session, int id, FPDF_BOOKMARK *out) {
+  if (id == 0) {
+    *out = nullptr;
+    return true;
   }
+  if (id < 0 || id > static_cast<int>(session->outlineNodes.size())) return false;
+  *out = session->outlineNodes[id - 1];
+  return true;
+}
 
-  jobjectArray array = env->NewObjectArray(static_cast<jsize>(items.size()), itemClass, nullptr);
-  for (jsize i = 0; i < static_cast<jsize>(items.size()); i++) {
-    env->SetObjectArrayElement(array, i, items[i]);
+// One level of the outline: each child with its node id, whether it has
+// children of its own and its target page. Nothing below this level is read.
+static void WalkOutlineChildren(PackedWriter &writer, PapyrusSession *session, FPDF_BOOKMARK parent) {
+  FPDF_DOCUMENT doc = session->document;
+  std::unordered_set<FPDF_BOOKMARK> seen;
+  for (FPDF_BOOKMARK child = Pdfium().bookmarkGetFirstChild(doc, parent);
+       child && writer.RecordCount() < kMaxOutlineItems && seen.insert(child).second;
+       child = Pdfium().bookmarkGetNextSibling(doc, child)) {
+    int32_t titleOffset = 0;
+    int32_t titleLength = 0;
+    AddBookmarkTitle(writer, child, &titleOffset, &titleLength);
+    int32_t hasChildren = Pdfium().bookmarkGetFirstChild(doc, child) ? 1 : 0;
+    writer.AddRecord({titleOffset, titleLength, NodeId(session, child), hasChildren, BookmarkPageIndex(doc, child)});
   }
-
-  return array;
 }
 
-static jobjectArray BuildOutline(JNIEnv *env, FPDF_DOCUMENT doc) {
-  jclass itemClass = env->FindClass("com/papyrus/engine/PapyrusOutlineItem");
-  if (!itemClass) return nullptr;
-  jmethodID ctor = env->GetMethodID(itemClass, "<init>", "(Ljava/lang/String;I[Lcom/papyrus/engine/PapyrusOutlineItem;)V");
-  if (!ctor) return nullptr;
-  return BuildOutlineItems(env, doc, nullptr, itemClass, ctor);
+void PackOutline(PapyrusSession *session) {
+  PackedWriter writer(kPackedOutline, 4);
+  WalkOutline(writer, session->document);
+  writer.Finish(&session->packed);
 }
 
-extern "C" JNIEXPORT jobjectArray JNICALL
-Java_com_papyrus_engine_PapyrusOutline_nativeGetOutline(JNIEnv *env, jclass, jlong docPtr) {
-  if (!LoadPdfium()) return nullptr;
-  if (!docPtr) return nullptr;
-
-  FPDF_DOCUMENT doc = reinterpret_cast<FPDF_DOCUMENT>(docPtr);
-  return BuildOutline(env, doc);
+bool PackOutlineChildren(PapyrusSession *session, int parentId) {
+  FPDF_BOOKMARK parent = nullptr;
+  if (!NodeFromId(session, parentId, &parent)) return false;
+  PackedWriter writer(kPackedOutlineNodes, 5);
+  WalkOutlineChildren(writer, session, parent);
+  writer.Finish(&session->packed);
+  return true;
 }
 
-extern "C" JNIEXPORT jobjectArray JNICALL
-Java_com_papyrus_engine_PapyrusOutline_nativeGetOutlineFile(JNIEnv *env, jclass, jstring filePath) {
-  if (!LoadPdfium()) return nullptr;
-  if (!filePath) return nullptr;
-
-  const char *path = env->GetStringUTFChars(filePath, nullptr);
-  if (!path) return nullptr;
-
-  FPDF_DOCUMENT doc = g_fns.loadDocument(path, nullptr);
-  env->ReleaseStringUTFChars(filePath, path);
-  if (!doc) return nullptr;
-
-  jobjectArray result = BuildOutline(env, doc);
-  g_fns.closeDocument(doc);
-  return result;
+bool OutlineDestination(PapyrusSession *session, int nodeId, float out[4]) {
+  const PdfiumFns &fns = Pdfium();
+  FPDF_BOOKMARK bookmark = nullptr;
+  if (nodeId == 0 || !NodeFromId(session, nodeId, &bookmark)) return false;
+
+  FPDF_DEST dest = BookmarkDest(session->document, bookmark);
+  if (!dest) return false;
+  out[0] = static_cast<float>(fns.destGetPageIndex(session->document, dest));
+  out[1] = NAN;
+  out[2] = NAN;
+  out[3] = NAN;
+  FPDF_BOOL hasX = 0;
+  FPDF_BOOL hasY = 0;
+  FPDF_BOOL hasZoom = 0;
+  float x = 0;
+  float y = 0;
+  float zoom = 0;
+  if (fns.destGetLocationInPage && fns.destGetLocationInPage(dest, &hasX, &hasY, &hasZoom, &x, &y, &zoom)) {
+    if (hasX) out[1] = x;
+    if (hasY) out[2] = y;
+    if (hasZoom) out[3] = zoom;
+  }
+  return true;
 }
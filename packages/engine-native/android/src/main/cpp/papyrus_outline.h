@@ -0,0 +1,16 @@
+#pragma once
+
+#include "papyrus_session.h"
+
+// The whole bookmark tree, pre-order with depths (kPackedOutline), into the
+// session's packed buffer.
+void PackOutline(PapyrusSession *session);
+
+// One level below parentId (0 for the root) as kPackedOutlineNodes. False for
+// ids this session never handed out.
+bool PackOutlineChildren(PapyrusSession *session, int parentId);
+
+// {pageIndex, x, y, zoom} of a node's destination in PDF page coordinates;
+// components the destination leaves unspecified are NaN. False if the node
+// has no destination.
+bool OutlineDestination(PapyrusSession *session, int nodeId, float out[4]);
@@ -0,0 +1,33 @@
+#include "papyrus_jni.h"
+#include "papyrus_outline.h"
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusOutline_nativeGetOutline(JNIEnv *env, jclass, jlong sessionHandle) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !session->document) return nullptr;
+  PackOutline(session);
+  return PackedResult(env, session);
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusOutline_nativeGetOutlineChildren(JNIEnv *env, jclass, jlong sessionHandle, jint parentId) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !session->document || !PackOutlineChildren(session, parentId)) return nullptr;
+  return PackedResult(env, session);
+}
+
+// Returns {pageIndex, x, y, zoom} in PDF page coordinates; components the
+// destination leaves unspecified are NaN.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_papyrus_engine_PapyrusOutline_nativeGetOutlineDestination(JNIEnv *env, jclass, jlong sessionHandle, jint nodeId) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  jfloat values[4];
+  if (!session || !session->document || !OutlineDestination(session, nodeId, values)) return nullptr;
+
+  jfloatArray array = env->NewFloatArray(4);
+  if (array) env->SetFloatArrayRegion(array, 0, 4, values);
+  return array;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+// Results handed to Java as one direct ByteBuffer, in native byte order:
+//
+//   header   6 x int32   magic, kind, recordCount, fieldsPerRecord, rectCount, stringUnits
+//   records  recordCount x fieldsPerRecord x int32
+//   rects    rectCount x 4 x float32 (x, y, width, height, normalized to the page
+//            unless the kind says otherwise)
+//   strings  stringUnits x UTF-16 code unit
+//
+// Records point into the string pool with (offset, length) in code units and
+// into the rect table with (first, count). Record fields per kind:
+//
+//   kPackedSearchHits  pageIndex, matchIndex, textOffset, textLength, rectFirst, rectCount
+//                      [, patternIndex   (terms searches; -1 otherwise)
+//                      [, distance]]     (approximate searches only)
+//   kPackedSelection   textOffset, textLength, rectFirst, rectCount
+//   kPackedOutline     titleOffset, titleLength, pageIndex, depth   (pre-order)
+//   kPackedOutlineNodes  titleOffset, titleLength, nodeId, hasChildren, pageIndex
+//   kPackedTextRuns    textOffset, textLength, rectFirst, line, rtl
+//   kPackedPageMetadata  labelOffset, labelLength, rotation   (one per page)
+//   kPackedLinks       rectFirst, targetPage, uriOffset, uriLength
+//
+// A text run owns two rects: its normalized box, then (x, baseline, width,
+// fontSize) in page points with y growing upwards, as pdf.js text items use.
+// Page metadata rect i is (0, 0, width, height) of page i in points with
+// /Rotate applied, 0 x 0 while unknown; rotation is in degrees, -1 while
+// unknown. A link owns one normalized rect.
+//
+// Decoded by PapyrusPacked.java and by decodePackedSearchHits and
+// decodePackedPageMetadata in index.ts; keep the three in sync.
+constexpr int32_t kPackedMagic = 0x314B5050;  // "PPK1"
+constexpr int kPackedHeaderFields = 6;
+
+enum PackedKind : int32_t {
+  kPackedSearchHits = 1,
+  kPackedSelection = 2,
+  kPackedOutline = 3,
+  kPackedOutlineNodes = 4,
+  kPackedTextRuns = 5,
+  kPackedPageMetadata = 6,
+  kPackedLinks = 7,
+};
+
+class PackedWriter {
+ public:
+  PackedWriter(PackedKind kind, int fieldsPerRecord) : kind_(kind), fieldsPerRecord_(fieldsPerRecord) {}
+
+  int32_t AddString(const unsigned short *chars, int length) {
+    int32_t offset = static_cast<int32_t>(strings_.size());
+    if (length > 0) strings_.insert(strings_.end(), chars, chars + length);
+    return offset;
+  }
+
+  int32_t AddRect(float x, float y, float width, float height) {
+    int32_t index = static_cast<int32_t>(rects_.size() / 4);
+    rects_.insert(rects_.end(), {x, y, width, height});
+    return index;
+  }
+
+  void AddRecord(std::initializer_list<int32_t> fields) {
+    records_.insert(records_.end(), fields.begin(), fields.end());
+  }
+
+  int RecordCount() const { return static_cast<int>(records_.size()) / fieldsPerRecord_; }
+
+  int RectCount() const { return static_cast<int>(rects_.size()) / 4; }
+
+  // Serializes into out, reusing its capacity.
+  void Finish(std::vector<uint8_t> *out) const {
+    int32_t header[kPackedHeaderFields] = {
+      kPackedMagic,
+      kind_,
+      RecordCount(),
+      fieldsPerRecord_,
+      RectCount(),
+      static_cast<int32_t>(strings_.size()),
+    };
+    size_t recordBytes = records_.size() * sizeof(int32_t);
+    size_t rectBytes = rects_.size() * sizeof(float);
+    size_t stringBytes = strings_.size() * sizeof(unsigned short);
+    out->resize(sizeof(header) + recordBytes + rectBytes + stringBytes);
+
+    uint8_t *at = out->data();
+    std::memcpy(at, header, sizeof(header));
+    at += sizeof(header);
+    if (recordBytes) std::memcpy(at, records_.data(), recordBytes);
+    at += recordBytes;
+    if (rectBytes) std::memcpy(at, rects_.data(), rectBytes);
+    at += rectBytes;
+    if (stringBytes) std::memcpy(at, strings_.data(), stringBytes);
+  }
+
+ private:
+  PackedKind kind_;
+  int32_t fieldsPerRecord_;
+  std::vector<int32_t> records_;
+  std::vector<float> rects_;
+  std::vector<unsigned short> strings_;
+};
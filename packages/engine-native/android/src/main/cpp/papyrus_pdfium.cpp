@@ -0,0 +1,104 @@
+#include "papyrus_pdfium.h"
+
+#include <dlfcn.h>
+
+#include <atomic>
+#include <mutex>
+
+#define LOG_TAG "PapyrusPdfium"
+#include "papyrus_log.h"
+
+// Written once under g_installMutex, then only read: g_installed publishes it
+// to every thread that observes true.
+static PdfiumFns g_fns = {};
+static std::atomic<bool> g_installed{false};
+static std::mutex g_installMutex;
+static std::once_flag g_defaultLoad;
+
+template <typename Fn>
+static void Resolve(void *library, const char *name, Fn *out) {
+  *out = reinterpret_cast<Fn>(dlsym(library, name));
+}
+
+const PdfiumFns &Pdfium() {
+  return g_fns;
+}
+
+void SetPdfium(const PdfiumFns &fns) {
+  std::lock_guard<std::mutex> guard(g_installMutex);
+  g_fns = fns;
+  g_installed.store(true, std::memory_order_release);
+}
+
+bool LoadPdfiumLibrary(const char *path) {
+  void *library = dlopen(path, RTLD_NOW);
+  if (!library) {
+    LOGE("Failed to load %s", path);
+    return false;
+  }
+
+  PdfiumFns fns = {};
+  Resolve(library, "FPDF_LoadDocument", &fns.loadDocument);
+  Resolve(library, "FPDF_LoadCustomDocument", &fns.loadCustomDocument);
+  Resolve(library, "FPDF_CloseDocument", &fns.closeDocument);
+  Resolve(library, "FPDF_GetPageCount", &fns.getDocPageCount);
+  Resolve(library, "FPDF_LoadPage", &fns.loadPage);
+  Resolve(library, "FPDF_ClosePage", &fns.closePage);
+  Resolve(library, "FPDF_GetPageWidth", &fns.getPageWidth);
+  Resolve(library, "FPDF_GetPageHeight", &fns.getPageHeight);
+  Resolve(library, "FPDFText_LoadPage", &fns.textLoadPage);
+  Resolve(library, "FPDFText_ClosePage", &fns.textClosePage);
+  Resolve(library, "FPDFText_GetCharBox", &fns.textGetCharBox);
+  Resolve(library, "FPDFText_CountChars", &fns.textCountChars);
+  Resolve(library, "FPDFText_GetText", &fns.textGetText);
+  Resolve(library, "FPDFText_GetUnicode", &fns.textGetUnicode);
+  Resolve(library, "FPDFBitmap_CreateEx", &fns.bitmapCreateEx);
+  Resolve(library, "FPDFBitmap_Destroy", &fns.bitmapDestroy);
+  Resolve(library, "FPDF_RenderPageBitmap", &fns.renderPageBitmap);
+  Resolve(library, "FPDFBookmark_GetFirstChild", &fns.bookmarkGetFirstChild);
+  Resolve(library, "FPDFBookmark_GetNextSibling", &fns.bookmarkGetNextSibling);
+  Resolve(library, "FPDFBookmark_GetTitle", &fns.bookmarkGetTitle);
+  Resolve(library, "FPDFBookmark_GetDest", &fns.bookmarkGetDest);
+  Resolve(library, "FPDFDest_GetPageIndex", &fns.destGetPageIndex);
+  Resolve(library, "FPDFBookmark_GetAction", &fns.bookmarkGetAction);
+  Resolve(library, "FPDFAction_GetDest", &fns.actionGetDest);
+  Resolve(library, "FPDFDest_GetLocationInPage", &fns.destGetLocationInPage);
+  Resolve(library, "FPDFText_GetFontSize", &fns.textGetFontSize);
+  Resolve(library, "FPDFAvail_Create", &fns.availCreate);
+  Resolve(library, "FPDFAvail_Destroy", &fns.availDestroy);
+  Resolve(library, "FPDFAvail_IsDocAvail", &fns.availIsDocAvail);
+  Resolve(library, "FPDFAvail_GetDocument", &fns.availGetDocument);
+  Resolve(library, "FPDFAvail_IsPageAvail", &fns.availIsPageAvail);
+  Resolve(library, "FPDF_GetPageSizeByIndex", &fns.getPageSizeByIndex);
+  Resolve(library, "FPDF_GetPageLabel", &fns.getPageLabel);
+  Resolve(library, "FPDFPage_GetRotation", &fns.pageGetRotation);
+  Resolve(library, "FPDFLink_Enumerate", &fns.linkEnumerate);
+  Resolve(library, "FPDFLink_GetAnnotRect", &fns.linkGetAnnotRect);
+  Resolve(library, "FPDFLink_GetDest", &fns.linkGetDest);
+  Resolve(library, "FPDFLink_GetAction", &fns.linkGetAction);
+  Resolve(library, "FPDFAction_GetType", &fns.actionGetType);
+  Resolve(library, "FPDFAction_GetURIPath", &fns.actionGetUriPath);
+
+  if (!fns.loadDocument || !fns.loadCustomDocument || !fns.closeDocument || !fns.getDocPageCount ||
+      !fns.loadPage || !fns.closePage || !fns.getPageWidth || !fns.getPageHeight ||
+      !fns.textLoadPage || !fns.textClosePage || !fns.textGetCharBox ||
+      !fns.textCountChars || !fns.textGetText || !fns.textGetUnicode ||
+      !fns.bitmapCreateEx || !fns.bitmapDestroy || !fns.renderPageBitmap ||
+      !fns.bookmarkGetFirstChild || !fns.bookmarkGetNextSibling || !fns.bookmarkGetTitle ||
+      !fns.bookmarkGetDest || !fns.destGetPageIndex) {
+    LOGE("Failed to load required PDFium symbols from %s", path);
+    dlclose(library);
+    return false;
+  }
+
+  SetPdfium(fns);
+  return true;
+}
+
+bool EnsurePdfium(const char *defaultLibrary) {
+  if (g_installed.load(std::memory_order_acquire)) return true;
+  std::call_once(g_defaultLoad, [defaultLibrary] {
+    if (!g_installed.load(std::memory_order_acquire)) LoadPdfiumLibrary(defaultLibrary);
+  });
+  return g_installed.load(std::memory_order_acquire);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+// The PDFium entry points the core uses, resolved once into a table shared by
+// every module. On Android the table is filled from libmodpdfium.so; host
+// builds may install another PDFium build or the synthetic stub in bench/
+// instead. Resolution is thread-safe: concurrent first callers of
+// EnsurePdfium wait for a single dlopen.
+
+#include <cstddef>
+
+typedef void *FPDF_DOCUMENT;
+typedef void *FPDF_PAGE;
+typedef void *FPDF_TEXTPAGE;
+typedef void *FPDF_BOOKMARK;
+typedef void *FPDF_DEST;
+typedef void *FPDF_ACTION;
+typedef void *FPDF_BITMAP;
+typedef void *FPDF_AVAIL;
+typedef void *FPDF_LINK;
+typedef int FPDF_BOOL;
+
+// fpdfview.h: random access to the document bytes for FPDF_LoadCustomDocument.
+// m_GetBlock copies size bytes at position into buf and returns nonzero on
+// success.
+struct FPDF_FILEACCESS {
+  unsigned long m_FileLen;
+  int (*m_GetBlock)(void *param, unsigned long position, unsigned char *buf, unsigned long size);
+  void *m_Param;
+};
+
+// fpdf_dataavail.h: how FPDFAvail asks which byte ranges have arrived
+// (IsDataAvail) and which it needs next (AddSegment). Both structs have
+// version 1.
+struct FX_FILEAVAIL {
+  int version;
+  FPDF_BOOL (*IsDataAvail)(FX_FILEAVAIL *self, size_t offset, size_t size);
+};
+
+struct FX_DOWNLOADHINTS {
+  int version;
+  void (*AddSegment)(FX_DOWNLOADHINTS *self, size_t offset, size_t size);
+};
+
+// fpdf_doc.h: a link annotation's rect in page coordinates (top > bottom).
+struct FS_RECTF {
+  float left;
+  float top;
+  float right;
+  float bottom;
+};
+
+// FPDFAction_GetType results the core follows.
+constexpr unsigned long kPdfActionGoTo = 1;
+constexpr unsigned long kPdfActionUri = 3;
+
+// FPDFAvail_IsDocAvail / FPDFAvail_IsPageAvail results.
+constexpr int kPdfDataError = -1;
+constexpr int kPdfDataNotAvail = 0;
+constexpr int kPdfDataAvail = 1;
+
+struct PdfiumFns {
+  FPDF_DOCUMENT (*loadDocument)(const char *, const char *);
+  FPDF_DOCUMENT (*loadCustomDocument)(FPDF_FILEACCESS *, const char *);
+  void (*closeDocument)(FPDF_DOCUMENT);
+  int (*getDocPageCount)(FPDF_DOCUMENT);
+
+  FPDF_PAGE (*loadPage)(FPDF_DOCUMENT, int);
+  void (*closePage)(FPDF_PAGE);
+  double (*getPageWidth)(FPDF_PAGE);
+  double (*getPageHeight)(FPDF_PAGE);
+  FPDF_TEXTPAGE (*textLoadPage)(FPDF_PAGE);
+  void (*textClosePage)(FPDF_TEXTPAGE);
+  int (*textGetCharBox)(FPDF_TEXTPAGE, int, double *, double *, double *, double *);
+  int (*textCountChars)(FPDF_TEXTPAGE);
+  int (*textGetText)(FPDF_TEXTPAGE, int, int, unsigned short *);
+  unsigned int (*textGetUnicode)(FPDF_TEXTPAGE, int);
+
+  FPDF_BITMAP (*bitmapCreateEx)(int, int, int, void *, int);
+  void (*bitmapDestroy)(FPDF_BITMAP);
+  void (*renderPageBitmap)(FPDF_BITMAP, FPDF_PAGE, int, int, int, int, int, int);
+
+  FPDF_BOOKMARK (*bookmarkGetFirstChild)(FPDF_DOCUMENT, FPDF_BOOKMARK);
+  FPDF_BOOKMARK (*bookmarkGetNextSibling)(FPDF_DOCUMENT, FPDF_BOOKMARK);
+  unsigned long (*bookmarkGetTitle)(FPDF_BOOKMARK, void *, unsigned long);
+  FPDF_DEST (*bookmarkGetDest)(FPDF_DOCUMENT, FPDF_BOOKMARK);
+  int (*destGetPageIndex)(FPDF_DOCUMENT, FPDF_DEST);
+  // Optional: missing from older PDFium builds.
+  FPDF_ACTION (*bookmarkGetAction)(FPDF_BOOKMARK);
+  FPDF_DEST (*actionGetDest)(FPDF_DOCUMENT, FPDF_ACTION);
+  FPDF_BOOL (*destGetLocationInPage)(FPDF_DEST, FPDF_BOOL *, FPDF_BOOL *, FPDF_BOOL *, float *, float *, float *);
+  double (*textGetFontSize)(FPDF_TEXTPAGE, int);
+  // Optional: progressive loading (papyrus_progressive.h).
+  FPDF_AVAIL (*availCreate)(FX_FILEAVAIL *, FPDF_FILEACCESS *);
+  void (*availDestroy)(FPDF_AVAIL);
+  int (*availIsDocAvail)(FPDF_AVAIL, FX_DOWNLOADHINTS *);
+  FPDF_DOCUMENT (*availGetDocument)(FPDF_AVAIL, const char *);
+  int (*availIsPageAvail)(FPDF_AVAIL, int, FX_DOWNLOADHINTS *);
+  // Optional: page metadata and links (papyrus_metadata.h).
+  int (*getPageSizeByIndex)(FPDF_DOCUMENT, int, double *, double *);
+  unsigned long (*getPageLabel)(FPDF_DOCUMENT, int, void *, unsigned long);
+  int (*pageGetRotation)(FPDF_PAGE);
+  FPDF_BOOL (*linkEnumerate)(FPDF_PAGE, int *, FPDF_LINK *);
+  FPDF_BOOL (*linkGetAnnotRect)(FPDF_LINK, FS_RECTF *);
+  FPDF_DEST (*linkGetDest)(FPDF_DOCUMENT, FPDF_LINK);
+  FPDF_ACTION (*linkGetAction)(FPDF_LINK);
+  unsigned long (*actionGetType)(FPDF_ACTION);
+  unsigned long (*actionGetUriPath)(FPDF_DOCUMENT, FPDF_ACTION, void *, unsigned long);
+};
+
+// The installed table. Only valid after EnsurePdfium returned true.
+const PdfiumFns &Pdfium();
+
+// Installs fns as the table, replacing whatever was loaded before. Meant to be
+// called before any document is opened.
+void SetPdfium(const PdfiumFns &fns);
+
+// Resolves the table from the shared library at path. False if the library or
+// one of the required symbols is missing.
+bool LoadPdfiumLibrary(const char *path);
+
+// True once a table is installed. The first call without one loads
+// defaultLibrary; a failed load is not retried. Cheap after the first call.
+bool EnsurePdfium(const char *defaultLibrary);
@@ -0,0 +1,151 @@
+#include "papyrus_progressive.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#define LOG_TAG "PapyrusProgressive"
+#include "papyrus_log.h"
+
+std::shared_ptr<ProgressiveSource> ProgressiveSource::Create(int fd, int64_t length) {
+  if (fd < 0 || length <= 0) return nullptr;
+  int owned = dup(fd);
+  if (owned < 0) {
+    LOGE("Failed to duplicate fd %d", fd);
+    return nullptr;
+  }
+  return std::shared_ptr<ProgressiveSource>(new ProgressiveSource(owned, length));
+}
+
+ProgressiveSource::ProgressiveSource(int fd, int64_t length) : fd_(fd), length_(length) {
+  access_.m_FileLen = static_cast<unsigned long>(length);
+  access_.m_GetBlock = GetBlock;
+  access_.m_Param = this;
+  fileAvail_.version = 1;
+  fileAvail_.IsDataAvail = IsDataAvail;
+  fileAvail_.owner = this;
+  hints_.version = 1;
+  hints_.AddSegment = AddSegment;
+  hints_.owner = this;
+}
+
+ProgressiveSource::~ProgressiveSource() {
+  close(fd_);
+}
+
+void ProgressiveSource::MarkReceived(int64_t offset, int64_t size) {
+  int64_t start = std::max<int64_t>(0, offset);
+  int64_t end = std::min(length_, offset + size);
+  if (start >= end) return;
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  // Absorb every range that overlaps or touches [start, end).
+  auto it = received_.upper_bound(start);
+  if (it != received_.begin() && std::prev(it)->second >= start) --it;
+  while (it != received_.end() && it->first <= end) {
+    start = std::min(start, it->first);
+    end = std::max(end, it->second);
+    receivedBytes_ -= it->second - it->first;
+    it = received_.erase(it);
+  }
+  received_.emplace(start, end);
+  receivedBytes_ += end - start;
+}
+
+bool ProgressiveSource::IsReceived(int64_t offset, int64_t size) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return IsReceivedLocked(offset, size);
+}
+
+bool ProgressiveSource::IsReceivedLocked(int64_t offset, int64_t size) const {
+  if (offset < 0 || size < 0 || offset + size > length_) return false;
+  if (size == 0) return true;
+  auto it = received_.upper_bound(offset);
+  if (it == received_.begin()) return false;
+  --it;
+  return it->second >= offset + size;
+}
+
+bool ProgressiveSource::Complete() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return receivedBytes_ >= length_;
+}
+
+void ProgressiveSource::TakeRequests(std::vector<std::pair<int64_t, int64_t>> *out) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::sort(requests_.begin(), requests_.end());
+  for (const auto &request : requests_) {
+    if (IsReceivedLocked(request.first, request.second)) continue;
+    int64_t end = request.first + request.second;
+    if (!out->empty() && out->back().first + out->back().second >= request.first) {
+      out->back().second = std::max(out->back().first + out->back().second, end) - out->back().first;
+    } else {
+      out->emplace_back(request.first, request.second);
+    }
+  }
+  requests_.clear();
+}
+
+int ProgressiveSource::GetBlock(void *param, unsigned long position, unsigned char *buf, unsigned long size) {
+  ProgressiveSource *source = static_cast<ProgressiveSource *>(param);
+  if (!source->IsReceived(static_cast<int64_t>(position), static_cast<int64_t>(size))) return 0;
+  size_t done = 0;
+  while (done < size) {
+    ssize_t read = pread(source->fd_, buf + done, size - done, static_cast<off_t>(position + done));
+    if (read < 0 && errno == EINTR) continue;
+    if (read <= 0) return 0;
+    done += static_cast<size_t>(read);
+  }
+  return 1;
+}
+
+FPDF_BOOL ProgressiveSource::IsDataAvail(FX_FILEAVAIL *self, size_t offset, size_t size) {
+  ProgressiveSource *source = static_cast<FileAvailCallbacks *>(self)->owner;
+  return source->IsReceived(static_cast<int64_t>(offset), static_cast<int64_t>(size)) ? 1 : 0;
+}
+
+void ProgressiveSource::AddSegment(FX_DOWNLOADHINTS *self, size_t offset, size_t size) {
+  ProgressiveSource *source = static_cast<HintCallbacks *>(self)->owner;
+  int64_t start = static_cast<int64_t>(offset);
+  int64_t length = std::min(static_cast<int64_t>(size), source->length_ - start);
+  if (start < 0 || length <= 0) return;
+  std::lock_guard<std::mutex> guard(source->mutex_);
+  source->requests_.emplace_back(start, length);
+}
+
+PapyrusSession *OpenProgressiveSession(std::shared_ptr<ProgressiveSource> source) {
+  const PdfiumFns &fns = Pdfium();
+  if (!source || !fns.availCreate || !fns.availDestroy || !fns.availIsDocAvail || !fns.availGetDocument ||
+      !fns.availIsPageAvail) {
+    return nullptr;
+  }
+  FPDF_AVAIL avail = fns.availCreate(source->FileAvail(), source->Access());
+  if (!avail) return nullptr;
+  PapyrusSession *session = new PapyrusSession();
+  session->avail = avail;
+  session->progressive = std::move(source);
+  return session;
+}
+
+int PollProgressiveDocument(PapyrusSession *session) {
+  if (!session) return kPdfDataError;
+  if (session->document) return kPdfDataAvail;
+  if (!session->avail) return kPdfDataError;
+  const PdfiumFns &fns = Pdfium();
+  int status = fns.availIsDocAvail(session->avail, session->progressive->Hints());
+  if (status != kPdfDataAvail) return status == kPdfDataNotAvail ? kPdfDataNotAvail : kPdfDataError;
+
+  StatScope timing(session->stats, kStatPageLoad);
+  session->document = fns.availGetDocument(session->avail, nullptr);
+  if (!session->document) return kPdfDataError;
+  session->pageCount = fns.getDocPageCount(session->document);
+  return kPdfDataAvail;
+}
+
+bool PageDataReady(PapyrusSession *session, int pageIndex) {
+  if (!session || !session->avail) return true;
+  if (!session->document) return false;
+  if (session->progressive->Complete()) return true;
+  return Pdfium().availIsPageAvail(session->avail, pageIndex, session->progressive->Hints()) == kPdfDataAvail;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "papyrus_pdfium.h"
+#include "papyrus_session.h"
+
+// A document that is still downloading. The downloader writes bytes into a
+// file of the final size, in any order, and reports each range it wrote.
+// PDFium reads that file through FPDFAvail, which only touches ranges reported
+// so far and names the ranges it needs next; those are kept as requests for
+// the downloader to fetch ahead of the sequential stream. Ranges are reported
+// from the download thread while the engine thread reads, so all state is
+// guarded by one mutex.
+class ProgressiveSource {
+ public:
+  // Reads fd, which will hold length bytes once the download completes. fd is
+  // duplicated, so the caller may close it. nullptr if it cannot be, or
+  // length <= 0.
+  static std::shared_ptr<ProgressiveSource> Create(int fd, int64_t length);
+
+  ~ProgressiveSource();
+
+  ProgressiveSource(const ProgressiveSource &) = delete;
+  ProgressiveSource &operator=(const ProgressiveSource &) = delete;
+
+  int64_t Length() const { return length_; }
+
+  // Records that [offset, offset + size) has been written to the file.
+  void MarkReceived(int64_t offset, int64_t size);
+  bool IsReceived(int64_t offset, int64_t size);
+  // True once every byte has been received.
+  bool Complete();
+
+  // Moves the ranges PDFium asked for that have not arrived yet into out as
+  // (offset, size) pairs, merged and in file order.
+  void TakeRequests(std::vector<std::pair<int64_t, int64_t>> *out);
+
+  FPDF_FILEACCESS *Access() { return &access_; }
+  FX_FILEAVAIL *FileAvail() { return &fileAvail_; }
+  FX_DOWNLOADHINTS *Hints() { return &hints_; }
+
+ private:
+  struct FileAvailCallbacks : FX_FILEAVAIL {
+    ProgressiveSource *owner;
+  };
+  struct HintCallbacks : FX_DOWNLOADHINTS {
+    ProgressiveSource *owner;
+  };
+
+  ProgressiveSource(int fd, int64_t length);
+
+  bool IsReceivedLocked(int64_t offset, int64_t size) const;
+
+  static int GetBlock(void *param, unsigned long position, unsigned char *buf, unsigned long size);
+  static FPDF_BOOL IsDataAvail(FX_FILEAVAIL *self, size_t offset, size_t size);
+  static void AddSegment(FX_DOWNLOADHINTS *self, size_t offset, size_t size);
+
+  const int fd_;
+  const int64_t length_;
+  std::mutex mutex_;
+  // Received ranges as start -> end, disjoint and never adjacent.
+  std::map<int64_t, int64_t> received_;
+  int64_t receivedBytes_ = 0;
+  std::vector<std::pair<int64_t, int64_t>> requests_;
+  FPDF_FILEACCESS access_;
+  FileAvailCallbacks fileAvail_;
+  HintCallbacks hints_;
+};
+
+// Opens a session over a source that may still be downloading. No document is
+// loaded yet (pageCount is 0) until PollProgressiveDocument succeeds. nullptr
+// if this PDFium build lacks FPDFAvail.
+PapyrusSession *OpenProgressiveSession(std::shared_ptr<ProgressiveSource> source);
+
+// Loads the document once the data it needs has arrived: for a linearized
+// file, the first page and the cross-reference data, otherwise the whole
+// file. Returns kPdfDataAvail once the document is loaded, kPdfDataNotAvail
+// while waiting (the missing ranges are recorded as requests) and
+// kPdfDataError if the bytes are not a readable PDF.
+int PollProgressiveDocument(PapyrusSession *session);
+
+// True if pageIndex can be read without touching missing data; otherwise the
+// missing ranges are recorded as requests. Always true for sessions that were
+// not opened progressively, and once their download completes.
+bool PageDataReady(PapyrusSession *session, int pageIndex);
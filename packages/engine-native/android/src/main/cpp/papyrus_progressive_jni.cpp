@@ -0,0 +1,89 @@
+#include "papyrus_jni.h"
+#include "papyrus_progressive.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Java holds a source through a heap-allocated shared_ptr, so the download
+// thread can keep reporting ranges after the session that reads it closed.
+static std::shared_ptr<ProgressiveSource> *SourceFromHandle(jlong handle) {
+  return reinterpret_cast<std::shared_ptr<ProgressiveSource> *>(handle);
+}
+
+// Whether the loaded PDFium build has the FPDFAvail entry points.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativeIsSupported(JNIEnv *, jclass) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return JNI_FALSE;
+  const PdfiumFns &fns = Pdfium();
+  return fns.availCreate && fns.availDestroy && fns.availIsDocAvail && fns.availGetDocument && fns.availIsPageAvail
+             ? JNI_TRUE
+             : JNI_FALSE;
+}
+
+// fd will hold length bytes once downloaded; it may be closed once this
+// returns.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativeSourceCreate(JNIEnv *, jclass, jint fd, jlong length) {
+  std::shared_ptr<ProgressiveSource> source = ProgressiveSource::Create(fd, length);
+  if (!source) return 0;
+  return reinterpret_cast<jlong>(new std::shared_ptr<ProgressiveSource>(std::move(source)));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativeSourceReceived(JNIEnv *, jclass, jlong handle, jlong offset, jlong length) {
+  std::shared_ptr<ProgressiveSource> *source = SourceFromHandle(handle);
+  if (source) (*source)->MarkReceived(offset, length);
+}
+
+// The ranges PDFium asked for since the last call as {offset, length, ...},
+// or null if there are none.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativeSourceTakeRequests(JNIEnv *env, jclass, jlong handle) {
+  std::shared_ptr<ProgressiveSource> *source = SourceFromHandle(handle);
+  if (!source) return nullptr;
+  std::vector<std::pair<int64_t, int64_t>> requests;
+  (*source)->TakeRequests(&requests);
+  if (requests.empty()) return nullptr;
+
+  std::vector<jlong> values;
+  values.reserve(requests.size() * 2);
+  for (const auto &request : requests) {
+    values.push_back(request.first);
+    values.push_back(request.second);
+  }
+  jlongArray array = env->NewLongArray(static_cast<jsize>(values.size()));
+  if (array) env->SetLongArrayRegion(array, 0, static_cast<jsize>(values.size()), values.data());
+  return array;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativeSourceRelease(JNIEnv *, jclass, jlong handle) {
+  delete SourceFromHandle(handle);
+}
+
+// A session over the source with no document yet; see nativePollDocument.
+// Closed with PapyrusDocumentSession.nativeClose.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativeOpen(JNIEnv *, jclass, jlong sourceHandle, jlong statsHandle) {
+  std::shared_ptr<ProgressiveSource> *source = SourceFromHandle(sourceHandle);
+  if (!source || !EnsurePdfium(kPdfiumLibrary)) return 0;
+  PapyrusSession *session = OpenProgressiveSession(*source);
+  if (session) session->stats = reinterpret_cast<PapyrusStats *>(statsHandle);
+  return reinterpret_cast<jlong>(session);
+}
+
+// 1 once the document is loaded, 0 while waiting for data, -1 on error.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativePollDocument(JNIEnv *, jclass, jlong handle) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return kPdfDataError;
+  return PollProgressiveDocument(SessionFromHandle(handle));
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_papyrus_engine_PapyrusProgressive_nativeIsPageReady(JNIEnv *, jclass, jlong handle, jint pageIndex) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return JNI_FALSE;
+  PapyrusSession *session = SessionFromHandle(handle);
+  if (!session || !session->document || pageIndex < 0 || pageIndex >= session->pageCount) return JNI_FALSE;
+  return PageDataReady(session, pageIndex) ? JNI_TRUE : JNI_FALSE;
+}
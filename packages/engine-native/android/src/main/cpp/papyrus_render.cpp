@@ -0,0 +1,60 @@
+#include "papyrus_render.h"
+
+#include "papyrus_metadata.h"
+#include "papyrus_progressive.h"
+
+#include <cstring>
+
+// fpdfview.h
+constexpr int kFpdfBitmapBgra = 4;
+constexpr int kFpdfAnnot = 0x01;
+constexpr int kFpdfReverseByteOrder = 0x10;
+
+static FPDF_PAGE RenderPage(PapyrusSession *session, int pageIndex) {
+  if (session->renderPage && session->renderPageIndex == pageIndex) return session->renderPage;
+  if (!PageDataReady(session, pageIndex)) return nullptr;
+  const PdfiumFns &fns = Pdfium();
+  if (session->renderPage) {
+    fns.closePage(session->renderPage);
+    session->renderPage = nullptr;
+    session->renderPageIndex = -1;
+  }
+  StatScope timing(session->stats, kStatPageLoad);
+  session->renderPage = fns.loadPage(session->document, pageIndex);
+  if (session->renderPage) session->renderPageIndex = pageIndex;
+  NotePageRotation(session, pageIndex, session->renderPage);
+  return session->renderPage;
+}
+
+bool RenderPageRegion(PapyrusSession *session, int pageIndex, int pageWidth, int pageHeight, int left, int top,
+                      uint8_t *pixels, int width, int height, int stride) {
+  if (!session || !session->document || pageIndex < 0 || pageIndex >= session->pageCount) return false;
+  if (!pixels || width <= 0 || height <= 0 || stride < width * 4 || pageWidth <= 0 || pageHeight <= 0) return false;
+  FPDF_PAGE page = RenderPage(session, pageIndex);
+  if (!page) return false;
+
+  for (int row = 0; row < height; row++) {
+    std::memset(pixels + static_cast<size_t>(row) * stride, 0xFF, static_cast<size_t>(width) * 4);
+  }
+
+  const PdfiumFns &fns = Pdfium();
+  FPDF_BITMAP bitmap = fns.bitmapCreateEx(width, height, kFpdfBitmapBgra, pixels, stride);
+  if (!bitmap) return false;
+  {
+    // PDFium clips to the bitmap, so offsetting the page by (-left, -top)
+    // rasterizes just this region.
+    StatScope timing(session->stats, kStatRender);
+    fns.renderPageBitmap(bitmap, page, -left, -top, pageWidth, pageHeight, 0, kFpdfAnnot | kFpdfReverseByteOrder);
+  }
+  fns.bitmapDestroy(bitmap);
+  return true;
+}
+
+bool PageSize(PapyrusSession *session, int pageIndex, double *width, double *height) {
+  if (!session || !session->document || pageIndex < 0 || pageIndex >= session->pageCount) return false;
+  FPDF_PAGE page = RenderPage(session, pageIndex);
+  if (!page) return false;
+  *width = Pdfium().getPageWidth(page);
+  *height = Pdfium().getPageHeight(page);
+  return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+#include "papyrus_session.h"
+
+// Renders part of a page. The page is scaled to pageWidth x pageHeight pixels
+// and the region whose top-left corner is (left, top) on the scaled page is
+// written to pixels: width x height RGBA_8888 (byte order R, G, B, A), rows
+// stride bytes apart. Only that region is rasterized, so a tile of a deeply
+// zoomed page costs about as much as the tile itself. Pixels outside the page
+// are white.
+bool RenderPageRegion(PapyrusSession *session, int pageIndex, int pageWidth, int pageHeight, int left, int top,
+                      uint8_t *pixels, int width, int height, int stride);
+
+// Size of the page in points, without rendering. False for pages that cannot
+// be loaded, including pages still downloading. Keeps the page open for the
+// render that usually follows.
+bool PageSize(PapyrusSession *session, int pageIndex, double *width, double *height);
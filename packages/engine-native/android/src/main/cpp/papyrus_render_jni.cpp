@@ -0,0 +1,67 @@
+#include "papyrus_jni.h"
+#include "papyrus_render.h"
+#include "papyrus_thumbnail.h"
+
+#include <android/bitmap.h>
+
+// Renders into target (RGBA_8888) the region at (left, top) of the page
+// scaled to pageWidth x pageHeight; the region is as large as target.
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_papyrus_engine_PapyrusRender_nativeRenderRegion(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex, jobject target,
+                                                         jint pageWidth, jint pageHeight, jint left, jint top) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return JNI_FALSE;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !target) return JNI_FALSE;
+
+  AndroidBitmapInfo info;
+  if (AndroidBitmap_getInfo(env, target, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+      info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+    return JNI_FALSE;
+  }
+  void *pixels = nullptr;
+  if (AndroidBitmap_lockPixels(env, target, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) return JNI_FALSE;
+  bool rendered = RenderPageRegion(session, pageIndex, pageWidth, pageHeight, left, top, static_cast<uint8_t *>(pixels),
+                                   static_cast<int>(info.width), static_cast<int>(info.height), static_cast<int>(info.stride));
+  AndroidBitmap_unlockPixels(env, target);
+  return rendered ? JNI_TRUE : JNI_FALSE;
+}
+
+// Fills target (RGB_565) with a thumbnail of the page, from the cache under
+// directory (null for none) when there. Returns a ThumbnailResult.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_papyrus_engine_PapyrusRender_nativeRenderThumbnail(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex,
+                                                            jobject target, jstring directory) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return kThumbnailFailed;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !target) return kThumbnailFailed;
+
+  AndroidBitmapInfo info;
+  if (AndroidBitmap_getInfo(env, target, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+      info.format != ANDROID_BITMAP_FORMAT_RGB_565) {
+    return kThumbnailFailed;
+  }
+  const char *path = directory ? env->GetStringUTFChars(directory, nullptr) : nullptr;
+  if (directory && !path) return kThumbnailFailed;
+  ThumbnailResult result = kThumbnailFailed;
+  void *pixels = nullptr;
+  if (AndroidBitmap_lockPixels(env, target, &pixels) == ANDROID_BITMAP_RESULT_SUCCESS && pixels) {
+    result = LoadThumbnail(session, path, pageIndex, static_cast<int>(info.width), static_cast<int>(info.height),
+                           static_cast<uint16_t *>(pixels), static_cast<int>(info.stride));
+    AndroidBitmap_unlockPixels(env, target);
+  }
+  if (path) env->ReleaseStringUTFChars(directory, path);
+  return result;
+}
+
+// {width, height} of the page in points, or null if it cannot be loaded yet.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_papyrus_engine_PapyrusRender_nativeGetPageSize(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  double width = 0;
+  double height = 0;
+  if (!PageSize(SessionFromHandle(sessionHandle), pageIndex, &width, &height)) return nullptr;
+  jfloat values[2] = {static_cast<jfloat>(width), static_cast<jfloat>(height)};
+  jfloatArray array = env->NewFloatArray(2);
+  if (array) env->SetFloatArrayRegion(array, 0, 2, values);
+  return array;
+}
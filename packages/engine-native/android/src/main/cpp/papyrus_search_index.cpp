@@ -0,0 +1,349 @@
+#include "papyrus_search_index.h"
+
+#include "papyrus_progressive.h"
+#include "papyrus_source.h"
+#include "papyrus_text_cache.h"
+#include "papyrus_text_match.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <utility>
+
+#define LOG_TAG "PapyrusSearchIndex"
+#include "papyrus_log.h"
+
+constexpr uint32_t kIndexMagic = 0x58495050;  // "PPIX"
+// Bump whenever the layout, the trigram key or the default fold changes.
+constexpr uint32_t kIndexVersion = 2;
+// Pages indexed between two saves by BuildSearchIndex.
+constexpr int kIndexCheckpointPages = 64;
+constexpr size_t kFingerprintSampleBytes = 64 * 1024;
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t fingerprint;
+  int32_t pageCount;
+  int32_t indexedPages;
+  uint32_t trigramCount;
+  uint32_t postingBytes;
+};
+
+static_assert(sizeof(IndexHeader) == 32, "index header layout");
+
+// Posts the pages that could not be read when they were indexed. Trigram keys
+// take 48 bits, so it never collides with one; its pages stay candidates for
+// every query, since a later read may well succeed.
+constexpr uint64_t kUnreadPagesKey = UINT64_MAX;
+
+// Three folded units; trigrams with control chars such as line breaks never
+// occur in a query, so they are left out.
+static void CollectTrigrams(const unsigned short *chars, int length, std::vector<uint64_t> *keys) {
+  keys->clear();
+  for (int i = 0; i + 2 < length; i++) {
+    if (chars[i] < 0x20 || chars[i + 1] < 0x20 || chars[i + 2] < 0x20) continue;
+    keys->push_back(static_cast<uint64_t>(chars[i]) << 32 | static_cast<uint64_t>(chars[i + 1]) << 16 | chars[i + 2]);
+  }
+  std::sort(keys->begin(), keys->end());
+  keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+}
+
+static void AppendVarint(std::vector<uint8_t> *out, uint32_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+std::unique_ptr<SearchIndex> SearchIndex::Open(std::string path, uint64_t fingerprint, int pageCount) {
+  std::unique_ptr<SearchIndex> index(new SearchIndex(std::move(path), fingerprint, pageCount));
+  // Reuse refreshes the file's mtime, so pruning the cache by age keeps the
+  // indexes of documents still being read.
+  if (index->Map()) utimes(index->path_.c_str(), nullptr);
+  return index;
+}
+
+SearchIndex::SearchIndex(std::string path, uint64_t fingerprint, int pageCount)
+    : path_(std::move(path)), fingerprint_(fingerprint), pageCount_(pageCount) {}
+
+SearchIndex::~SearchIndex() {
+  Unmap();
+}
+
+// True if the table is sorted by key and every posting list lies within the
+// postings and holds ascending pages below indexedPages. A file failing this
+// was corrupted or written by something else, and is rebuilt like a missing
+// one; decoding and Candidates can then trust it.
+bool SearchIndex::ValidEntries(const Entry *entries, uint32_t entryCount, const uint8_t *postings, uint32_t postingBytes,
+                               int indexedPages) {
+  for (uint32_t e = 0; e < entryCount; e++) {
+    const Entry &entry = entries[e];
+    if ((e > 0 && entries[e - 1].key >= entry.key) || entry.offset > postingBytes) return false;
+    const uint8_t *at = postings + entry.offset;
+    const uint8_t *end = postings + postingBytes;
+    int64_t page = -1;
+    for (uint32_t i = 0; i < entry.count; i++) {
+      uint32_t delta = 0;
+      for (int shift = 0;; shift += 7) {
+        if (at == end || shift > 28) return false;
+        uint8_t byte = *at++;
+        delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+      }
+      // The first page is stored as is; later deltas are at least 1.
+      if (i > 0 && delta == 0) return false;
+      page = (i == 0 ? 0 : page) + delta;
+      if (page >= indexedPages) return false;
+    }
+  }
+  return true;
+}
+
+bool SearchIndex::Map() {
+  int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  struct stat info;
+  void *mapping = MAP_FAILED;
+  size_t size = 0;
+  if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(IndexHeader)) {
+    size = static_cast<size_t>(info.st_size);
+    mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  const IndexHeader *header = static_cast<const IndexHeader *>(mapping);
+  bool valid = header->magic == kIndexMagic && header->version == kIndexVersion && header->fingerprint == fingerprint_ &&
+               header->pageCount == pageCount_ && header->indexedPages >= 0 && header->indexedPages <= pageCount_ &&
+               size == sizeof(IndexHeader) + uint64_t{header->trigramCount} * sizeof(Entry) + header->postingBytes;
+  if (valid) {
+    const Entry *entries = reinterpret_cast<const Entry *>(header + 1);
+    valid = ValidEntries(entries, header->trigramCount, reinterpret_cast<const uint8_t *>(entries + header->trigramCount),
+                         header->postingBytes, header->indexedPages);
+  }
+  if (!valid) {
+    munmap(mapping, size);
+    return false;
+  }
+  mapping_ = mapping;
+  mappingSize_ = size;
+  entries_ = reinterpret_cast<const Entry *>(header + 1);
+  entryCount_ = header->trigramCount;
+  postings_ = reinterpret_cast<const uint8_t *>(entries_ + entryCount_);
+  mappedPages_ = header->indexedPages;
+  return true;
+}
+
+void SearchIndex::Unmap() {
+  if (mapping_) munmap(mapping_, mappingSize_);
+  mapping_ = nullptr;
+  mappingSize_ = 0;
+  entries_ = nullptr;
+  entryCount_ = 0;
+  postings_ = nullptr;
+  mappedPages_ = 0;
+}
+
+const SearchIndex::Entry *SearchIndex::Find(uint64_t key) const {
+  const Entry *end = entries_ + entryCount_;
+  const Entry *found = std::lower_bound(entries_, end, key, [](const Entry &entry, uint64_t value) { return entry.key < value; });
+  return found != end && found->key == key ? found : nullptr;
+}
+
+void SearchIndex::DecodePostings(const Entry &entry, std::vector<int32_t> *pages) const {
+  const uint8_t *at = postings_ + entry.offset;
+  int32_t page = 0;
+  for (uint32_t i = 0; i < entry.count; i++) {
+    uint32_t delta = 0;
+    for (int shift = 0;; shift += 7) {
+      uint8_t byte = *at++;
+      delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) break;
+    }
+    page += static_cast<int32_t>(delta);
+    pages->push_back(page);
+  }
+}
+
+void SearchIndex::AddPage(const PageText *page) {
+  if (Complete()) return;
+  int pageIndex = IndexedPages();
+  pendingPages_++;
+  if (!page) {
+    pending_[kUnreadPagesKey].push_back(pageIndex);
+    return;
+  }
+  std::vector<uint64_t> keys;
+  CollectTrigrams(page->folded.chars.data(), static_cast<int>(page->folded.chars.size()), &keys);
+  for (uint64_t key : keys) pending_[key].push_back(pageIndex);
+}
+
+bool SearchIndex::Save() {
+  std::vector<uint64_t> pendingKeys;
+  pendingKeys.reserve(pending_.size());
+  for (const auto &entry : pending_) pendingKeys.push_back(entry.first);
+  std::sort(pendingKeys.begin(), pendingKeys.end());
+
+  // Merge the mapped table and the pending trigrams, both in key order.
+  std::vector<Entry> entries;
+  std::vector<uint8_t> postings;
+  std::vector<int32_t> pages;
+  entries.reserve(entryCount_ + pendingKeys.size());
+  size_t mapped = 0;
+  size_t added = 0;
+  while (mapped < entryCount_ || added < pendingKeys.size()) {
+    uint64_t key = mapped < entryCount_ && (added == pendingKeys.size() || entries_[mapped].key <= pendingKeys[added])
+                       ? entries_[mapped].key
+                       : pendingKeys[added];
+    pages.clear();
+    if (mapped < entryCount_ && entries_[mapped].key == key) DecodePostings(entries_[mapped++], &pages);
+    if (added < pendingKeys.size() && pendingKeys[added] == key) {
+      const std::vector<int32_t> &more = pending_.find(key)->second;
+      pages.insert(pages.end(), more.begin(), more.end());
+      added++;
+    }
+    entries.push_back({key, static_cast<uint32_t>(postings.size()), static_cast<uint32_t>(pages.size())});
+    int32_t previous = 0;
+    for (int32_t page : pages) {
+      AppendVarint(&postings, static_cast<uint32_t>(page - previous));
+      previous = page;
+    }
+  }
+
+  IndexHeader header = {
+    kIndexMagic,
+    kIndexVersion,
+    fingerprint_,
+    pageCount_,
+    IndexedPages(),
+    static_cast<uint32_t>(entries.size()),
+    static_cast<uint32_t>(postings.size()),
+  };
+  std::string temporary = path_ + ".tmp";
+  FILE *file = std::fopen(temporary.c_str(), "wb");
+  if (!file) {
+    LOGE("Failed to create %s", temporary.c_str());
+    return false;
+  }
+  bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 std::fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size() &&
+                 std::fwrite(postings.data(), 1, postings.size(), file) == postings.size();
+  written = std::fclose(file) == 0 && written;
+  if (!written || std::rename(temporary.c_str(), path_.c_str()) != 0) {
+    LOGE("Failed to write %s", path_.c_str());
+    std::remove(temporary.c_str());
+    return false;
+  }
+
+  Unmap();
+  pending_.clear();
+  pendingPages_ = 0;
+  // Should the new file not map, the index starts over rather than keep
+  // pending pages that no longer follow the mapped ones.
+  return Map();
+}
+
+bool SearchIndex::Candidates(const unsigned short *query, int queryLength, std::vector<uint8_t> *candidates) const {
+  FoldedText folded;
+  FoldText(query, queryLength, 0, &folded);
+  std::vector<uint64_t> keys;
+  CollectTrigrams(folded.chars.data(), static_cast<int>(folded.chars.size()), &keys);
+  if (keys.empty()) return false;
+
+  // matched[p] counts the query trigrams seen on page p so far; a page only
+  // advances when it held every previous one.
+  int indexed = IndexedPages();
+  std::vector<uint32_t> matched(indexed, 0);
+  std::vector<int32_t> pages;
+  for (uint32_t round = 0; round < keys.size(); round++) {
+    pages.clear();
+    const Entry *entry = Find(keys[round]);
+    if (entry) DecodePostings(*entry, &pages);
+    auto more = pending_.find(keys[round]);
+    if (more != pending_.end()) pages.insert(pages.end(), more->second.begin(), more->second.end());
+    for (int32_t page : pages) {
+      if (matched[page] == round) matched[page] = round + 1;
+    }
+  }
+
+  candidates->assign(pageCount_, 1);
+  for (int page = 0; page < indexed; page++) {
+    (*candidates)[page] = matched[page] == keys.size() ? 1 : 0;
+  }
+  pages.clear();
+  const Entry *unread = Find(kUnreadPagesKey);
+  if (unread) DecodePostings(*unread, &pages);
+  auto more = pending_.find(kUnreadPagesKey);
+  if (more != pending_.end()) pages.insert(pages.end(), more->second.begin(), more->second.end());
+  for (int32_t page : pages) (*candidates)[page] = 1;
+  return true;
+}
+
+static uint64_t Fnv1a(uint64_t hash, const uint8_t *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Reads [offset, offset + size) through a PDFium file access.
+static bool ReadBlock(FPDF_FILEACCESS *access, uint64_t offset, size_t size, std::vector<uint8_t> *out) {
+  out->resize(size);
+  return size == 0 || access->m_GetBlock(access->m_Param, static_cast<unsigned long>(offset), out->data(),
+                                         static_cast<unsigned long>(size)) != 0;
+}
+
+uint64_t DocumentFingerprint(PapyrusSession *session) {
+  if (!session) return 0;
+  if (session->fingerprint != 0) return session->fingerprint;
+  FPDF_FILEACCESS *access = nullptr;
+  uint64_t length = 0;
+  if (session->source) {
+    access = session->source->Access();
+    length = session->source->Size();
+  } else if (session->progressive && session->progressive->Complete()) {
+    access = session->progressive->Access();
+    length = static_cast<uint64_t>(session->progressive->Length());
+  }
+  if (!access || length == 0) return 0;
+
+  size_t head = static_cast<size_t>(std::min<uint64_t>(length, kFingerprintSampleBytes));
+  size_t tail = static_cast<size_t>(std::min<uint64_t>(length - head, kFingerprintSampleBytes));
+  std::vector<uint8_t> block;
+  uint64_t hash = Fnv1a(0xCBF29CE484222325ull, reinterpret_cast<const uint8_t *>(&length), sizeof(length));
+  if (!ReadBlock(access, 0, head, &block)) return 0;
+  hash = Fnv1a(hash, block.data(), block.size());
+  if (!ReadBlock(access, length - tail, tail, &block)) return 0;
+  hash = Fnv1a(hash, block.data(), block.size());
+  session->fingerprint = hash ? hash : 1;
+  return session->fingerprint;
+}
+
+int AttachSearchIndex(PapyrusSession *session, const char *directory) {
+  if (!session || !session->document || !directory) return -1;
+  uint64_t fingerprint = DocumentFingerprint(session);
+  if (fingerprint == 0) return -1;
+  char name[32];
+  std::snprintf(name, sizeof(name), "/%016" PRIx64 ".pidx", fingerprint);
+  session->searchIndex = SearchIndex::Open(std::string(directory) + name, fingerprint, session->pageCount);
+  return session->searchIndex->IndexedPages();
+}
+
+int BuildSearchIndex(PapyrusSession *session, int pageBudget) {
+  SearchIndex *index = session ? session->searchIndex.get() : nullptr;
+  if (!index || index->Complete()) return -1;
+  for (int i = 0; i < pageBudget && !index->Complete(); i++) {
+    std::shared_ptr<const PageText> page = ReadPageText(session, index->IndexedPages());
+    index->AddPage(page.get());
+  }
+  if (index->Complete() || index->PendingPages() >= kIndexCheckpointPages) index->Save();
+  return index->Complete() ? -1 : index->IndexedPages();
+}
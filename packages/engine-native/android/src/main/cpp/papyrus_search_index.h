@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "papyrus_session.h"
+
+struct PageText;
+
+// Trigram index of a document's text, persisted next to other cache files so
+// a reopened document narrows searches without extracting every page again.
+// Trigrams are taken over the default-folded text (PageText::folded), which
+// every search mode's match also matches, and map to the pages containing
+// them. Pages are indexed in order, so a partially built index covers a page
+// prefix; later pages are always candidates, as are indexed pages that could
+// not be read.
+//
+// The file is written whole to a temporary name and renamed over the old one,
+// then mapped read-only:
+//
+//   header  magic, version, fingerprint, pageCount, indexedPages,
+//           trigramCount, postingBytes
+//   table   trigramCount x {key, offset, count}, sorted by key
+//   postings per trigram, ascending page deltas as LEB128 varints
+//
+// A file whose version, fingerprint or page count differ is ignored and
+// rebuilt. Not thread-safe; callers serialize through the engine's pdfiumLock
+// like every other session call.
+class SearchIndex {
+ public:
+  // The index for a document at path, reusing the pages an existing file
+  // there already covers.
+  static std::unique_ptr<SearchIndex> Open(std::string path, uint64_t fingerprint, int pageCount);
+
+  ~SearchIndex();
+
+  SearchIndex(const SearchIndex &) = delete;
+  SearchIndex &operator=(const SearchIndex &) = delete;
+
+  int PageCount() const { return pageCount_; }
+  // Pages [0, IndexedPages()) are indexed.
+  int IndexedPages() const { return mappedPages_ + pendingPages_; }
+  bool Complete() const { return IndexedPages() >= pageCount_; }
+  // Pages added since the last Save.
+  int PendingPages() const { return pendingPages_; }
+
+  // Indexes page IndexedPages(); null for a page that could not be read, which
+  // is then a candidate for every query. No-op once complete.
+  void AddPage(const PageText *page);
+
+  // Writes every indexed page to the file and maps it. False if it could not
+  // be written; the pages stay pending.
+  bool Save();
+
+  // Sets candidates[p] for every page that may contain query, which is any
+  // search query before folding. False, leaving candidates alone, when the
+  // query is too short to narrow anything down.
+  bool Candidates(const unsigned short *query, int queryLength, std::vector<uint8_t> *candidates) const;
+
+ private:
+  struct Entry {
+    uint64_t key;
+    uint32_t offset;
+    uint32_t count;
+  };
+
+  SearchIndex(std::string path, uint64_t fingerprint, int pageCount);
+
+  bool Map();
+  static bool ValidEntries(const Entry *entries, uint32_t entryCount, const uint8_t *postings, uint32_t postingBytes,
+                           int indexedPages);
+  void Unmap();
+  const Entry *Find(uint64_t key) const;
+  void DecodePostings(const Entry &entry, std::vector<int32_t> *pages) const;
+
+  const std::string path_;
+  const uint64_t fingerprint_;
+  const int pageCount_;
+  // The mapped file, covering pages [0, mappedPages_).
+  void *mapping_ = nullptr;
+  size_t mappingSize_ = 0;
+  const Entry *entries_ = nullptr;
+  uint32_t entryCount_ = 0;
+  const uint8_t *postings_ = nullptr;
+  int mappedPages_ = 0;
+  // Pages [mappedPages_, mappedPages_ + pendingPages_) not saved yet.
+  std::unordered_map<uint64_t, std::vector<int32_t>> pending_;
+  int pendingPages_ = 0;
+};
+
+// Identifies the bytes of a session's document: its length and its first and
+// last 64 KiB, where the header, the trailer with its /ID and the
+// cross-reference data of every incremental save live. 0 when the session
+// reads a file by path or one that is still downloading. Kept on the session
+// once known.
+uint64_t DocumentFingerprint(PapyrusSession *session);
+
+// Opens the session's index under directory, named after its fingerprint.
+// Returns the pages it already covers, or -1 when the document cannot be
+// fingerprinted.
+int AttachSearchIndex(PapyrusSession *session, const char *directory);
+
+// Indexes up to pageBudget more pages of the attached index, saving it every
+// so often and once complete. Returns the next page to index, or -1 once the
+// index is complete or none is attached.
+int BuildSearchIndex(PapyrusSession *session, int pageBudget);
@@ -0,0 +1,42 @@
+#include "papyrus_session.h"
+
+#include "papyrus_progressive.h"
+#include "papyrus_search_index.h"
+#include "papyrus_source.h"
+#include "papyrus_text_cache.h"
+
+#include <utility>
+
+static PapyrusSession *NewSession(FPDF_DOCUMENT doc) {
+  PapyrusSession *session = new PapyrusSession();
+  session->document = doc;
+  session->pageCount = Pdfium().getDocPageCount(doc);
+  return session;
+}
+
+PapyrusSession *OpenSession(const char *path) {
+  if (!path) return nullptr;
+  FPDF_DOCUMENT doc = Pdfium().loadDocument(path, nullptr);
+  return doc ? NewSession(doc) : nullptr;
+}
+
+PapyrusSession *OpenSession(std::shared_ptr<DocumentSource> source) {
+  if (!source) return nullptr;
+  FPDF_DOCUMENT doc = Pdfium().loadCustomDocument(source->Access(), nullptr);
+  if (!doc) return nullptr;
+  PapyrusSession *session = NewSession(doc);
+  session->source = std::move(source);
+  return session;
+}
+
+void CloseSession(PapyrusSession *session) {
+  if (!session) return;
+  session->textCache.reset();
+  session->searchIndex.reset();
+  if (session->document) {
+    if (session->renderPage) Pdfium().closePage(session->renderPage);
+    Pdfium().closeDocument(session->document);
+  }
+  if (session->avail) Pdfium().availDestroy(session->avail);
+  delete session;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "papyrus_pdfium.h"
+#include "papyrus_stats.h"
+
+class DocumentSource;
+class DocumentTextCache;
+class PageLinks;
+class ProgressiveSource;
+class SearchIndex;
+
+// One PDFium document kept open for the lifetime of an engine's loaded file.
+// Every entry point that reads the document receives the session instead of a
+// file path or the PdfiumCore pointer. Callers serialize access through the
+// engine's pdfiumLock.
+struct PapyrusSession {
+  FPDF_DOCUMENT document = nullptr;
+  int pageCount = 0;
+  // Bytes the document is read from, for sessions opened from a source.
+  std::shared_ptr<DocumentSource> source;
+  // For sessions opened while the file downloads (papyrus_progressive.h): the
+  // growing file and PDFium's availability tracker over it.
+  std::shared_ptr<ProgressiveSource> progressive;
+  FPDF_AVAIL avail = nullptr;
+  std::shared_ptr<DocumentTextCache> textCache;
+  // Persistent trigram index narrowing searches (papyrus_search_index.h), once
+  // attached.
+  std::shared_ptr<SearchIndex> searchIndex;
+  // The owning engine's stats, or null when nothing is collecting.
+  PapyrusStats *stats = nullptr;
+  // Page kept open between renders, so the tiles of one page load it once.
+  int renderPageIndex = -1;
+  FPDF_PAGE renderPage = nullptr;
+  // Render target of thumbnails before they are downscaled, reused by each.
+  std::vector<uint8_t> thumbnailScratch;
+  // Each page's /Rotate in degrees once the page was loaded, -1 before, and
+  // the link tables of pages hit-tested so far (papyrus_metadata.h).
+  std::vector<int16_t> pageRotation;
+  std::unordered_map<int, std::shared_ptr<const PageLinks>> pageLinks;
+  // DocumentFingerprint, once known.
+  uint64_t fingerprint = 0;
+  // Outline nodes handed out by PackOutlineChildren. JS refers to a bookmark
+  // by its index + 1 here (0 is the root), never by raw pointer.
+  std::vector<void *> outlineNodes;
+  std::unordered_map<void *, int> outlineNodeIds;
+  // Backing store of the last packed result (papyrus_packed.h). Core calls
+  // serialize into it; the JNI layer hands it to Java without copying.
+  std::vector<uint8_t> packed;
+};
+
+// Opens path with the installed PDFium table; nullptr if it cannot be read.
+PapyrusSession *OpenSession(const char *path);
+
+// Opens a document read in place from source, which the session keeps until
+// it is closed.
+PapyrusSession *OpenSession(std::shared_ptr<DocumentSource> source);
+
+void CloseSession(PapyrusSession *session);
@@ -0,0 +1,55 @@
+#include "papyrus_jni.h"
+#include "papyrus_source.h"
+#include "papyrus_text_cache.h"
+
+#include <memory>
+#include <utility>
+
+static jlong OpenWithStats(std::shared_ptr<DocumentSource> source, jlong statsHandle) {
+  PapyrusSession *session = OpenSession(std::move(source));
+  if (session) session->stats = reinterpret_cast<PapyrusStats *>(statsHandle);
+  return reinterpret_cast<jlong>(session);
+}
+
+// Maps [offset, offset + length) of fd; length < 0 runs to the end of the
+// file. The caller may close fd once this returns.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusDocumentSession_nativeOpenFd(JNIEnv *, jclass, jint fd, jlong offset, jlong length, jlong statsHandle) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return 0;
+  return OpenWithStats(DocumentSource::MapFile(fd, offset, length), statsHandle);
+}
+
+// Reads a direct ByteBuffer in place; Java keeps it reachable until
+// nativeClose.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusDocumentSession_nativeOpenBuffer(JNIEnv *env, jclass, jobject buffer, jlong statsHandle) {
+  if (!EnsurePdfium(kPdfiumLibrary) || !buffer) return 0;
+  const uint8_t *data = static_cast<const uint8_t *>(env->GetDirectBufferAddress(buffer));
+  jlong size = env->GetDirectBufferCapacity(buffer);
+  if (!data || size <= 0) return 0;
+  return OpenWithStats(DocumentSource::Borrow(data, static_cast<size_t>(size)), statsHandle);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_papyrus_engine_PapyrusDocumentSession_nativeGetPageCount(JNIEnv *, jclass, jlong handle) {
+  PapyrusSession *session = SessionFromHandle(handle);
+  return session ? session->pageCount : 0;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusDocumentSession_nativePrewarm(JNIEnv *, jclass, jlong handle, jint pageIndex) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return;
+  PapyrusSession *session = SessionFromHandle(handle);
+  if (session) PrewarmPageText(session, pageIndex);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusDocumentSession_nativeClose(JNIEnv *, jclass, jlong handle) {
+  PapyrusSession *session = SessionFromHandle(handle);
+  if (!session) return;
+  if (!EnsurePdfium(kPdfiumLibrary)) {
+    // Never opened through PDFium; nothing to close there.
+    session->document = nullptr;
+  }
+  CloseSession(session);
+}
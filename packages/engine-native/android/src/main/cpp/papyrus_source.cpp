@@ -0,0 +1,52 @@
+#include "papyrus_source.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#define LOG_TAG "PapyrusSource"
+#include "papyrus_log.h"
+
+std::shared_ptr<DocumentSource> DocumentSource::MapFile(int fd, int64_t offset, int64_t length) {
+  struct stat info;
+  if (fd < 0 || offset < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) return nullptr;
+  if (length < 0) length = static_cast<int64_t>(info.st_size) - offset;
+  if (length <= 0 || offset + length > static_cast<int64_t>(info.st_size)) return nullptr;
+
+  // mmap offsets must be page-aligned; assets start anywhere inside the APK.
+  int64_t pageSize = sysconf(_SC_PAGESIZE);
+  int64_t alignedOffset = offset - offset % pageSize;
+  size_t mappingSize = static_cast<size_t>(length + (offset - alignedOffset));
+  void *mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(alignedOffset));
+  if (mapping == MAP_FAILED) {
+    LOGE("Failed to map %lld bytes of fd %d", static_cast<long long>(length), fd);
+    return nullptr;
+  }
+  const uint8_t *data = static_cast<const uint8_t *>(mapping) + (offset - alignedOffset);
+  return std::shared_ptr<DocumentSource>(new DocumentSource(data, static_cast<size_t>(length), mapping, mappingSize));
+}
+
+std::shared_ptr<DocumentSource> DocumentSource::Borrow(const uint8_t *data, size_t size) {
+  if (!data || size == 0) return nullptr;
+  return std::shared_ptr<DocumentSource>(new DocumentSource(data, size, nullptr, 0));
+}
+
+DocumentSource::DocumentSource(const uint8_t *data, size_t size, void *mapping, size_t mappingSize)
+    : data_(data), size_(size), mapping_(mapping), mappingSize_(mappingSize) {
+  access_.m_FileLen = static_cast<unsigned long>(size);
+  access_.m_GetBlock = GetBlock;
+  access_.m_Param = this;
+}
+
+DocumentSource::~DocumentSource() {
+  if (mapping_) munmap(mapping_, mappingSize_);
+}
+
+int DocumentSource::GetBlock(void *param, unsigned long position, unsigned char *buf, unsigned long size) {
+  const DocumentSource *source = static_cast<const DocumentSource *>(param);
+  if (position > source->size_ || size > source->size_ - position) return 0;
+  std::memcpy(buf, source->data_ + position, size);
+  return 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "papyrus_pdfium.h"
+
+// The bytes of a document, read by PDFium in place through
+// FPDF_LoadCustomDocument instead of from a copy on disk: either a read-only
+// mapping of a file descriptor range (a local file, or an asset inside the
+// APK), or memory owned by the caller, such as a direct ByteBuffer. The source
+// must outlive the document, since PDFium reads it lazily; sessions own theirs.
+class DocumentSource {
+ public:
+  // Maps length bytes of fd starting at offset; length < 0 maps to the end of
+  // the file. The mapping survives closing fd. nullptr if fd is not a regular
+  // file that can be mapped, e.g. a pipe.
+  static std::shared_ptr<DocumentSource> MapFile(int fd, int64_t offset, int64_t length);
+
+  // Reads size bytes at data, which the caller keeps alive and unchanged
+  // until the session using this source is closed.
+  static std::shared_ptr<DocumentSource> Borrow(const uint8_t *data, size_t size);
+
+  ~DocumentSource();
+
+  DocumentSource(const DocumentSource &) = delete;
+  DocumentSource &operator=(const DocumentSource &) = delete;
+
+  const uint8_t *Data() const { return data_; }
+  size_t Size() const { return size_; }
+
+  // File access over the bytes, valid as long as this source.
+  FPDF_FILEACCESS *Access() { return &access_; }
+
+ private:
+  DocumentSource(const uint8_t *data, size_t size, void *mapping, size_t mappingSize);
+
+  static int GetBlock(void *param, unsigned long position, unsigned char *buf, unsigned long size);
+
+  const uint8_t *data_;
+  size_t size_;
+  // Page-aligned mapping containing data_, or nullptr for borrowed memory.
+  void *mapping_;
+  size_t mappingSize_;
+  FPDF_FILEACCESS access_;
+};
@@ -0,0 +1,113 @@
+#include "papyrus_stats.h"
+
+#include <chrono>
+
+#if defined(__ANDROID__)
+#include <dlfcn.h>
+
+#include <mutex>
+#endif
+
+static uint64_t NowNanos() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static int BucketFor(uint64_t nanos) {
+  uint64_t micros = nanos / 1000;
+  if (micros < 2) return 0;
+  int bucket = 63 - __builtin_clzll(micros);
+  return bucket < kStatBuckets ? bucket : kStatBuckets - 1;
+}
+
+void PapyrusStats::Record(StatPhase phase, uint64_t nanos) {
+  Phase &entry = phases_[phase];
+  entry.count.fetch_add(1, std::memory_order_relaxed);
+  entry.totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+  entry.buckets[BucketFor(nanos)].fetch_add(1, std::memory_order_relaxed);
+  uint64_t max = entry.maxNanos.load(std::memory_order_relaxed);
+  while (nanos > max && !entry.maxNanos.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+  }
+}
+
+void PapyrusStats::Snapshot(std::vector<int64_t> *out) const {
+  out->clear();
+  out->reserve(3 + kStatPhaseCount * (3 + kStatBuckets) + kStatCounterCount);
+  out->push_back(kStatPhaseCount);
+  out->push_back(kStatBuckets);
+  out->push_back(kStatCounterCount);
+  for (const Phase &phase : phases_) {
+    out->push_back(static_cast<int64_t>(phase.count.load(std::memory_order_relaxed)));
+    out->push_back(static_cast<int64_t>(phase.totalNanos.load(std::memory_order_relaxed)));
+    out->push_back(static_cast<int64_t>(phase.maxNanos.load(std::memory_order_relaxed)));
+    for (const auto &bucket : phase.buckets) {
+      out->push_back(static_cast<int64_t>(bucket.load(std::memory_order_relaxed)));
+    }
+  }
+  for (const auto &counter : counters_) {
+    out->push_back(static_cast<int64_t>(counter.load(std::memory_order_relaxed)));
+  }
+}
+
+void PapyrusStats::Reset() {
+  for (Phase &phase : phases_) {
+    phase.count.store(0, std::memory_order_relaxed);
+    phase.totalNanos.store(0, std::memory_order_relaxed);
+    phase.maxNanos.store(0, std::memory_order_relaxed);
+    for (auto &bucket : phase.buckets) bucket.store(0, std::memory_order_relaxed);
+  }
+  for (auto &counter : counters_) counter.store(0, std::memory_order_relaxed);
+}
+
+#if defined(__ANDROID__)
+// ATrace_* is NDK API 23; resolved at runtime so minSdk 21 still loads.
+struct TraceFns {
+  bool (*isEnabled)();
+  void (*beginSection)(const char *);
+  void (*endSection)();
+};
+
+static const TraceFns &Trace() {
+  static TraceFns fns = {};
+  static std::once_flag once;
+  std::call_once(once, [] {
+    void *android = dlopen("libandroid.so", RTLD_NOW | RTLD_NOLOAD);
+    if (!android) return;
+    fns.isEnabled = reinterpret_cast<bool (*)()>(dlsym(android, "ATrace_isEnabled"));
+    fns.beginSection = reinterpret_cast<void (*)(const char *)>(dlsym(android, "ATrace_beginSection"));
+    fns.endSection = reinterpret_cast<void (*)()>(dlsym(android, "ATrace_endSection"));
+    if (!fns.isEnabled || !fns.beginSection || !fns.endSection) fns = {};
+  });
+  return fns;
+}
+
+static const char *const kTraceNames[kStatPhaseCount] = {
+  "papyrus:pageLoad", "papyrus:textLoad", "papyrus:glyphs", "papyrus:textIndex",
+  "papyrus:find", "papyrus:preview", "papyrus:marshal", "papyrus:render",
+};
+
+static bool BeginTrace(StatPhase phase) {
+  const TraceFns &trace = Trace();
+  if (!trace.isEnabled || !trace.isEnabled()) return false;
+  trace.beginSection(kTraceNames[phase]);
+  return true;
+}
+
+static void EndTrace() {
+  Trace().endSection();
+}
+#else
+static bool BeginTrace(StatPhase) {
+  return false;
+}
+
+static void EndTrace() {}
+#endif
+
+StatScope::StatScope(PapyrusStats *stats, StatPhase phase)
+    : stats_(stats), phase_(phase), start_(stats ? NowNanos() : 0), traced_(BeginTrace(phase)) {}
+
+StatScope::~StatScope() {
+  if (stats_) stats_->Record(phase_, NowNanos() - start_);
+  if (traced_) EndTrace();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Low-overhead counters and latency histograms for the native hot paths. One
+// PapyrusStats belongs to an engine and outlives the documents it loads;
+// sessions record into it through PapyrusSession::stats, which may be null.
+// Everything is relaxed atomics, so search workers record without locking.
+
+// Phase and counter order is part of the snapshot layout read by
+// PapyrusStats.java; append only.
+enum StatPhase : int {
+  kStatPageLoad,   // FPDF_LoadPage
+  kStatTextLoad,   // FPDFText_LoadPage
+  kStatGlyphs,     // text copy and per-glyph FPDFText_GetCharBox
+  kStatTextIndex,  // glyph index build and default fold
+  kStatFind,       // matching one page
+  kStatPreview,    // hit previews, rects and serialization
+  kStatMarshal,    // Java-side decoding into bridge objects (recorded from Java)
+  kStatRender,     // FPDF_RenderPageBitmap of one tile or base layer
+  kStatPhaseCount,
+};
+
+enum StatCounter : int {
+  kStatTextCacheHits,
+  kStatTextCacheMisses,
+  kStatTextCacheEvictions,
+  kStatPagesScanned,
+  kStatSearchHits,
+  kStatPagesSkipped,  // pages the search index ruled out without scanning
+  kStatThumbnailCacheHits,  // thumbnails read from the disk cache
+  kStatThumbnailsRendered,  // thumbnails rendered because none was cached
+  kStatCounterCount,
+};
+
+// Bucket b counts samples below 2^(b + 1) microseconds; the last one is
+// open-ended.
+constexpr int kStatBuckets = 20;
+
+class PapyrusStats {
+ public:
+  void Record(StatPhase phase, uint64_t nanos);
+
+  void Add(StatCounter counter, uint64_t amount = 1) {
+    counters_[counter].fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  // Flattened as phaseCount, bucketCount, counterCount, then per phase
+  // {count, totalNanos, maxNanos, buckets...}, then the counters.
+  void Snapshot(std::vector<int64_t> *out) const;
+
+  void Reset();
+
+ private:
+  struct Phase {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNanos{0};
+    std::atomic<uint64_t> maxNanos{0};
+    std::atomic<uint64_t> buckets[kStatBuckets] = {};
+  };
+
+  Phase phases_[kStatPhaseCount];
+  std::atomic<uint64_t> counters_[kStatCounterCount] = {};
+};
+
+// Times its scope into stats (when non-null) and, on Android, emits an
+// ATrace section while systrace/Perfetto is capturing.
+class StatScope {
+ public:
+  StatScope(PapyrusStats *stats, StatPhase phase);
+  ~StatScope();
+
+  StatScope(const StatScope &) = delete;
+  StatScope &operator=(const StatScope &) = delete;
+
+ private:
+  PapyrusStats *stats_;
+  StatPhase phase_;
+  uint64_t start_;
+  bool traced_;
+};
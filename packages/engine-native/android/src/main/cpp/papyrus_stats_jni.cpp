@@ -0,0 +1,39 @@
+#include "papyrus_jni.h"
+#include "papyrus_stats.h"
+
+#include <vector>
+
+static PapyrusStats *StatsFromHandle(jlong handle) {
+  return reinterpret_cast<PapyrusStats *>(handle);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusStats_nativeCreate(JNIEnv *, jclass) {
+  return reinterpret_cast<jlong>(new PapyrusStats());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusStats_nativeDestroy(JNIEnv *, jclass, jlong handle) {
+  delete StatsFromHandle(handle);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusStats_nativeRecord(JNIEnv *, jclass, jlong handle, jint phase, jlong nanos) {
+  PapyrusStats *stats = StatsFromHandle(handle);
+  if (!stats || phase < 0 || phase >= kStatPhaseCount || nanos < 0) return;
+  stats->Record(static_cast<StatPhase>(phase), static_cast<uint64_t>(nanos));
+}
+
+// See PapyrusStats::Snapshot for the layout.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_papyrus_engine_PapyrusStats_nativeSnapshot(JNIEnv *env, jclass, jlong handle, jboolean reset) {
+  PapyrusStats *stats = StatsFromHandle(handle);
+  if (!stats) return nullptr;
+  std::vector<int64_t> values;
+  stats->Snapshot(&values);
+  if (reset) stats->Reset();
+
+  jlongArray array = env->NewLongArray(static_cast<jsize>(values.size()));
+  if (array) env->SetLongArrayRegion(array, 0, static_cast<jsize>(values.size()), reinterpret_cast<const jlong *>(values.data()));
+  return array;
+}
@@ -0,0 +1,106 @@
+#include "papyrus_term_matcher.h"
+
+#include <algorithm>
+#include <utility>
+
+// Largest dense transition table, in entries (16 MiB).
+constexpr size_t kMaxDenseEntries = 4u << 20;
+
+TermMatcher::TermMatcher(const std::vector<std::vector<unsigned short>> &patterns) : classOf_(0x10000, 0) {
+  // Trie with per-node edges sorted by class.
+  std::vector<std::vector<std::pair<uint16_t, int32_t>>> children(1);
+  std::vector<std::vector<int32_t>> ends(1);
+  lengths_.reserve(patterns.size());
+  for (size_t pattern = 0; pattern < patterns.size(); pattern++) {
+    const std::vector<unsigned short> &units = patterns[pattern];
+    lengths_.push_back(static_cast<int32_t>(units.size()));
+    bool fits = !units.empty();
+    for (unsigned short unit : units) {
+      if (classOf_[unit] != 0) continue;
+      if (classCount_ > 0xFFFF) {
+        fits = false;
+        break;
+      }
+      classOf_[unit] = static_cast<uint16_t>(classCount_++);
+    }
+    if (!fits) continue;
+
+    int32_t node = 0;
+    for (unsigned short unit : units) {
+      uint16_t inputClass = classOf_[unit];
+      std::vector<std::pair<uint16_t, int32_t>> &edges = children[node];
+      auto edge = std::lower_bound(edges.begin(), edges.end(), std::make_pair(inputClass, int32_t(-1)));
+      if (edge != edges.end() && edge->first == inputClass) {
+        node = edge->second;
+        continue;
+      }
+      int32_t child = static_cast<int32_t>(children.size());
+      edges.insert(edge, {inputClass, child});
+      children.emplace_back();
+      ends.emplace_back();
+      node = child;
+    }
+    ends[node].push_back(static_cast<int32_t>(pattern));
+  }
+
+  size_t nodeCount = children.size();
+  edgeFirst_.reserve(nodeCount + 1);
+  outputFirst_.reserve(nodeCount + 1);
+  for (size_t node = 0; node < nodeCount; node++) {
+    edgeFirst_.push_back(static_cast<int32_t>(edgeClass_.size()));
+    for (const auto &edge : children[node]) {
+      edgeClass_.push_back(edge.first);
+      edgeTarget_.push_back(edge.second);
+    }
+    outputFirst_.push_back(static_cast<int32_t>(outputs_.size()));
+    outputs_.insert(outputs_.end(), ends[node].begin(), ends[node].end());
+  }
+  edgeFirst_.push_back(static_cast<int32_t>(edgeClass_.size()));
+  outputFirst_.push_back(static_cast<int32_t>(outputs_.size()));
+
+  // Failure and dictionary links, breadth first so every node's failure
+  // target is complete before its children need it.
+  fail_.assign(nodeCount, 0);
+  dictLink_.assign(nodeCount, -1);
+  std::vector<int32_t> order;
+  order.reserve(nodeCount);
+  order.push_back(0);
+  for (size_t head = 0; head < order.size(); head++) {
+    int32_t node = order[head];
+    for (int32_t k = edgeFirst_[node]; k < edgeFirst_[node + 1]; k++) {
+      int32_t child = edgeTarget_[k];
+      int32_t target = node == 0 ? 0 : SparseStep(fail_[node], edgeClass_[k]);
+      fail_[child] = target;
+      dictLink_[child] = outputFirst_[target] < outputFirst_[target + 1] ? target : dictLink_[target];
+      order.push_back(child);
+    }
+  }
+
+  dense_ = nodeCount * classCount_ <= kMaxDenseEntries;
+  if (!dense_) return;
+  next_.assign(nodeCount * classCount_, 0);
+  for (int32_t node : order) {
+    int32_t *row = &next_[static_cast<size_t>(node) * classCount_];
+    if (node != 0) {
+      const int32_t *fallback = &next_[static_cast<size_t>(fail_[node]) * classCount_];
+      std::copy(fallback, fallback + classCount_, row);
+    }
+    for (int32_t k = edgeFirst_[node]; k < edgeFirst_[node + 1]; k++) row[edgeClass_[k]] = edgeTarget_[k];
+  }
+}
+
+int32_t TermMatcher::Child(int32_t node, uint16_t inputClass) const {
+  const uint16_t *first = edgeClass_.data() + edgeFirst_[node];
+  const uint16_t *last = edgeClass_.data() + edgeFirst_[node + 1];
+  const uint16_t *found = std::lower_bound(first, last, inputClass);
+  return found != last && *found == inputClass ? edgeTarget_[found - edgeClass_.data()] : -1;
+}
+
+int32_t TermMatcher::SparseStep(int32_t node, uint16_t inputClass) const {
+  while (true) {
+    int32_t child = Child(node, inputClass);
+    if (child >= 0) return child;
+    if (node == 0) return 0;
+    node = fail_[node];
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Aho-Corasick automaton over folded UTF-16 units: finds every occurrence of
+// many patterns in one pass over a page, however many there are. Units that
+// occur in no pattern share one input class. While nodes x classes stays
+// small, as for a glossary in one alphabet, transitions are a dense table and
+// each unit costs one lookup; larger automatons (thousands of distinct CJK
+// units, say) keep sorted trie edges and follow failure links instead.
+// Immutable once built, so search workers share it.
+class TermMatcher {
+ public:
+  // patterns are already folded. Empty ones never match, nor do any that
+  // would need more than 65535 distinct units across all patterns.
+  explicit TermMatcher(const std::vector<std::vector<unsigned short>> &patterns);
+
+  TermMatcher(const TermMatcher &) = delete;
+  TermMatcher &operator=(const TermMatcher &) = delete;
+
+  // True when no pattern can match anything.
+  bool Empty() const { return outputs_.empty(); }
+
+  int PatternCount() const { return static_cast<int>(lengths_.size()); }
+  int PatternLength(int pattern) const { return lengths_[pattern]; }
+
+  // Calls onMatch(pattern, end) for every occurrence in text, end being the
+  // index of its last unit. Occurrences come in order of end, longest first;
+  // overlapping ones are all reported.
+  template <typename OnMatch>
+  void Scan(const unsigned short *text, int length, OnMatch &&onMatch) const {
+    int32_t node = 0;
+    for (int i = 0; i < length; i++) {
+      uint16_t inputClass = classOf_[text[i]];
+      node = dense_ ? next_[static_cast<size_t>(node) * classCount_ + inputClass] : SparseStep(node, inputClass);
+      int32_t at = outputFirst_[node] < outputFirst_[node + 1] ? node : dictLink_[node];
+      for (; at >= 0; at = dictLink_[at]) {
+        for (int32_t k = outputFirst_[at]; k < outputFirst_[at + 1]; k++) onMatch(outputs_[k], i);
+      }
+    }
+  }
+
+ private:
+  int32_t SparseStep(int32_t node, uint16_t inputClass) const;
+  // The trie child of node on inputClass, or -1.
+  int32_t Child(int32_t node, uint16_t inputClass) const;
+
+  // Input class of each UTF-16 unit; 0 for units in no pattern.
+  std::vector<uint16_t> classOf_;
+  size_t classCount_ = 1;
+  bool dense_ = false;
+  // Dense: the transition of node n on class c at n * classCount_ + c.
+  std::vector<int32_t> next_;
+  // Sparse: trie edges of node n at [edgeFirst_[n], edgeFirst_[n + 1]), by
+  // class, and the failure link of each node. Node 0 is the root.
+  std::vector<int32_t> edgeFirst_;
+  std::vector<uint16_t> edgeClass_;
+  std::vector<int32_t> edgeTarget_;
+  std::vector<int32_t> fail_;
+  // Patterns ending exactly at node n (one, or duplicates of it):
+  // outputs_[outputFirst_[n] .. outputFirst_[n + 1]).
+  std::vector<int32_t> outputFirst_;
+  std::vector<int32_t> outputs_;
+  // Nearest proper suffix node that ends a pattern, or -1.
+  std::vector<int32_t> dictLink_;
+  std::vector<int32_t> lengths_;
+};
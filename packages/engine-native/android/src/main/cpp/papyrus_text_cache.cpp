@@ -0,0 +1,188 @@
+#include "papyrus_text_cache.h"
+
+#include "papyrus_progressive.h"
+
+#include <algorithm>
+
+constexpr size_t kTextCacheBudgetBytes = 64u * 1024u * 1024u;
+
+// Copies the text and every glyph box of textPage into page, and the glyph
+// font sizes into fontSize when PDFium reports them.
+static void ReadGlyphs(const PdfiumFns &fns, FPDF_TEXTPAGE textPage, PageText *page, std::vector<float> *fontSize) {
+  int charCount = std::max(0, fns.textCountChars(textPage));
+  page->text.assign(static_cast<size_t>(charCount) + 1, 0);
+  int written = charCount > 0 ? fns.textGetText(textPage, 0, charCount, page->text.data()) : 0;
+  if (written - 1 != charCount) {
+    // Characters outside the BMP expand to surrogate pairs in the bulk copy and
+    // break the char index <-> glyph mapping, so fall back to one unit per index.
+    for (int i = 0; i < charCount; i++) {
+      unsigned int unicode = fns.textGetUnicode(textPage, i);
+      page->text[i] = unicode > 0xFFFF ? 0xFFFD : static_cast<unsigned short>(unicode);
+    }
+  }
+  page->text.resize(static_cast<size_t>(charCount));
+
+  page->left.resize(charCount);
+  page->right.resize(charCount);
+  page->top.resize(charCount);
+  page->bottom.resize(charCount);
+  page->hasBox.resize(charCount);
+  for (int i = 0; i < charCount; i++) {
+    double cLeft = 0;
+    double cRight = 0;
+    double cTop = 0;
+    double cBottom = 0;
+    bool ok = fns.textGetCharBox(textPage, i, &cLeft, &cRight, &cBottom, &cTop) != 0;
+    page->left[i] = static_cast<float>(cLeft);
+    page->right[i] = static_cast<float>(cRight);
+    page->top[i] = static_cast<float>(cTop);
+    page->bottom[i] = static_cast<float>(cBottom);
+    page->hasBox[i] = ok ? 1 : 0;
+  }
+  if (fns.textGetFontSize) {
+    fontSize->resize(charCount);
+    for (int i = 0; i < charCount; i++) {
+      (*fontSize)[i] = page->hasBox[i] ? static_cast<float>(fns.textGetFontSize(textPage, i)) : 0.0f;
+    }
+  }
+}
+
+// Called with the cache's extractMutex_ held, which also serializes the
+// availability check of progressive sessions across search workers.
+static std::shared_ptr<const PageText> ExtractPageText(PapyrusSession *session, int pageIndex) {
+  if (!PageDataReady(session, pageIndex)) return nullptr;
+  const PdfiumFns &fns = Pdfium();
+  PapyrusStats *stats = session->stats;
+  FPDF_PAGE page = nullptr;
+  {
+    StatScope timing(stats, kStatPageLoad);
+    page = fns.loadPage(session->document, pageIndex);
+  }
+  if (!page) return nullptr;
+  FPDF_TEXTPAGE textPage = nullptr;
+  {
+    StatScope timing(stats, kStatTextLoad);
+    textPage = fns.textLoadPage(page);
+  }
+  if (!textPage) {
+    fns.closePage(page);
+    return nullptr;
+  }
+
+  auto result = std::make_shared<PageText>();
+  result->width = fns.getPageWidth(page);
+  result->height = fns.getPageHeight(page);
+  std::vector<float> fontSize;
+  {
+    StatScope timing(stats, kStatGlyphs);
+    ReadGlyphs(fns, textPage, result.get(), &fontSize);
+  }
+  fns.textClosePage(textPage);
+  fns.closePage(page);
+
+  StatScope timing(stats, kStatTextIndex);
+  result->glyphs.Build(result->text.data(), result->left.data(), result->right.data(), result->top.data(),
+                       result->bottom.data(), result->hasBox.data(), result->CharCount());
+  if (!fontSize.empty()) {
+    result->lineFontSize.reserve(result->glyphs.Lines().size());
+    for (const GlyphLine &line : result->glyphs.Lines()) result->lineFontSize.push_back(fontSize[line.first]);
+  }
+  FoldText(result->text.data(), result->CharCount(), 0, &result->folded);
+  return result;
+}
+
+std::shared_ptr<const PageText> DocumentTextCache::GetPage(PapyrusSession *session, int pageIndex) {
+  PapyrusStats *stats = session->stats;
+  std::shared_ptr<const PageText> page = Lookup(pageIndex);
+  if (!page) {
+    std::lock_guard<std::mutex> extracting(extractMutex_);
+    page = Lookup(pageIndex);
+    if (!page) return Insert(pageIndex, ExtractPageText(session, pageIndex), stats);
+  }
+  if (stats) stats->Add(kStatTextCacheHits);
+  return page;
+}
+
+std::shared_ptr<const PageText> DocumentTextCache::Read(PapyrusSession *session, int pageIndex) {
+  std::shared_ptr<const PageText> page = Lookup(pageIndex);
+  if (page) return page;
+  std::lock_guard<std::mutex> extracting(extractMutex_);
+  return ExtractPageText(session, pageIndex);
+}
+
+void DocumentTextCache::Prewarm(PapyrusSession *session, int pageIndex) {
+  if (Contains(pageIndex)) return;
+  std::lock_guard<std::mutex> extracting(extractMutex_);
+  if (!Contains(pageIndex)) Insert(pageIndex, ExtractPageText(session, pageIndex), session->stats);
+}
+
+std::shared_ptr<const PageText> DocumentTextCache::Insert(int pageIndex, std::shared_ptr<const PageText> page, PapyrusStats *stats) {
+  if (stats) stats->Add(kStatTextCacheMisses);
+  if (!page) return nullptr;
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  lru_.push_front(pageIndex);
+  pages_[pageIndex] = {page, lru_.begin()};
+  bytes_ += page->Bytes();
+  while (bytes_ > kTextCacheBudgetBytes && lru_.size() > 1) {
+    int evicted = lru_.back();
+    lru_.pop_back();
+    auto entry = pages_.find(evicted);
+    bytes_ -= entry->second.page->Bytes();
+    pages_.erase(entry);
+    if (stats) stats->Add(kStatTextCacheEvictions);
+  }
+  return page;
+}
+
+std::shared_ptr<const PageText> DocumentTextCache::Lookup(int pageIndex) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto found = pages_.find(pageIndex);
+  if (found == pages_.end()) return nullptr;
+  lru_.splice(lru_.begin(), lru_, found->second.position);
+  return found->second.page;
+}
+
+bool DocumentTextCache::Contains(int pageIndex) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return pages_.count(pageIndex) != 0;
+}
+
+DocumentTextCache *TextCacheFor(PapyrusSession *session) {
+  if (!session || !session->document) return nullptr;
+  if (!session->textCache) {
+    session->textCache = std::make_shared<DocumentTextCache>();
+  }
+  return session->textCache.get();
+}
+
+std::shared_ptr<const PageText> GetPageText(PapyrusSession *session, int pageIndex) {
+  DocumentTextCache *cache = TextCacheFor(session);
+  if (!cache || pageIndex < 0 || pageIndex >= session->pageCount) return nullptr;
+  return cache->GetPage(session, pageIndex);
+}
+
+std::shared_ptr<const PageText> ReadPageText(PapyrusSession *session, int pageIndex) {
+  DocumentTextCache *cache = TextCacheFor(session);
+  if (!cache || pageIndex < 0 || pageIndex >= session->pageCount) return nullptr;
+  return cache->Read(session, pageIndex);
+}
+
+void PrewarmPageText(PapyrusSession *session, int pageIndex) {
+  DocumentTextCache *cache = TextCacheFor(session);
+  if (!cache || pageIndex < 0 || pageIndex >= session->pageCount) return;
+  cache->Prewarm(session, pageIndex);
+}
+
+NormRect Normalize(const PageText &page, double left, double right, double top, double bottom) {
+  float x = static_cast<float>(left / page.width);
+  float y = static_cast<float>((page.height - top) / page.height);
+  float w = static_cast<float>((right - left) / page.width);
+  float h = static_cast<float>((top - bottom) / page.height);
+  return {
+    std::max(0.0f, std::min(1.0f, x)),
+    std::max(0.0f, std::min(1.0f, y)),
+    std::max(0.0f, std::min(1.0f, w)),
+    std::max(0.0f, std::min(1.0f, h)),
+  };
+}
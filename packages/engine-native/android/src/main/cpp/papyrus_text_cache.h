@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "papyrus_glyph_index.h"
+#include "papyrus_session.h"
+#include "papyrus_text_match.h"
+
+// Text and glyph boxes of one page, extracted once and kept as flat arrays so
+// search, selection and previews never go back to PDFium for a cached page.
+struct PageText {
+  double width = 0;
+  double height = 0;
+  std::vector<unsigned short> text;
+  std::vector<float> left;
+  std::vector<float> right;
+  std::vector<float> top;
+  std::vector<float> bottom;
+  std::vector<uint8_t> hasBox;
+  GlyphIndex glyphs;
+  // Font size of the first glyph of each line of glyphs, in points; empty
+  // when PDFium cannot report it.
+  std::vector<float> lineFontSize;
+  // Text folded for the default search mode (case and diacritic insensitive).
+  FoldedText folded;
+
+  int CharCount() const { return static_cast<int>(text.size()); }
+
+  size_t Bytes() const {
+    return sizeof(PageText) + text.capacity() * sizeof(unsigned short) +
+           (left.capacity() + right.capacity() + top.capacity() + bottom.capacity()) * sizeof(float) +
+           hasBox.capacity() + glyphs.Bytes() + lineFontSize.capacity() * sizeof(float) + folded.Bytes();
+  }
+};
+
+// Per-document LRU of extracted pages, bounded by kTextCacheBudgetBytes.
+// Owned by the PapyrusSession so it lives exactly as long as the open document.
+// Lookups may come from several search workers at once; extraction itself is
+// serialized because PDFium keeps global state that is not thread-safe.
+class DocumentTextCache {
+ public:
+  std::shared_ptr<const PageText> GetPage(PapyrusSession *session, int pageIndex);
+
+  // The cached page, or a fresh extraction that is not cached.
+  std::shared_ptr<const PageText> Read(PapyrusSession *session, int pageIndex);
+
+  // Extracts and caches the page unless it is cached already; a cached page
+  // keeps its place in the LRU and counts neither as a hit nor a miss.
+  void Prewarm(PapyrusSession *session, int pageIndex);
+
+ private:
+  struct Entry {
+    std::shared_ptr<const PageText> page;
+    std::list<int>::iterator position;
+  };
+
+  std::shared_ptr<const PageText> Lookup(int pageIndex);
+  bool Contains(int pageIndex);
+
+  // Called with extractMutex_ held.
+  std::shared_ptr<const PageText> Insert(int pageIndex, std::shared_ptr<const PageText> page, PapyrusStats *stats);
+
+  std::mutex mutex_;
+  std::mutex extractMutex_;
+  size_t bytes_ = 0;
+  std::list<int> lru_;
+  std::unordered_map<int, Entry> pages_;
+};
+
+// Creates the session's cache on first use; nullptr without a document.
+DocumentTextCache *TextCacheFor(PapyrusSession *session);
+
+// nullptr for pages out of range, that PDFium cannot load, or whose data has
+// not been downloaded yet (papyrus_progressive.h).
+std::shared_ptr<const PageText> GetPageText(PapyrusSession *session, int pageIndex);
+
+// Like GetPageText, but a page that is not cached yet is extracted without
+// being added, so one pass over the whole document, such as building the
+// search index, does not evict the pages the reader is working with.
+std::shared_ptr<const PageText> ReadPageText(PapyrusSession *session, int pageIndex);
+
+// Extracts pageIndex into the text cache ahead of the first search or
+// selection that needs it. No-op for cached or out-of-range pages.
+void PrewarmPageText(PapyrusSession *session, int pageIndex);
+
+// Normalized page rect (x, y from the top-left, width, height), clamped to
+// [0, 1].
+struct NormRect {
+  float x;
+  float y;
+  float width;
+  float height;
+};
+
+NormRect Normalize(const PageText &page, double left, double right, double top, double bottom);
@@ -0,0 +1,146 @@
+#include "papyrus_text_export.h"
+
+#include "papyrus_progressive.h"
+
+#include <algorithm>
+
+#define LOG_TAG "PapyrusExport"
+#include "papyrus_log.h"
+
+TextExport::TextExport(PapyrusSession *session, int flags, const char *path)
+    : session_(session), flags_(flags), path_(path ? path : ""), chunk_(kExportChunkBytes) {
+  if (!path_.empty()) {
+    std::string temporary = path_ + ".tmp";
+    file_ = std::fopen(temporary.c_str(), "wb");
+    if (!file_) LOGE("Failed to create %s", temporary.c_str());
+  }
+  pageBytes_.reserve(session->pageCount);
+  pageChars_.reserve(session->pageCount);
+}
+
+TextExport::~TextExport() {
+  // An export closed before it completed leaves no file behind.
+  if (file_) {
+    std::fclose(file_);
+    std::remove((path_ + ".tmp").c_str());
+  }
+}
+
+void TextExport::ReadPage() {
+  int pageIndex = nextPage_++;
+  pageBytes_.push_back(bytes_);
+  pageChars_.push_back(chars_);
+  text_.clear();
+  position_ = 0;
+
+  const PdfiumFns &fns = Pdfium();
+  FPDF_PAGE page = nullptr;
+  if (PageDataReady(session_, pageIndex)) {
+    StatScope timing(session_->stats, kStatPageLoad);
+    page = fns.loadPage(session_->document, pageIndex);
+  }
+  FPDF_TEXTPAGE textPage = nullptr;
+  if (page) {
+    StatScope timing(session_->stats, kStatTextLoad);
+    textPage = fns.textLoadPage(page);
+  }
+  if (textPage) {
+    int charCount = std::max(0, fns.textCountChars(textPage));
+    text_.resize(static_cast<size_t>(charCount) + 1);
+    int written = charCount > 0 ? fns.textGetText(textPage, 0, charCount, text_.data()) : 0;
+    if (written - 1 == charCount) {
+      text_.resize(charCount);
+    } else {
+      // The bulk copy stops short when characters outside the BMP take two
+      // units; read those one by one instead.
+      text_.clear();
+      for (int i = 0; i < charCount; i++) {
+        unsigned int unicode = fns.textGetUnicode(textPage, i);
+        if (unicode > 0xFFFF && unicode <= 0x10FFFF) {
+          text_.push_back(static_cast<unsigned short>(0xD800 + ((unicode - 0x10000) >> 10)));
+          text_.push_back(static_cast<unsigned short>(0xDC00 + ((unicode - 0x10000) & 0x3FF)));
+        } else {
+          text_.push_back(unicode > 0xFFFF ? 0xFFFD : static_cast<unsigned short>(unicode));
+        }
+      }
+    }
+    fns.textClosePage(textPage);
+  }
+  if (page) fns.closePage(page);
+  text_.push_back((flags_ & kExportPageMarkers) ? '\f' : '\n');
+}
+
+bool TextExport::Next() {
+  chunkSize_ = 0;
+  uint8_t *out = chunk_.data();
+  for (;;) {
+    if (position_ == text_.size()) {
+      if (nextPage_ >= session_->pageCount) break;
+      ReadPage();
+      continue;
+    }
+    uint32_t code = text_[position_];
+    size_t units = 1;
+    if (code == '\r' && position_ + 1 < text_.size() && text_[position_ + 1] == '\n') {
+      position_++;
+      continue;
+    }
+    if (code >= 0xD800 && code <= 0xDFFF) {
+      uint32_t low = position_ + 1 < text_.size() ? text_[position_ + 1] : 0;
+      if (code <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF) {
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        units = 2;
+      } else {
+        code = 0xFFFD;
+      }
+    }
+    size_t length = code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+    if (chunkSize_ + length > chunk_.size()) break;
+
+    uint8_t *at = out + chunkSize_;
+    if (length == 1) {
+      at[0] = static_cast<uint8_t>(code);
+    } else if (length == 2) {
+      at[0] = static_cast<uint8_t>(0xC0 | (code >> 6));
+      at[1] = static_cast<uint8_t>(0x80 | (code & 0x3F));
+    } else if (length == 3) {
+      at[0] = static_cast<uint8_t>(0xE0 | (code >> 12));
+      at[1] = static_cast<uint8_t>(0x80 | ((code >> 6) & 0x3F));
+      at[2] = static_cast<uint8_t>(0x80 | (code & 0x3F));
+    } else {
+      at[0] = static_cast<uint8_t>(0xF0 | (code >> 18));
+      at[1] = static_cast<uint8_t>(0x80 | ((code >> 12) & 0x3F));
+      at[2] = static_cast<uint8_t>(0x80 | ((code >> 6) & 0x3F));
+      at[3] = static_cast<uint8_t>(0x80 | (code & 0x3F));
+    }
+    chunkSize_ += length;
+    position_ += units;
+    bytes_ += static_cast<int64_t>(length);
+    chars_ += static_cast<int64_t>(units);
+  }
+  return chunkSize_ > 0;
+}
+
+int TextExport::Write(int chunkBudget) {
+  if (complete_) return 0;
+  if (!file_) return -1;
+  for (int i = 0; i < chunkBudget; i++) {
+    if (!Next()) {
+      std::string temporary = path_ + ".tmp";
+      bool written = std::fclose(file_) == 0;
+      file_ = nullptr;
+      if (!written || std::rename(temporary.c_str(), path_.c_str()) != 0) {
+        LOGE("Failed to write %s", path_.c_str());
+        std::remove(temporary.c_str());
+        return -1;
+      }
+      complete_ = true;
+      return 0;
+    }
+    if (std::fwrite(chunk_.data(), 1, chunkSize_, file_) != chunkSize_) {
+      LOGE("Failed to write %s", path_.c_str());
+      return -1;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "papyrus_session.h"
+
+// Export option bits, shared with PapyrusTextExport.PAGE_MARKERS on the Java
+// side: end each page with a form feed, as pdftotext does, instead of a line
+// break.
+constexpr int kExportPageMarkers = 1;
+
+constexpr size_t kExportChunkBytes = 64 * 1024;
+
+// The text of the whole document as UTF-8, produced one chunk of at most
+// kExportChunkBytes at a time. Pages are read straight from PDFium, one at a
+// time, without their glyph boxes and without going through the text cache,
+// so memory stays at one chunk plus the largest page however long the
+// document is. PDFium's "\r\n" line ends become "\n".
+//
+// Either hands each chunk to the caller (Next) or appends it to a file
+// (Write); the file is written next to its path and renamed into place once
+// complete. Callers serialize access through the engine's pdfiumLock, and may
+// release it between calls.
+class TextExport {
+ public:
+  // path may be null for chunks handed to the caller.
+  TextExport(PapyrusSession *session, int flags, const char *path);
+  ~TextExport();
+
+  TextExport(const TextExport &) = delete;
+  TextExport &operator=(const TextExport &) = delete;
+
+  // False if the file could not be created.
+  bool Ok() const { return path_.empty() || file_ || complete_; }
+
+  // Fills the chunk with the next bytes; false, with an empty chunk, once the
+  // last page was exported.
+  bool Next();
+  const uint8_t *Chunk() const { return chunk_.data(); }
+  size_t ChunkSize() const { return chunkSize_; }
+
+  // Writes up to chunkBudget chunks to the file: 1 while pages remain, 0 once
+  // the file is complete, -1 on a write error.
+  int Write(int chunkBudget);
+
+  // Totals so far, in UTF-8 bytes and in UTF-16 units (JS string length).
+  int64_t Bytes() const { return bytes_; }
+  int64_t Chars() const { return chars_; }
+
+  // Where each page exported so far starts, in bytes and in UTF-16 units.
+  const std::vector<int64_t> &PageBytes() const { return pageBytes_; }
+  const std::vector<int64_t> &PageChars() const { return pageChars_; }
+
+ private:
+  // Reads the next page into text_, followed by its separator.
+  void ReadPage();
+
+  PapyrusSession *session_;
+  int flags_;
+  std::string path_;
+  FILE *file_ = nullptr;
+  bool complete_ = false;
+  int nextPage_ = 0;
+  // The page being exported, as UTF-16, and how far into it the chunks are.
+  std::vector<unsigned short> text_;
+  size_t position_ = 0;
+  std::vector<uint8_t> chunk_;
+  size_t chunkSize_ = 0;
+  int64_t bytes_ = 0;
+  int64_t chars_ = 0;
+  std::vector<int64_t> pageBytes_;
+  std::vector<int64_t> pageChars_;
+};
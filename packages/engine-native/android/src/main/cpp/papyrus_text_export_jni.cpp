@@ -0,0 +1,66 @@
+#include "papyrus_jni.h"
+#include "papyrus_text_export.h"
+
+#include <vector>
+
+static jlongArray ToLongArray(JNIEnv *env, const std::vector<int64_t> &values) {
+  jlongArray array = env->NewLongArray(static_cast<jsize>(values.size()));
+  if (array) env->SetLongArrayRegion(array, 0, static_cast<jsize>(values.size()), reinterpret_cast<const jlong *>(values.data()));
+  return array;
+}
+
+// path may be null to pull the chunks through nativeNext; 0 when the file
+// cannot be created.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusTextExport_nativeOpen(JNIEnv *env, jclass, jlong sessionHandle, jint flags, jstring path) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return 0;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !session->document) return 0;
+  const char *filePath = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+  if (path && !filePath) return 0;
+  TextExport *textExport = new TextExport(session, flags, filePath);
+  if (filePath) env->ReleaseStringUTFChars(path, filePath);
+  if (!textExport->Ok()) {
+    delete textExport;
+    return 0;
+  }
+  return reinterpret_cast<jlong>(textExport);
+}
+
+// The next chunk of UTF-8 as a direct ByteBuffer over the export's own
+// buffer, valid until the next call; null once the document is exported.
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusTextExport_nativeNext(JNIEnv *env, jclass, jlong exportHandle) {
+  TextExport *textExport = reinterpret_cast<TextExport *>(exportHandle);
+  if (!textExport || !textExport->Next()) return nullptr;
+  return env->NewDirectByteBuffer(const_cast<uint8_t *>(textExport->Chunk()), static_cast<jlong>(textExport->ChunkSize()));
+}
+
+// Writes up to chunkBudget chunks to the export's file: 1 while pages remain,
+// 0 once the file is in place, -1 on error.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_papyrus_engine_PapyrusTextExport_nativeWrite(JNIEnv *, jclass, jlong exportHandle, jint chunkBudget) {
+  TextExport *textExport = reinterpret_cast<TextExport *>(exportHandle);
+  return textExport ? textExport->Write(chunkBudget) : -1;
+}
+
+// {bytes, chars} exported so far.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_papyrus_engine_PapyrusTextExport_nativeProgress(JNIEnv *env, jclass, jlong exportHandle) {
+  TextExport *textExport = reinterpret_cast<TextExport *>(exportHandle);
+  if (!textExport) return nullptr;
+  return ToLongArray(env, {textExport->Bytes(), textExport->Chars()});
+}
+
+// Where each page exported so far starts, in UTF-8 bytes or in UTF-16 units.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_papyrus_engine_PapyrusTextExport_nativePageOffsets(JNIEnv *env, jclass, jlong exportHandle, jboolean bytes) {
+  TextExport *textExport = reinterpret_cast<TextExport *>(exportHandle);
+  if (!textExport) return nullptr;
+  return ToLongArray(env, bytes ? textExport->PageBytes() : textExport->PageChars());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusTextExport_nativeClose(JNIEnv *, jclass, jlong exportHandle) {
+  delete reinterpret_cast<TextExport *>(exportHandle);
+}
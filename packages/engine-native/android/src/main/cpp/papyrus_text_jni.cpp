@@ -0,0 +1,119 @@
+#include "papyrus_jni.h"
+#include "papyrus_search_index.h"
+#include "papyrus_text_search.h"
+#include "papyrus_text_runs.h"
+#include "papyrus_text_select.h"
+
+#include <vector>
+
+static std::vector<unsigned short> ToWideQuery(JNIEnv *env, jstring query) {
+  std::vector<unsigned short> wideQuery;
+  if (!query) return wideQuery;
+  const jchar *queryChars = env->GetStringChars(query, nullptr);
+  jsize queryLen = env->GetStringLength(query);
+  if (queryChars && queryLen > 0) {
+    wideQuery.assign(queryChars, queryChars + queryLen);
+  }
+  if (queryChars) env->ReleaseStringChars(query, queryChars);
+  return wideQuery;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeCursorOpen(JNIEnv *env, jclass, jlong sessionHandle, jstring query, jint flags) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return 0;
+  std::vector<unsigned short> wideQuery = ToWideQuery(env, query);
+  SearchCursor *cursor = OpenSearchCursor(SessionFromHandle(sessionHandle), wideQuery.data(), static_cast<int>(wideQuery.size()), flags);
+  return reinterpret_cast<jlong>(cursor);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeTermsOpen(JNIEnv *env, jclass, jlong sessionHandle, jobjectArray terms, jint flags) {
+  if (!EnsurePdfium(kPdfiumLibrary) || !terms) return 0;
+  jsize termCount = env->GetArrayLength(terms);
+  std::vector<std::vector<unsigned short>> wideTerms(termCount);
+  std::vector<const unsigned short *> termChars(termCount);
+  std::vector<int> termLengths(termCount);
+  for (jsize i = 0; i < termCount; i++) {
+    jstring term = static_cast<jstring>(env->GetObjectArrayElement(terms, i));
+    wideTerms[i] = ToWideQuery(env, term);
+    if (term) env->DeleteLocalRef(term);
+    termChars[i] = wideTerms[i].data();
+    termLengths[i] = static_cast<int>(wideTerms[i].size());
+  }
+  SearchCursor *cursor = OpenTermsCursor(SessionFromHandle(sessionHandle), termChars.data(), termLengths.data(), termCount, flags);
+  return reinterpret_cast<jlong>(cursor);
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeCursorNext(JNIEnv *env, jclass, jlong cursorHandle, jint pageBatch, jint workers, jint maxHits) {
+  SearchCursor *cursor = reinterpret_cast<SearchCursor *>(cursorHandle);
+  if (!cursor || SearchCursorNext(cursor, pageBatch, workers, maxHits) < 0) return nullptr;
+  return PackedResult(env, cursor->session);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeCursorPosition(JNIEnv *, jclass, jlong cursorHandle) {
+  return SearchCursorPosition(reinterpret_cast<SearchCursor *>(cursorHandle));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeCursorCancel(JNIEnv *, jclass, jlong cursorHandle) {
+  SearchCursor *cursor = reinterpret_cast<SearchCursor *>(cursorHandle);
+  if (cursor) cursor->cancelled.store(true);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeCursorClose(JNIEnv *, jclass, jlong cursorHandle) {
+  delete reinterpret_cast<SearchCursor *>(cursorHandle);
+}
+
+// Opens the session's search index under directory; the pages it already
+// covers, or -1 if the document cannot have one.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeIndexAttach(JNIEnv *env, jclass, jlong sessionHandle, jstring directory) {
+  if (!EnsurePdfium(kPdfiumLibrary) || !directory) return -1;
+  const char *path = env->GetStringUTFChars(directory, nullptr);
+  if (!path) return -1;
+  int indexed = AttachSearchIndex(SessionFromHandle(sessionHandle), path);
+  env->ReleaseStringUTFChars(directory, path);
+  return indexed;
+}
+
+// Indexes up to pageBudget more pages; the next page to index, or -1 once done.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_papyrus_engine_PapyrusTextSearch_nativeIndexBuild(JNIEnv *, jclass, jlong sessionHandle, jint pageBudget) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return -1;
+  return BuildSearchIndex(SessionFromHandle(sessionHandle), pageBudget);
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusTextSelect_nativeSelectText(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex, jfloat x, jfloat y, jfloat width, jfloat height) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !SelectText(session, pageIndex, x, y, width, height)) return nullptr;
+  return PackedResult(env, session);
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusTextSelect_nativeSelectWordAt(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex, jfloat x, jfloat y) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !SelectWordAt(session, pageIndex, x, y)) return nullptr;
+  return PackedResult(env, session);
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusTextSelect_nativeSelectLineAt(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex, jfloat x, jfloat y) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !SelectLineAt(session, pageIndex, x, y)) return nullptr;
+  return PackedResult(env, session);
+}
+
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_papyrus_engine_PapyrusTextSelect_nativeGetTextRuns(JNIEnv *env, jclass, jlong sessionHandle, jint pageIndex) {
+  if (!EnsurePdfium(kPdfiumLibrary)) return nullptr;
+  PapyrusSession *session = SessionFromHandle(sessionHandle);
+  if (!session || !PackTextRuns(session, pageIndex)) return nullptr;
+  return PackedResult(env, session);
+}
@@ -0,0 +1,210 @@
+#include "papyrus_text_match.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Simple lowercase mapping of U+00C0..U+024F.
+static const uint16_t kLatinLower[0x250 - 0xC0] = {
+  0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+  0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+  0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00D7,
+  0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00DF,
+  0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+  0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+  0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+  0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF,
+  0x0101, 0x0101, 0x0103, 0x0103, 0x0105, 0x0105, 0x0107, 0x0107,
+  0x0109, 0x0109, 0x010B, 0x010B, 0x010D, 0x010D, 0x010F, 0x010F,
+  0x0111, 0x0111, 0x0113, 0x0113, 0x0115, 0x0115, 0x0117, 0x0117,
+  0x0119, 0x0119, 0x011B, 0x011B, 0x011D, 0x011D, 0x011F, 0x011F,
+  0x0121, 0x0121, 0x0123, 0x0123, 0x0125, 0x0125, 0x0127, 0x0127,
+  0x0129, 0x0129, 0x012B, 0x012B, 0x012D, 0x012D, 0x012F, 0x012F,
+  0x0130, 0x0131, 0x0133, 0x0133, 0x0135, 0x0135, 0x0137, 0x0137,
+  0x0138, 0x013A, 0x013A, 0x013C, 0x013C, 0x013E, 0x013E, 0x0140,
+  0x0140, 0x0142, 0x0142, 0x0144, 0x0144, 0x0146, 0x0146, 0x0148,
+  0x0148, 0x0149, 0x014B, 0x014B, 0x014D, 0x014D, 0x014F, 0x014F,
+  0x0151, 0x0151, 0x0153, 0x0153, 0x0155, 0x0155, 0x0157, 0x0157,
+  0x0159, 0x0159, 0x015B, 0x015B, 0x015D, 0x015D, 0x015F, 0x015F,
+  0x0161, 0x0161, 0x0163, 0x0163, 0x0165, 0x0165, 0x0167, 0x0167,
+  0x0169, 0x0169, 0x016B, 0x016B, 0x016D, 0x016D, 0x016F, 0x016F,
+  0x0171, 0x0171, 0x0173, 0x0173, 0x0175, 0x0175, 0x0177, 0x0177,
+  0x00FF, 0x017A, 0x017A, 0x017C, 0x017C, 0x017E, 0x017E, 0x017F,
+  0x0180, 0x0253, 0x0183, 0x0183, 0x0185, 0x0185, 0x0254, 0x0188,
+  0x0188, 0x0256, 0x0257, 0x018C, 0x018C, 0x018D, 0x01DD, 0x0259,
+  0x025B, 0x0192, 0x0192, 0x0260, 0x0263, 0x0195, 0x0269, 0x0268,
+  0x0199, 0x0199, 0x019A, 0x019B, 0x026F, 0x0272, 0x019E, 0x0275,
+  0x01A1, 0x01A1, 0x01A3, 0x01A3, 0x01A5, 0x01A5, 0x0280, 0x01A8,
+  0x01A8, 0x0283, 0x01AA, 0x01AB, 0x01AD, 0x01AD, 0x0288, 0x01B0,
+  0x01B0, 0x028A, 0x028B, 0x01B4, 0x01B4, 0x01B6, 0x01B6, 0x0292,
+  0x01B9, 0x01B9, 0x01BA, 0x01BB, 0x01BD, 0x01BD, 0x01BE, 0x01BF,
+  0x01C0, 0x01C1, 0x01C2, 0x01C3, 0x01C6, 0x01C6, 0x01C6, 0x01C9,
+  0x01C9, 0x01C9, 0x01CC, 0x01CC, 0x01CC, 0x01CE, 0x01CE, 0x01D0,
+  0x01D0, 0x01D2, 0x01D2, 0x01D4, 0x01D4, 0x01D6, 0x01D6, 0x01D8,
+  0x01D8, 0x01DA, 0x01DA, 0x01DC, 0x01DC, 0x01DD, 0x01DF, 0x01DF,
+  0x01E1, 0x01E1, 0x01E3, 0x01E3, 0x01E5, 0x01E5, 0x01E7, 0x01E7,
+  0x01E9, 0x01E9, 0x01EB, 0x01EB, 0x01ED, 0x01ED, 0x01EF, 0x01EF,
+  0x01F0, 0x01F3, 0x01F3, 0x01F3, 0x01F5, 0x01F5, 0x0195, 0x01BF,
+  0x01F9, 0x01F9, 0x01FB, 0x01FB, 0x01FD, 0x01FD, 0x01FF, 0x01FF,
+  0x0201, 0x0201, 0x0203, 0x0203, 0x0205, 0x0205, 0x0207, 0x0207,
+  0x0209, 0x0209, 0x020B, 0x020B, 0x020D, 0x020D, 0x020F, 0x020F,
+  0x0211, 0x0211, 0x0213, 0x0213, 0x0215, 0x0215, 0x0217, 0x0217,
+  0x0219, 0x0219, 0x021B, 0x021B, 0x021D, 0x021D, 0x021F, 0x021F,
+  0x019E, 0x0221, 0x0223, 0x0223, 0x0225, 0x0225, 0x0227, 0x0227,
+  0x0229, 0x0229, 0x022B, 0x022B, 0x022D, 0x022D, 0x022F, 0x022F,
+  0x0231, 0x0231, 0x0233, 0x0233, 0x0234, 0x0235, 0x0236, 0x0237,
+  0x0238, 0x0239, 0x2C65, 0x023C, 0x023C, 0x019A, 0x2C66, 0x023F,
+  0x0240, 0x0242, 0x0242, 0x0180, 0x0289, 0x028C, 0x0247, 0x0247,
+  0x0249, 0x0249, 0x024B, 0x024B, 0x024D, 0x024D, 0x024F, 0x024F,
+};
+
+// ASCII base letter of each code point in U+00C0..U+024F, or '.' when it has none.
+static const char kLatinBase[] =
+  "AAAAAA.CEEEEIIII.NOOOOO..UUUUY.."
+  "aaaaaa.ceeeeiiii.nooooo..uuuuy.y"
+  "AaAaAaCcCcCcCcDd..EeEeEeEeEeGgGg"
+  "GgGgHh..IiIiIiIiI...JjKk.LlLlLl."
+  "...NnNnNn...OoOoOo..RrRrRrSsSsSs"
+  "SsTtTt..UuUuUuUuUuUuWwYyYZzZzZz."
+  "................................"
+  "Oo.............Uu..............."
+  ".............AaIiOoUuUuUuUuUu.Aa"
+  "Aa....GgKkOoOo..j...Gg..NnAa...."
+  "AaAaEeEeIiIiOoOoRrRrUuUuSsTt..Hh"
+  "......AaEeOoOoOoOoYy............"
+  "................";
+
+// Same for U+1E00..U+1EFF (Latin Extended Additional, mostly Vietnamese).
+static const char kLatinAdditionalBase[] =
+  "AaBbBbBbCcDdDdDdDdDdEeEeEeEeEeFf"
+  "GgHhHhHhHhHhIiIiKkKkKkLlLlLlLlMm"
+  "MmMmNnNnNnNnOoOoOoOoPpPpRrRrRrRr"
+  "SsSsSsSsSsTtTtTtTtUuUuUuUuUuVvVv"
+  "WwWwWwWwWwXxXxYyZzZzZzhtwy......"
+  "AaAaAaAaAaAaAaAaAaAaAaAaEeEeEeEe"
+  "EeEeEeEeIiIiOoOoOoOoOoOoOoOoOoOo"
+  "OoOoUuUuUuUuUuUuUuYyYyYyYy......";
+
+static const char *const kLigatures[] = {"ff", "fi", "fl", "ffi", "ffl", "st", "st"};
+
+static inline unsigned short ToLower(unsigned short c) {
+  if (c < 0x80) return (c >= 'A' && c <= 'Z') ? static_cast<unsigned short>(c + 32) : c;
+  if (c >= 0xC0 && c < 0x250) return kLatinLower[c - 0xC0];
+  if (c >= 0x391 && c <= 0x3AB && c != 0x3A2) return static_cast<unsigned short>(c + 32);
+  if (c >= 0x410 && c <= 0x42F) return static_cast<unsigned short>(c + 32);
+  if (c >= 0x400 && c <= 0x40F) return static_cast<unsigned short>(c + 80);
+  if (c >= 0x1E00 && c < 0x1F00 && c != 0x1E9E && !(c >= 0x1E96 && c <= 0x1E9F)) return static_cast<unsigned short>(c | 1);
+  if (c == 0x1E9E) return 0xDF;
+  return c;
+}
+
+static inline unsigned short StripDiacritic(unsigned short c) {
+  if (c >= 0xC0 && c < 0x250 && kLatinBase[c - 0xC0] != '.') return static_cast<unsigned short>(kLatinBase[c - 0xC0]);
+  if (c >= 0x1E00 && c < 0x1F00 && kLatinAdditionalBase[c - 0x1E00] != '.') {
+    return static_cast<unsigned short>(kLatinAdditionalBase[c - 0x1E00]);
+  }
+  return c;
+}
+
+void FoldText(const unsigned short *text, int length, int flags, FoldedText *out) {
+  bool foldCase = (flags & kMatchCase) == 0;
+  bool foldDiacritics = (flags & kMatchDiacritics) == 0;
+  out->chars.clear();
+  out->origin.clear();
+  out->chars.reserve(length);
+  out->origin.reserve(length);
+
+  auto emit = [out](unsigned short c, int index) {
+    out->chars.push_back(c);
+    out->origin.push_back(index);
+  };
+
+  for (int i = 0; i < length; i++) {
+    unsigned short c = text[i];
+    if (c == 0xAD) continue;  // Soft hyphen.
+    if (foldDiacritics && c >= 0x300 && c <= 0x36F) continue;  // Combining marks.
+    if (c >= 0xFB00 && c <= 0xFB06) {
+      for (const char *p = kLigatures[c - 0xFB00]; *p; p++) emit(static_cast<unsigned short>(*p), i);
+      continue;
+    }
+    if (foldDiacritics) c = StripDiacritic(c);
+    if (foldCase) {
+      c = ToLower(c);
+      if (c == 0xDF) {
+        emit('s', i);
+        emit('s', i);
+        continue;
+      }
+    }
+    emit(c, i);
+  }
+}
+
+static inline bool MatchesAt(const unsigned short *at, const unsigned short *needle, int needleLength) {
+  return std::memcmp(at, needle, static_cast<size_t>(needleLength) * sizeof(unsigned short)) == 0;
+}
+
+// Candidate positions are those where both the first and the last needle unit
+// match; each vector step tests that for a whole block of positions at once and
+// only the survivors are compared in full.
+int FindFolded(const unsigned short *haystack, int haystackLength, const unsigned short *needle, int needleLength, int from) {
+  if (needleLength <= 0 || from < 0) return -1;
+  int last = haystackLength - needleLength;
+  if (from > last) return -1;
+
+  int i = from;
+#if defined(__AVX2__)
+  const __m256i first = _mm256_set1_epi16(static_cast<short>(needle[0]));
+  const __m256i tail = _mm256_set1_epi16(static_cast<short>(needle[needleLength - 1]));
+  for (; i + 15 <= last; i += 16) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack + i + needleLength - 1));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(a, first), _mm256_cmpeq_epi16(b, tail))));
+    while (mask) {
+      int lane = __builtin_ctz(mask) / 2;
+      if (MatchesAt(haystack + i + lane, needle, needleLength)) return i + lane;
+      mask &= ~(3u << (lane * 2));
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i first = _mm_set1_epi16(static_cast<short>(needle[0]));
+  const __m128i tail = _mm_set1_epi16(static_cast<short>(needle[needleLength - 1]));
+  for (; i + 7 <= last; i += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack + i + needleLength - 1));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(a, first), _mm_cmpeq_epi16(b, tail))));
+    while (mask) {
+      int lane = __builtin_ctz(mask) / 2;
+      if (MatchesAt(haystack + i + lane, needle, needleLength)) return i + lane;
+      mask &= ~(3u << (lane * 2));
+    }
+  }
+#elif defined(__ARM_NEON)
+  const uint16x8_t first = vdupq_n_u16(needle[0]);
+  const uint16x8_t tail = vdupq_n_u16(needle[needleLength - 1]);
+  for (; i + 7 <= last; i += 8) {
+    uint16x8_t a = vld1q_u16(haystack + i);
+    uint16x8_t b = vld1q_u16(haystack + i + needleLength - 1);
+    uint16x8_t eq = vandq_u16(vceqq_u16(a, first), vceqq_u16(b, tail));
+    // Narrow each 16-bit lane to 8 bits: one byte of 0xFF per matching lane.
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(eq)), 0);
+    while (mask) {
+      int lane = __builtin_ctzll(mask) / 8;
+      if (MatchesAt(haystack + i + lane, needle, needleLength)) return i + lane;
+      mask &= ~(0xFFull << (lane * 8));
+    }
+  }
+#endif
+
+  for (; i <= last; i++) {
+    if (haystack[i] == needle[0] && MatchesAt(haystack + i, needle, needleLength)) return i;
+  }
+  return -1;
+}
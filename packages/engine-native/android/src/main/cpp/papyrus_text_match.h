@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Search option bits, shared with PapyrusTextSearch.MATCH_* on the Java side.
+constexpr int kMatchCase = 1;
+constexpr int kMatchDiacritics = 2;
+constexpr int kMatchWholeWord = 4;
+// Edits (0 .. 2) an approximate search tolerates, in two bits of the flags.
+constexpr int kMatchEditsShift = 8;
+constexpr int kMatchEditsMask = 3 << kMatchEditsShift;
+
+// Page text normalized for one fold mode (case and/or diacritics removed,
+// ligatures expanded). origin[k] is the index in the original text of folded
+// unit k, so a match [start, end) maps back to glyphs origin[start] ..
+// origin[end - 1].
+struct FoldedText {
+  std::vector<unsigned short> chars;
+  std::vector<int> origin;
+
+  size_t Bytes() const { return chars.capacity() * sizeof(unsigned short) + origin.capacity() * sizeof(int); }
+};
+
+// Only the kMatchCase and kMatchDiacritics bits of flags affect folding.
+void FoldText(const unsigned short *text, int length, int flags, FoldedText *out);
+
+// First occurrence of needle in haystack at or after from, or -1. Vectorized
+// with SSE2/AVX2 or NEON where the target has them.
+int FindFolded(const unsigned short *haystack, int haystackLength, const unsigned short *needle, int needleLength, int from);
@@ -0,0 +1,62 @@
+#include "papyrus_text_runs.h"
+
+#include "papyrus_packed.h"
+#include "papyrus_text_cache.h"
+
+#include <algorithm>
+#include <memory>
+
+static bool IsRunBreak(const PageText &page, int index) {
+  unsigned short c = page.text[index];
+  return !page.hasBox[index] || c == ' ' || c == '\t' || c == 0xA0 || c == 0x3000 || (c >= 0x2000 && c <= 0x200B);
+}
+
+static bool IsRightToLeft(unsigned short c) {
+  return (c >= 0x0590 && c <= 0x08FF) || (c >= 0xFB1D && c <= 0xFDFF) || (c >= 0xFE70 && c <= 0xFEFF);
+}
+
+static void AddRun(PackedWriter &writer, const PageText &page, int line, float fontSize, int first, int last) {
+  float left = page.left[first];
+  float right = page.right[first];
+  float top = page.top[first];
+  float bottom = page.bottom[first];
+  // The highest glyph bottom is the baseline unless every glyph descends.
+  float baseline = page.bottom[first];
+  bool rtl = false;
+  for (int i = first; i <= last; i++) {
+    left = std::min(left, page.left[i]);
+    right = std::max(right, page.right[i]);
+    top = std::max(top, page.top[i]);
+    bottom = std::min(bottom, page.bottom[i]);
+    baseline = std::max(baseline, page.bottom[i]);
+    rtl = rtl || IsRightToLeft(page.text[i]);
+  }
+  int32_t textOffset = writer.AddString(page.text.data() + first, last - first + 1);
+  NormRect box = Normalize(page, left, right, top, bottom);
+  int32_t rectFirst = writer.AddRect(box.x, box.y, box.width, box.height);
+  writer.AddRect(left, baseline, right - left, fontSize > 0 ? fontSize : top - bottom);
+  writer.AddRecord({textOffset, last - first + 1, rectFirst, line, rtl ? 1 : 0});
+}
+
+bool PackTextRuns(PapyrusSession *session, int pageIndex) {
+  std::shared_ptr<const PageText> page = GetPageText(session, pageIndex);
+  if (!page || page->width <= 0 || page->height <= 0) return false;
+
+  PackedWriter writer(kPackedTextRuns, 5);
+  const std::vector<GlyphLine> &lines = page->glyphs.Lines();
+  for (int l = 0; l < static_cast<int>(lines.size()); l++) {
+    float fontSize = l < static_cast<int>(page->lineFontSize.size()) ? page->lineFontSize[l] : 0.0f;
+    int first = -1;
+    for (int i = lines[l].first; i <= lines[l].last; i++) {
+      if (IsRunBreak(*page, i)) {
+        if (first >= 0) AddRun(writer, *page, l, fontSize, first, i - 1);
+        first = -1;
+      } else if (first < 0) {
+        first = i;
+      }
+    }
+    if (first >= 0) AddRun(writer, *page, l, fontSize, first, lines[l].last);
+  }
+  writer.Finish(&session->packed);
+  return true;
+}
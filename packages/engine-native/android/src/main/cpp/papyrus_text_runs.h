@@ -0,0 +1,9 @@
+#pragma once
+
+#include "papyrus_session.h"
+
+// Positioned text of a page for text layers and accessibility, packed as
+// kPackedTextRuns into the session's packed buffer: one run per
+// whitespace-separated word of each glyph line, in reading order. False for
+// pages that are out of range or cannot be loaded.
+bool PackTextRuns(PapyrusSession *session, int pageIndex);
@@ -1,408 +1,440 @@
-#include <jni.h>
-#include <android/log.h>
-#include <dlfcn.h>
+#include "papyrus_text_search.h"
 
-#include <algorithm>
-#include <cmath>
-#include <string>
-#include <vector>
-
-#define LOG_TAG "PapyrusText"
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-
-typedef void *FPDF_DOCUMENT;
-typedef void *FPDF_PAGE;
-typedef void *FPDF_TEXTPAGE;
-typedef void *FPDF_SCHHANDLE;
-typedef const unsigned short *FPDF_WIDESTRING;
-
-constexpr int kMaxHits = 200;
-
-struct PdfiumFns {
-  FPDF_PAGE (*loadPage)(FPDF_DOCUMENT, int);
-  void (*closePage)(FPDF_PAGE);
-  double (*getPageWidth)(FPDF_PAGE);
-  double (*getPageHeight)(FPDF_PAGE);
-  int (*getDocPageCount)(FPDF_DOCUMENT);
-  FPDF_DOCUMENT (*loadDocument)(const char *, const char *);
-  void (*closeDocument)(FPDF_DOCUMENT);
-  FPDF_TEXTPAGE (*textLoadPage)(FPDF_PAGE);
-  void (*textClosePage)(FPDF_TEXTPAGE);
-  FPDF_SCHHANDLE (*textFindStart)(FPDF_TEXTPAGE, FPDF_WIDESTRING, int, int);
-  int (*textFindNext)(FPDF_SCHHANDLE);
-  void (*textFindClose)(FPDF_SCHHANDLE);
-  int (*textGetSchResultIndex)(FPDF_SCHHANDLE);
-  int (*textGetSchCount)(FPDF_SCHHANDLE);
-  int (*textGetCharBox)(FPDF_TEXTPAGE, int, double *, double *, double *, double *);
-  int (*textCountChars)(FPDF_TEXTPAGE);
-  int (*textGetText)(FPDF_TEXTPAGE, int, int, unsigned short *);
-};
-
-static void *g_pdfium = nullptr;
-static PdfiumFns g_fns = {};
-static bool g_loaded = false;
-
-static bool LoadPdfium() {
-  if (g_loaded) return g_pdfium != nullptr;
-
-  g_pdfium = dlopen("libmodpdfium.so", RTLD_LAZY);
-  if (!g_pdfium) {
-    LOGE("Failed to load libmodpdfium.so");
-    g_loaded = true;
-    return false;
-  }
-
-  g_fns.loadPage = reinterpret_cast<FPDF_PAGE (*)(FPDF_DOCUMENT, int)>(dlsym(g_pdfium, "FPDF_LoadPage"));
-  g_fns.closePage = reinterpret_cast<void (*)(FPDF_PAGE)>(dlsym(g_pdfium, "FPDF_ClosePage"));
-  g_fns.getPageWidth = reinterpret_cast<double (*)(FPDF_PAGE)>(dlsym(g_pdfium, "FPDF_GetPageWidth"));
-  g_fns.getPageHeight = reinterpret_cast<double (*)(FPDF_PAGE)>(dlsym(g_pdfium, "FPDF_GetPageHeight"));
-  g_fns.getDocPageCount = reinterpret_cast<int (*)(FPDF_DOCUMENT)>(dlsym(g_pdfium, "FPDF_GetPageCount"));
-  g_fns.loadDocument = reinterpret_cast<FPDF_DOCUMENT (*)(const char *, const char *)>(dlsym(g_pdfium, "FPDF_LoadDocument"));
-  g_fns.closeDocument = reinterpret_cast<void (*)(FPDF_DOCUMENT)>(dlsym(g_pdfium, "FPDF_CloseDocument"));
-  g_fns.textLoadPage = reinterpret_cast<FPDF_TEXTPAGE (*)(FPDF_PAGE)>(dlsym(g_pdfium, "FPDFText_LoadPage"));
-  g_fns.textClosePage = reinterpret_cast<void (*)(FPDF_TEXTPAGE)>(dlsym(g_pdfium, "FPDFText_ClosePage"));
-  g_fns.textFindStart = reinterpret_cast<FPDF_SCHHANDLE (*)(FPDF_TEXTPAGE, FPDF_WIDESTRING, int, int)>(dlsym(g_pdfium, "FPDFText_FindStart"));
-  g_fns.textFindNext = reinterpret_cast<int (*)(FPDF_SCHHANDLE)>(dlsym(g_pdfium, "FPDFText_FindNext"));
-  g_fns.textFindClose = reinterpret_cast<void (*)(FPDF_SCHHANDLE)>(dlsym(g_pdfium, "FPDFText_FindClose"));
-  g_fns.textGetSchResultIndex = reinterpret_cast<int (*)(FPDF_SCHHANDLE)>(dlsym(g_pdfium, "FPDFText_GetSchResultIndex"));
-  g_fns.textGetSchCount = reinterpret_cast<int (*)(FPDF_SCHHANDLE)>(dlsym(g_pdfium, "FPDFText_GetSchCount"));
-  g_fns.textGetCharBox = reinterpret_cast<int (*)(FPDF_TEXTPAGE, int, double *, double *, double *, double *)>(dlsym(g_pdfium, "FPDFText_GetCharBox"));
-  g_fns.textCountChars = reinterpret_cast<int (*)(FPDF_TEXTPAGE)>(dlsym(g_pdfium, "FPDFText_CountChars"));
-  g_fns.textGetText = reinterpret_cast<int (*)(FPDF_TEXTPAGE, int, int, unsigned short *)>(dlsym(g_pdfium, "FPDFText_GetText"));
-
-  if (!g_fns.loadPage || !g_fns.closePage || !g_fns.getPageWidth || !g_fns.getPageHeight ||
-      !g_fns.getDocPageCount || !g_fns.loadDocument || !g_fns.closeDocument ||
-      !g_fns.textLoadPage || !g_fns.textClosePage || !g_fns.textFindStart || !g_fns.textFindNext ||
-      !g_fns.textFindClose || !g_fns.textGetSchResultIndex || !g_fns.textGetSchCount ||
-      !g_fns.textGetCharBox || !g_fns.textCountChars || !g_fns.textGetText) {
-    LOGE("Failed to load required PDFium symbols");
-    g_loaded = true;
-    return false;
-  }
-
-  g_loaded = true;
-  return true;
-}
-
-static jstring BuildPreview(JNIEnv *env, FPDF_TEXTPAGE textPage, int startIndex, int count) {
-  int totalChars = g_fns.textCountChars(textPage);
-  if (totalChars <= 0) return env->NewStringUTF("");
+#include "papyrus_packed.h"
+#include "papyrus_search_index.h"
+#include "papyrus_text_cache.h"
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+constexpr int kMaxSearchWorkers = 8;
+constexpr int kSearchShardPages = 8;
+
+// Adds the preview of a hit (20 chars of context before, 40 after the match
+// start) to the string pool and returns its (offset, length).
+static std::pair<int32_t, int32_t> AddPreview(PackedWriter &writer, const PageText &page, int startIndex, int count) {
+  int totalChars = page.CharCount();
   int previewStart = std::max(0, startIndex - 20);
-  int previewCount = std::min(totalChars - previewStart, count + 40);
-  if (previewCount <= 0) return env->NewStringUTF("");
-
-  std::vector<unsigned short> buffer(previewCount + 1, 0);
-  int written = g_fns.textGetText(textPage, previewStart, previewCount, buffer.data());
-  int length = written > 0 ? written - 1 : 0;
-  if (length <= 0) return env->NewStringUTF("");
-
-  return env->NewString(reinterpret_cast<const jchar *>(buffer.data()), length);
+  int previewCount = std::max(0, std::min(totalChars - previewStart, count + 40));
+  return {writer.AddString(page.text.data() + previewStart, previewCount), previewCount};
 }
 
-static jfloatArray BuildRect(JNIEnv *env, FPDF_TEXTPAGE textPage, FPDF_PAGE page, int startIndex, int count) {
+// Adds the bounding rect of chars [startIndex, startIndex + count) and
+// returns the number of rects added (0 or 1).
+static int32_t AddHitRect(PackedWriter &writer, const PageText &page, int startIndex, int count) {
   double left = 0;
   double right = 0;
   double top = 0;
   double bottom = 0;
   bool hasBox = false;
 
-  for (int i = 0; i < count; i++) {
-    double cLeft = 0;
-    double cRight = 0;
-    double cTop = 0;
-    double cBottom = 0;
-    if (!g_fns.textGetCharBox(textPage, startIndex + i, &cLeft, &cRight, &cBottom, &cTop)) continue;
+  for (int i = startIndex; i < startIndex + count; i++) {
+    if (!page.hasBox[i]) continue;
     if (!hasBox) {
-      left = cLeft;
-      right = cRight;
-      top = cTop;
-      bottom = cBottom;
+      left = page.left[i];
+      right = page.right[i];
+      top = page.top[i];
+      bottom = page.bottom[i];
       hasBox = true;
     } else {
-      left = std::min(left, cLeft);
-      right = std::max(right, cRight);
-      top = std::max(top, cTop);
-      bottom = std::min(bottom, cBottom);
+      left = std::min<double>(left, page.left[i]);
+      right = std::max<double>(right, page.right[i]);
+      top = std::max<double>(top, page.top[i]);
+      bottom = std::min<double>(bottom, page.bottom[i]);
     }
   }
 
-  if (!hasBox) {
-    return env->NewFloatArray(0);
-  }
-
-  double pageWidth = g_fns.getPageWidth(page);
-  double pageHeight = g_fns.getPageHeight(page);
-  if (pageWidth <= 0 || pageHeight <= 0) {
-    return env->NewFloatArray(0);
-  }
-
-  float x = static_cast<float>(left / pageWidth);
-  float y = static_cast<float>((pageHeight - top) / pageHeight);
-  float w = static_cast<float>((right - left) / pageWidth);
-  float h = static_cast<float>((top - bottom) / pageHeight);
-
-  jfloat rects[4] = {
-    std::max(0.0f, std::min(1.0f, x)),
-    std::max(0.0f, std::min(1.0f, y)),
-    std::max(0.0f, std::min(1.0f, w)),
-    std::max(0.0f, std::min(1.0f, h)),
-  };
-
-  jfloatArray array = env->NewFloatArray(4);
-  env->SetFloatArrayRegion(array, 0, 4, rects);
-  return array;
+  if (!hasBox || page.width <= 0 || page.height <= 0) return 0;
+  NormRect rect = Normalize(page, left, right, top, bottom);
+  writer.AddRect(rect.x, rect.y, rect.width, rect.height);
+  return 1;
 }
 
-static jobjectArray SearchDocument(JNIEnv *env, FPDF_DOCUMENT doc, int pageCount, const unsigned short *wideQuery, jsize queryLen) {
-  if (!doc || pageCount <= 0 || !wideQuery || queryLen <= 0) return nullptr;
-
-  jclass hitClass = env->FindClass("com/papyrus/engine/PapyrusTextHit");
-  if (!hitClass) return nullptr;
-  jmethodID ctor = env->GetMethodID(hitClass, "<init>", "(IILjava/lang/String;[F)V");
-  if (!ctor) return nullptr;
+// Matches of one page as original char ranges: starts[k] .. starts[k] +
+// lengths[k] - 1. Lengths differ from the query length when folding expanded
+// or dropped chars. patterns[k] is the term matched, for terms cursors only,
+// and distances[k] the edits of the match, for approximate cursors only.
+struct PageHits {
+  int pageIndex;
+  std::shared_ptr<const PageText> page;
+  std::vector<int> starts;
+  std::vector<int> lengths;
+  std::vector<int> patterns;
+  std::vector<int> distances;
+};
 
-  std::vector<jobject> hits;
-  hits.reserve(32);
+// Page shards dealt round-robin to per-worker deques, so every worker starts
+// near the front of the document. Idle workers steal from the back of the
+// other deques.
+class ShardQueues {
+ public:
+  struct Shard {
+    int begin;
+    int end;
+  };
 
-  for (int pageIndex = 0; pageIndex < pageCount; pageIndex++) {
-    FPDF_PAGE page = g_fns.loadPage(doc, pageIndex);
-    if (!page) continue;
-    FPDF_TEXTPAGE textPage = g_fns.textLoadPage(page);
-    if (!textPage) {
-      g_fns.closePage(page);
-      continue;
+  ShardQueues(int pageCount, int workers) : queues_(workers) {
+    int shard = 0;
+    for (int begin = 0; begin < pageCount; begin += kSearchShardPages, shard++) {
+      queues_[shard % workers].shards.push_back({begin, std::min(pageCount, begin + kSearchShardPages)});
     }
+  }
 
-    FPDF_SCHHANDLE handle = g_fns.textFindStart(textPage, wideQuery, 0, 0);
-    if (handle) {
-      int matchIndex = 0;
-      while (g_fns.textFindNext(handle)) {
-        int startIndex = g_fns.textGetSchResultIndex(handle);
-        int count = g_fns.textGetSchCount(handle);
-        int totalChars = g_fns.textCountChars(textPage);
-        if (startIndex < 0 || startIndex >= totalChars) continue;
-        if (count <= 0) count = 1;
-        if (startIndex + count > totalChars) {
-          count = std::max(1, totalChars - startIndex);
-        }
-
-        jstring preview = BuildPreview(env, textPage, startIndex, count);
-        jfloatArray rects = BuildRect(env, textPage, page, startIndex, count);
-        jobject hit = env->NewObject(hitClass, ctor, pageIndex, matchIndex, preview, rects);
-        if (hit) {
-          hits.push_back(hit);
-        }
-        matchIndex++;
-        if (static_cast<int>(hits.size()) >= kMaxHits) break;
+  bool Next(int worker, Shard *out) {
+    int count = static_cast<int>(queues_.size());
+    for (int i = 0; i < count; i++) {
+      Queue &queue = queues_[(worker + i) % count];
+      std::lock_guard<std::mutex> guard(queue.mutex);
+      if (queue.shards.empty()) continue;
+      if (i == 0) {
+        *out = queue.shards.front();
+        queue.shards.pop_front();
+      } else {
+        *out = queue.shards.back();
+        queue.shards.pop_back();
       }
-      g_fns.textFindClose(handle);
+      return true;
     }
-
-    g_fns.textClosePage(textPage);
-    g_fns.closePage(page);
-    if (static_cast<int>(hits.size()) >= kMaxHits) break;
-  }
-
-  jobjectArray result = env->NewObjectArray(static_cast<jsize>(hits.size()), hitClass, nullptr);
-  for (jsize i = 0; i < static_cast<jsize>(hits.size()); i++) {
-    env->SetObjectArrayElement(result, i, hits[i]);
-  }
-
-  return result;
-}
-
-static jobject BuildSelection(JNIEnv *env, FPDF_DOCUMENT doc, int pageIndex, double normX, double normY, double normW, double normH) {
-  if (!doc || pageIndex < 0 || normW <= 0 || normH <= 0) return nullptr;
-
-  jclass selectionClass = env->FindClass("com/papyrus/engine/PapyrusTextSelection");
-  if (!selectionClass) return nullptr;
-  jmethodID ctor = env->GetMethodID(selectionClass, "<init>", "(Ljava/lang/String;[F)V");
-  if (!ctor) return nullptr;
-
-  FPDF_PAGE page = g_fns.loadPage(doc, pageIndex);
-  if (!page) return nullptr;
-  FPDF_TEXTPAGE textPage = g_fns.textLoadPage(page);
-  if (!textPage) {
-    g_fns.closePage(page);
-    return nullptr;
-  }
-
-  double pageWidth = g_fns.getPageWidth(page);
-  double pageHeight = g_fns.getPageHeight(page);
-  if (pageWidth <= 0 || pageHeight <= 0) {
-    g_fns.textClosePage(textPage);
-    g_fns.closePage(page);
-    return nullptr;
+    return false;
   }
 
-  double rectLeft = normX * pageWidth;
-  double rectTop = pageHeight - (normY * pageHeight);
-  double rectRight = rectLeft + (normW * pageWidth);
-  double rectBottom = rectTop - (normH * pageHeight);
-
-  struct LineRect {
-    double left;
-    double right;
-    double top;
-    double bottom;
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Shard> shards;
   };
 
-  std::vector<LineRect> lines;
-  std::u16string selectedText;
+  std::vector<Queue> queues_;
+};
 
-  int charCount = g_fns.textCountChars(textPage);
-  if (charCount <= 0) {
-    g_fns.textClosePage(textPage);
-    g_fns.closePage(page);
-    return nullptr;
+// Tracks the contiguous prefix of finished pages so that, once that prefix
+// holds maxHits matches, later pages are skipped exactly where the
+// sequential scan would have stopped. Pages themselves are always scanned
+// whole.
+class HitFrontier {
+ public:
+  HitFrontier(int pageCount, int maxHits) : counts_(pageCount, -1), cutoff_(pageCount - 1), maxHits_(maxHits) {}
+
+  bool Skip(int slot) const { return slot > cutoff_.load(std::memory_order_relaxed); }
+
+  void Complete(int slot, int hits) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    counts_[slot] = hits;
+    int pageCount = static_cast<int>(counts_.size());
+    while (frontier_ < pageCount && counts_[frontier_] >= 0) {
+      total_ += counts_[frontier_];
+      if (total_ >= maxHits_) {
+        cutoff_.store(frontier_, std::memory_order_relaxed);
+        frontier_ = pageCount;
+        break;
+      }
+      frontier_++;
+    }
   }
 
-  const double lineTolerance = 2.5;
-  std::vector<unsigned short> charBuffer(2, 0);
+ private:
+  std::mutex mutex_;
+  std::vector<int> counts_;
+  std::atomic<int> cutoff_;
+  int maxHits_;
+  int frontier_ = 0;
+  int total_ = 0;
+};
 
-  for (int i = 0; i < charCount; i++) {
-    double cLeft = 0;
-    double cRight = 0;
-    double cTop = 0;
-    double cBottom = 0;
-    if (!g_fns.textGetCharBox(textPage, i, &cLeft, &cRight, &cBottom, &cTop)) continue;
+// query is already folded with flags; terms, when set, replaces it, and
+// approximate, when set, matches it. candidates, indexed by page, is null when
+// every page is scanned.
+struct ScanRequest {
+  PapyrusSession *session;
+  const unsigned short *query;
+  int queryLen;
+  const TermMatcher *terms;
+  const ApproximateMatcher *approximate;
+  int flags;
+  int firstPage;
+  int endPage;
+  int maxHits;
+  const uint8_t *candidates;
+  const std::atomic<bool> *cancelled;
+};
 
-    bool intersects = !(cRight < rectLeft || cLeft > rectRight || cTop < rectBottom || cBottom > rectTop);
-    if (!intersects) continue;
+static bool IsWholeWord(const PageText &page, int start, int end) {
+  if (start > 0 && IsWordChar(page.text[start - 1]) && IsWordChar(page.text[start])) return false;
+  if (end + 1 < page.CharCount() && IsWordChar(page.text[end + 1]) && IsWordChar(page.text[end])) return false;
+  return true;
+}
 
-    int written = g_fns.textGetText(textPage, i, 1, charBuffer.data());
-    if (written > 0 && charBuffer[0] != 0) {
-      selectedText.push_back(static_cast<char16_t>(charBuffer[0]));
+static void ScanPage(const ScanRequest &request, int slot, std::vector<PageHits> &results, HitFrontier &frontier) {
+  PageHits &hits = results[slot];
+  hits.pageIndex = request.firstPage + slot;
+  if (request.candidates && !request.candidates[hits.pageIndex]) {
+    if (request.session->stats) request.session->stats->Add(kStatPagesSkipped);
+    frontier.Complete(slot, 0);
+    return;
+  }
+  std::shared_ptr<const PageText> page = GetPageText(request.session, hits.pageIndex);
+  if (page) {
+    PapyrusStats *stats = request.session->stats;
+    StatScope timing(stats, kStatFind);
+    const FoldedText *folded = &page->folded;
+    thread_local FoldedText scratch;
+    if (request.flags & (kMatchCase | kMatchDiacritics)) {
+      FoldText(page->text.data(), page->CharCount(), request.flags, &scratch);
+      folded = &scratch;
     }
 
-    bool added = false;
-    for (auto &line : lines) {
-      if (std::abs(line.top - cTop) <= lineTolerance || std::abs(line.bottom - cBottom) <= lineTolerance) {
-        line.left = std::min(line.left, cLeft);
-        line.right = std::max(line.right, cRight);
-        line.top = std::max(line.top, cTop);
-        line.bottom = std::min(line.bottom, cBottom);
-        added = true;
-        break;
+    const unsigned short *text = folded->chars.data();
+    int length = static_cast<int>(folded->chars.size());
+    if (request.terms) {
+      const TermMatcher &terms = *request.terms;
+      terms.Scan(text, length, [&](int pattern, int last) {
+        int start = folded->origin[last - terms.PatternLength(pattern) + 1];
+        int end = folded->origin[last];
+        if ((request.flags & kMatchWholeWord) && !IsWholeWord(*page, start, end)) return;
+        hits.starts.push_back(start);
+        hits.lengths.push_back(end - start + 1);
+        hits.patterns.push_back(pattern);
+      });
+    } else if (request.approximate) {
+      thread_local std::vector<ApproximateHit> found;
+      found.clear();
+      request.approximate->Find(text, length, &found);
+      for (const ApproximateHit &hit : found) {
+        int start = folded->origin[hit.start];
+        int end = folded->origin[hit.end];
+        if ((request.flags & kMatchWholeWord) && !IsWholeWord(*page, start, end)) continue;
+        hits.starts.push_back(start);
+        hits.lengths.push_back(end - start + 1);
+        hits.distances.push_back(hit.distance);
+      }
+    } else {
+      int at = FindFolded(text, length, request.query, request.queryLen, 0);
+      while (at >= 0) {
+        int start = folded->origin[at];
+        int end = folded->origin[at + request.queryLen - 1];
+        if (!(request.flags & kMatchWholeWord) || IsWholeWord(*page, start, end)) {
+          hits.starts.push_back(start);
+          hits.lengths.push_back(end - start + 1);
+        }
+        at = FindFolded(text, length, request.query, request.queryLen, at + 1);
       }
     }
-    if (!added) {
-      lines.push_back({cLeft, cRight, cTop, cBottom});
+    if (!hits.starts.empty()) hits.page = page;
+    if (stats) {
+      stats->Add(kStatPagesScanned);
+      stats->Add(kStatSearchHits, hits.starts.size());
     }
   }
+  frontier.Complete(slot, static_cast<int>(hits.starts.size()));
+}
 
-  std::vector<jfloat> rects;
-  rects.reserve(lines.size() * 4);
-  for (const auto &line : lines) {
-    float x = static_cast<float>(line.left / pageWidth);
-    float y = static_cast<float>((pageHeight - line.top) / pageHeight);
-    float w = static_cast<float>((line.right - line.left) / pageWidth);
-    float h = static_cast<float>((line.top - line.bottom) / pageHeight);
-
-    rects.push_back(std::max(0.0f, std::min(1.0f, x)));
-    rects.push_back(std::max(0.0f, std::min(1.0f, y)));
-    rects.push_back(std::max(0.0f, std::min(1.0f, w)));
-    rects.push_back(std::max(0.0f, std::min(1.0f, h)));
-  }
+static bool Cancelled(const ScanRequest &request) {
+  return request.cancelled && request.cancelled->load(std::memory_order_relaxed);
+}
 
-  jfloatArray rectArray = env->NewFloatArray(static_cast<jsize>(rects.size()));
-  if (rectArray && !rects.empty()) {
-    env->SetFloatArrayRegion(rectArray, 0, static_cast<jsize>(rects.size()), rects.data());
+// Scans [firstPage, endPage) and returns per-page hits in page order. The
+// cancel flag is checked between pages.
+static std::vector<PageHits> ScanPages(const ScanRequest &request, int workers) {
+  int pageCount = std::max(0, request.endPage - request.firstPage);
+  std::vector<PageHits> results(pageCount);
+  if (pageCount == 0) return results;
+  HitFrontier frontier(pageCount, request.maxHits);
+  TextCacheFor(request.session);
+
+  workers = std::max(1, std::min({workers, kMaxSearchWorkers, (pageCount + kSearchShardPages - 1) / kSearchShardPages}));
+  if (workers == 1) {
+    for (int slot = 0; slot < pageCount && !frontier.Skip(slot) && !Cancelled(request); slot++) {
+      ScanPage(request, slot, results, frontier);
+    }
+    return results;
   }
 
-  jstring text = selectedText.empty()
-                     ? env->NewStringUTF("")
-                     : env->NewString(reinterpret_cast<const jchar *>(selectedText.data()), static_cast<jsize>(selectedText.size()));
-
-  jobject selection = env->NewObject(selectionClass, ctor, text, rectArray);
-
-  if (rectArray) env->DeleteLocalRef(rectArray);
-  if (text) env->DeleteLocalRef(text);
-
-  g_fns.textClosePage(textPage);
-  g_fns.closePage(page);
+  ShardQueues shards(pageCount, workers);
+  auto work = [&](int worker) {
+    ShardQueues::Shard shard;
+    while (shards.Next(worker, &shard)) {
+      for (int slot = shard.begin; slot < shard.end && !frontier.Skip(slot) && !Cancelled(request); slot++) {
+        ScanPage(request, slot, results, frontier);
+      }
+    }
+  };
 
-  return selection;
+  std::vector<std::thread> threads;
+  threads.reserve(workers - 1);
+  for (int worker = 1; worker < workers; worker++) {
+    threads.emplace_back(work, worker);
+  }
+  work(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return results;
 }
 
-extern "C" JNIEXPORT jobjectArray JNICALL
-Java_com_papyrus_engine_PapyrusTextSearch_nativeSearch(JNIEnv *env, jclass, jlong docPtr, jint pageCount, jstring query) {
-  if (!LoadPdfium()) return nullptr;
-  if (!docPtr || pageCount <= 0 || query == nullptr) return nullptr;
-
-  const jchar *queryChars = env->GetStringChars(query, nullptr);
-  jsize queryLen = env->GetStringLength(query);
-  if (!queryChars || queryLen == 0) {
-    if (queryChars) env->ReleaseStringChars(query, queryChars);
-    return nullptr;
+// Record fields of kPackedSearchHits: the base six, then patternIndex for
+// terms cursors, then distance (after a patternIndex of -1) for approximate
+// ones.
+constexpr int kHitFields = 6;
+constexpr int kHitFieldsWithPattern = 7;
+constexpr int kHitFieldsWithDistance = 8;
+
+static int PackHits(PapyrusSession *session, const std::vector<PageHits> &pages, int fields) {
+  StatScope timing(session->stats, kStatPreview);
+  // Hits in page order, then closest first when ranked.
+  std::vector<std::pair<const PageHits *, int>> order;
+  for (const PageHits &pageHits : pages) {
+    if (!pageHits.page) continue;
+    for (size_t k = 0; k < pageHits.starts.size(); k++) {
+      order.emplace_back(&pageHits, static_cast<int>(k));
+    }
   }
-
-  std::vector<unsigned short> wideQuery(static_cast<size_t>(queryLen) + 1, 0);
-  for (jsize i = 0; i < queryLen; i++) {
-    wideQuery[i] = static_cast<unsigned short>(queryChars[i]);
+  if (fields == kHitFieldsWithDistance) {
+    std::stable_sort(order.begin(), order.end(), [](const auto &a, const auto &b) {
+      return a.first->distances[a.second] < b.first->distances[b.second];
+    });
   }
-  env->ReleaseStringChars(query, queryChars);
 
-  FPDF_DOCUMENT doc = reinterpret_cast<FPDF_DOCUMENT>(docPtr);
-  jobjectArray result = SearchDocument(env, doc, pageCount, wideQuery.data(), queryLen);
-  return result;
+  PackedWriter writer(kPackedSearchHits, fields);
+  for (const auto &hit : order) {
+    const PageHits &pageHits = *hit.first;
+    const PageText &page = *pageHits.page;
+    int matchIndex = hit.second;
+    int startIndex = pageHits.starts[matchIndex];
+    int length = pageHits.lengths[matchIndex];
+    std::pair<int32_t, int32_t> preview = AddPreview(writer, page, startIndex, length);
+    int32_t rectFirst = writer.RectCount();
+    int32_t rectCount = AddHitRect(writer, page, startIndex, length);
+    if (fields == kHitFieldsWithDistance) {
+      writer.AddRecord({pageHits.pageIndex, matchIndex, preview.first, preview.second, rectFirst, rectCount, -1,
+                        pageHits.distances[matchIndex]});
+    } else if (fields == kHitFieldsWithPattern) {
+      writer.AddRecord({pageHits.pageIndex, matchIndex, preview.first, preview.second, rectFirst, rectCount,
+                        pageHits.patterns[matchIndex]});
+    } else {
+      writer.AddRecord({pageHits.pageIndex, matchIndex, preview.first, preview.second, rectFirst, rectCount});
+    }
+  }
+  writer.Finish(&session->packed);
+  return writer.RecordCount();
 }
 
-extern "C" JNIEXPORT jobjectArray JNICALL
-Java_com_papyrus_engine_PapyrusTextSearch_nativeSearchFile(JNIEnv *env, jclass, jstring filePath, jstring query) {
-  if (!LoadPdfium()) return nullptr;
-  if (!filePath || !query) return nullptr;
-
-  const jchar *queryChars = env->GetStringChars(query, nullptr);
-  jsize queryLen = env->GetStringLength(query);
-  if (!queryChars || queryLen == 0) {
-    if (queryChars) env->ReleaseStringChars(query, queryChars);
-    return nullptr;
+SearchCursor *OpenSearchCursor(PapyrusSession *session, const unsigned short *query, int queryLength, int flags) {
+  if (!session || !session->document) return nullptr;
+  FoldedText folded;
+  FoldText(query, queryLength, flags, &folded);
+  if (folded.chars.empty()) return nullptr;
+
+  SearchCursor *cursor = new SearchCursor();
+  cursor->session = session;
+  cursor->query = std::move(folded.chars);
+  cursor->flags = flags;
+  int queryUnits = static_cast<int>(cursor->query.size());
+  int edits = std::min((flags & kMatchEditsMask) >> kMatchEditsShift, queryUnits / 4);
+  if (edits > 0 && queryUnits <= ApproximateMatcher::kMaxPatternLength) {
+    cursor->approximate = std::make_shared<const ApproximateMatcher>(cursor->query.data(), queryUnits, edits);
   }
-
-  std::vector<unsigned short> wideQuery(static_cast<size_t>(queryLen) + 1, 0);
-  for (jsize i = 0; i < queryLen; i++) {
-    wideQuery[i] = static_cast<unsigned short>(queryChars[i]);
+  if (!session->searchIndex) return cursor;
+  if (!cursor->approximate) {
+    session->searchIndex->Candidates(query, queryLength, &cursor->candidates);
+    return cursor;
   }
-  env->ReleaseStringChars(query, queryChars);
-
-  const char *path = env->GetStringUTFChars(filePath, nullptr);
-  if (!path) return nullptr;
-
-  FPDF_DOCUMENT doc = g_fns.loadDocument(path, nullptr);
-  env->ReleaseStringUTFChars(filePath, path);
-  if (!doc) return nullptr;
-
-  int pageCount = g_fns.getDocPageCount(doc);
-  jobjectArray result = SearchDocument(env, doc, pageCount, wideQuery.data(), queryLen);
-  g_fns.closeDocument(doc);
-
-  return result;
+  // A hit with k edits holds at least one of k + 1 pieces of the query
+  // unchanged, so pages holding none of them are ruled out.
+  std::vector<uint8_t> piecePages;
+  for (int piece = 0; piece <= edits; piece++) {
+    int begin = queryUnits * piece / (edits + 1);
+    int end = queryUnits * (piece + 1) / (edits + 1);
+    if (!session->searchIndex->Candidates(cursor->query.data() + begin, end - begin, &piecePages)) {
+      cursor->candidates.clear();
+      break;
+    }
+    if (cursor->candidates.empty()) {
+      cursor->candidates.swap(piecePages);
+    } else {
+      for (size_t page = 0; page < piecePages.size(); page++) cursor->candidates[page] |= piecePages[page];
+    }
+  }
+  return cursor;
 }
 
-extern "C" JNIEXPORT jobject JNICALL
-Java_com_papyrus_engine_PapyrusTextSelect_nativeSelectText(JNIEnv *env, jclass, jlong docPtr, jint pageIndex, jfloat x, jfloat y, jfloat width, jfloat height) {
-  if (!LoadPdfium()) return nullptr;
-  if (!docPtr) return nullptr;
-
-  FPDF_DOCUMENT doc = reinterpret_cast<FPDF_DOCUMENT>(docPtr);
-  return BuildSelection(env, doc, pageIndex, x, y, width, height);
+SearchCursor *OpenTermsCursor(PapyrusSession *session, const unsigned short *const *terms, const int *termLengths, int termCount,
+                              int flags) {
+  if (!session || !session->document || termCount <= 0) return nullptr;
+  std::vector<std::vector<unsigned short>> patterns(termCount);
+  FoldedText folded;
+  for (int i = 0; i < termCount; i++) {
+    FoldText(terms[i], termLengths[i], flags, &folded);
+    patterns[i] = std::move(folded.chars);
+  }
+  auto matcher = std::make_shared<const TermMatcher>(patterns);
+  if (matcher->Empty()) return nullptr;
+
+  SearchCursor *cursor = new SearchCursor();
+  cursor->session = session;
+  cursor->terms = std::move(matcher);
+  cursor->flags = flags;
+  // A page is a candidate if any term may occur on it, and only a term too
+  // short for the index leaves every page to scan.
+  if (session->searchIndex) {
+    std::vector<uint8_t> termPages;
+    for (int i = 0; i < termCount; i++) {
+      if (patterns[i].empty()) continue;
+      if (!session->searchIndex->Candidates(terms[i], termLengths[i], &termPages)) {
+        cursor->candidates.clear();
+        break;
+      }
+      if (cursor->candidates.empty()) {
+        cursor->candidates.swap(termPages);
+      } else {
+        for (size_t page = 0; page < termPages.size(); page++) cursor->candidates[page] |= termPages[page];
+      }
+    }
+  }
+  return cursor;
 }
 
-extern "C" JNIEXPORT jobject JNICALL
-Java_com_papyrus_engine_PapyrusTextSelect_nativeSelectTextFile(JNIEnv *env, jclass, jstring filePath, jint pageIndex, jfloat x, jfloat y, jfloat width, jfloat height) {
-  if (!LoadPdfium()) return nullptr;
-  if (!filePath) return nullptr;
-
-  const char *path = env->GetStringUTFChars(filePath, nullptr);
-  if (!path) return nullptr;
-
-  FPDF_DOCUMENT doc = g_fns.loadDocument(path, nullptr);
-  env->ReleaseStringUTFChars(filePath, path);
-  if (!doc) return nullptr;
+int SearchCursorNext(SearchCursor *cursor, int pageBatch, int workers, int maxHits) {
+  if (!cursor || cursor->cancelled.load()) return -1;
+
+  int endPage = std::min(cursor->session->pageCount, cursor->nextPage + std::max(1, pageBatch));
+  ScanRequest request = {
+    cursor->session,
+    cursor->query.data(),
+    static_cast<int>(cursor->query.size()),
+    cursor->terms.get(),
+    cursor->approximate.get(),
+    cursor->flags,
+    cursor->nextPage,
+    endPage,
+    std::max(1, maxHits),
+    cursor->candidates.empty() ? nullptr : cursor->candidates.data(),
+    &cursor->cancelled,
+  };
+  std::vector<PageHits> pages = ScanPages(request, workers);
+  if (cursor->cancelled.load()) return -1;
+
+  // Every hit of the page that filled the budget goes out with this batch, so
+  // the next one resumes on a page boundary; pages after it may have been
+  // skipped, or scanned by another worker, and are scanned again then.
+  cursor->nextPage = endPage;
+  int total = 0;
+  for (size_t slot = 0; slot < pages.size(); slot++) {
+    total += static_cast<int>(pages[slot].starts.size());
+    if (total >= request.maxHits) {
+      cursor->nextPage = request.firstPage + static_cast<int>(slot) + 1;
+      pages.resize(slot + 1);
+      break;
+    }
+  }
+  int fields = cursor->approximate ? kHitFieldsWithDistance : cursor->terms ? kHitFieldsWithPattern : kHitFields;
+  return PackHits(cursor->session, pages, fields);
+}
 
-  jobject selection = BuildSelection(env, doc, pageIndex, x, y, width, height);
-  g_fns.closeDocument(doc);
-  return selection;
+int SearchCursorPosition(const SearchCursor *cursor) {
+  if (!cursor || cursor->cancelled.load() || cursor->nextPage >= cursor->session->pageCount) return -1;
+  return cursor->nextPage;
 }
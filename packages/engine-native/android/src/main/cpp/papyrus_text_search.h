@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "papyrus_approx_match.h"
+#include "papyrus_session.h"
+#include "papyrus_term_matcher.h"
+
+// Incremental search state: each call to SearchCursorNext scans the next
+// batch of pages, stopping early once the caller's hit budget is met.
+// Cancellation may be requested from any thread and is observed between pages.
+struct SearchCursor {
+  PapyrusSession *session = nullptr;
+  std::vector<unsigned short> query;
+  // Set instead of query by OpenTermsCursor; hits then carry the index of the
+  // term they matched.
+  std::shared_ptr<const TermMatcher> terms;
+  // Set alongside query when the flags allow edits; hits then carry their
+  // distance.
+  std::shared_ptr<const ApproximateMatcher> approximate;
+  int flags = 0;
+  int nextPage = 0;
+  // Pages the session's search index says may match when the cursor opened;
+  // empty to scan every page.
+  std::vector<uint8_t> candidates;
+  std::atomic<bool> cancelled{false};
+};
+
+// Folds query with flags (kMatch* bits) and narrows the pages to scan through
+// the session's search index, if any; nullptr if nothing is left to match.
+// With kMatchEditsMask bits set, hits may be up to that many edits away, at
+// most one per four units of the folded query so that short queries do not
+// match everything; queries longer than ApproximateMatcher::kMaxPatternLength
+// only match exactly.
+SearchCursor *OpenSearchCursor(PapyrusSession *session, const unsigned short *query, int queryLength, int flags);
+
+// Finds every one of terms[0 .. termCount) in a single pass over each page.
+// Terms are folded with flags like a query, and always match exactly. nullptr
+// if no term is left to match.
+SearchCursor *OpenTermsCursor(PapyrusSession *session, const unsigned short *const *terms, const int *termLengths, int termCount,
+                              int flags);
+
+// Scans up to pageBatch pages on up to workers threads and serializes their
+// hits (kPackedSearchHits, with patternIndex for terms cursors and distance
+// for approximate ones, which come closest first) into the session's packed
+// buffer. maxHits is a soft limit: the batch stops after the page on which
+// the hits reach it, with all of that page's hits, so no hit is dropped
+// between batches. Returns the number of hits, or -1 if the cursor was
+// cancelled. Each worker takes shards of 8 pages, so a batch needs 8 pages
+// per worker to use them all. Pages not yet in the text cache are extracted
+// one at a time; workers speed up matching, not extraction.
+int SearchCursorNext(SearchCursor *cursor, int pageBatch, int workers, int maxHits);
+
+// The next page to scan, or -1 once the cursor is exhausted or cancelled.
+int SearchCursorPosition(const SearchCursor *cursor);
@@ -0,0 +1,124 @@
+#include "papyrus_text_select.h"
+
+#include "papyrus_packed.h"
+#include "papyrus_text_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// One selected run of a line: chars [first, last] and the bounds of the boxed
+// glyphs in it.
+struct SelectedLine {
+  int first;
+  int last;
+  float left;
+  float right;
+  float top;
+  float bottom;
+};
+
+static bool BuildSelection(PapyrusSession *session, const PageText &page, const std::vector<SelectedLine> &lines) {
+  if (lines.empty()) return false;
+
+  // Each run is copied straight out of the page text, generated spaces
+  // included; runs are joined by line breaks.
+  std::vector<unsigned short> selectedText;
+  PackedWriter writer(kPackedSelection, 4);
+  for (const SelectedLine &line : lines) {
+    if (!selectedText.empty()) selectedText.push_back('\n');
+    selectedText.insert(selectedText.end(), page.text.begin() + line.first, page.text.begin() + line.last + 1);
+    NormRect rect = Normalize(page, line.left, line.right, line.top, line.bottom);
+    writer.AddRect(rect.x, rect.y, rect.width, rect.height);
+  }
+  selectedText.erase(std::remove(selectedText.begin(), selectedText.end(), 0), selectedText.end());
+
+  int32_t textOffset = writer.AddString(selectedText.data(), static_cast<int>(selectedText.size()));
+  writer.AddRecord({textOffset, static_cast<int32_t>(selectedText.size()), 0, static_cast<int32_t>(lines.size())});
+  writer.Finish(&session->packed);
+  return true;
+}
+
+static SelectedLine SelectRange(const PageText &page, int first, int last) {
+  SelectedLine run = {first, last, 0, 0, 0, 0};
+  bool hasBox = false;
+  for (int i = first; i <= last; i++) {
+    if (!page.hasBox[i]) continue;
+    if (!hasBox) {
+      run.left = page.left[i];
+      run.right = page.right[i];
+      run.top = page.top[i];
+      run.bottom = page.bottom[i];
+      hasBox = true;
+    } else {
+      run.left = std::min(run.left, page.left[i]);
+      run.right = std::max(run.right, page.right[i]);
+      run.top = std::max(run.top, page.top[i]);
+      run.bottom = std::min(run.bottom, page.bottom[i]);
+    }
+  }
+  return run;
+}
+
+static std::shared_ptr<const PageText> SelectablePage(PapyrusSession *session, int pageIndex) {
+  std::shared_ptr<const PageText> page = GetPageText(session, pageIndex);
+  if (!page || page->width <= 0 || page->height <= 0 || page->glyphs.Lines().empty()) return nullptr;
+  return page;
+}
+
+bool SelectText(PapyrusSession *session, int pageIndex, double normX, double normY, double normW, double normH) {
+  if (pageIndex < 0 || normW <= 0 || normH <= 0) return false;
+  std::shared_ptr<const PageText> page = SelectablePage(session, pageIndex);
+  if (!page) return false;
+
+  float rectLeft = static_cast<float>(normX * page->width);
+  float rectTop = static_cast<float>(page->height - (normY * page->height));
+  float rectRight = static_cast<float>(rectLeft + (normW * page->width));
+  float rectBottom = static_cast<float>(rectTop - (normH * page->height));
+
+  std::vector<int> candidates;
+  page->glyphs.LinesInBand(rectBottom, rectTop, &candidates);
+
+  std::vector<SelectedLine> lines;
+  std::vector<int> glyphs;
+  for (int line : candidates) {
+    page->glyphs.GlyphsInRect(line, rectLeft, rectRight, rectBottom, rectTop, &glyphs);
+    if (glyphs.empty()) continue;
+    lines.push_back(SelectRange(*page, glyphs.front(), glyphs.back()));
+  }
+  return BuildSelection(session, *page, lines);
+}
+
+static bool SelectAtPoint(PapyrusSession *session, int pageIndex, double normX, double normY, bool wholeLine) {
+  if (pageIndex < 0) return false;
+  std::shared_ptr<const PageText> page = SelectablePage(session, pageIndex);
+  if (!page) return false;
+
+  float x = static_cast<float>(normX * page->width);
+  float y = static_cast<float>(page->height - (normY * page->height));
+  int lineIndex = page->glyphs.LineAt(x, y);
+  if (lineIndex < 0) return false;
+  const GlyphLine &line = page->glyphs.Lines()[lineIndex];
+
+  if (wholeLine) {
+    return BuildSelection(session, *page, {SelectRange(*page, line.first, line.last)});
+  }
+
+  int glyph = page->glyphs.GlyphNear(lineIndex, x);
+  if (glyph < 0) return false;
+  int first = glyph;
+  int last = glyph;
+  if (IsWordChar(page->text[glyph])) {
+    while (first > line.first && IsWordChar(page->text[first - 1])) first--;
+    while (last < line.last && IsWordChar(page->text[last + 1])) last++;
+  }
+  return BuildSelection(session, *page, {SelectRange(*page, first, last)});
+}
+
+bool SelectWordAt(PapyrusSession *session, int pageIndex, double x, double y) {
+  return SelectAtPoint(session, pageIndex, x, y, false);
+}
+
+bool SelectLineAt(PapyrusSession *session, int pageIndex, double x, double y) {
+  return SelectAtPoint(session, pageIndex, x, y, true);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "papyrus_session.h"
+
+// Selections are serialized (kPackedSelection) into the session's packed
+// buffer. Coordinates are normalized to the page, origin top-left. Each call
+// returns false, leaving the buffer untouched, when nothing is selected.
+
+bool SelectText(PapyrusSession *session, int pageIndex, double x, double y, double width, double height);
+
+// The word under (x, y), or the single glyph there if it is not a word char.
+bool SelectWordAt(PapyrusSession *session, int pageIndex, double x, double y);
+
+bool SelectLineAt(PapyrusSession *session, int pageIndex, double x, double y);
@@ -0,0 +1,286 @@
+#include "papyrus_thumbnail.h"
+
+#include "papyrus_render.h"
+#include "papyrus_search_index.h"
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define LOG_TAG "PapyrusThumbnail"
+#include "papyrus_log.h"
+
+constexpr uint32_t kThumbnailMagic = 0x48545050;  // "PPTH"
+// Bump whenever the layout, the filter or the encoding changes.
+constexpr uint32_t kThumbnailVersion = 1;
+// Larger requests are not thumbnails; the page views render those.
+constexpr int kThumbnailMaxSide = 1024;
+// Shorter runs of one pixel stay inside literals.
+constexpr size_t kMinRun = 3;
+
+struct ThumbnailHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t fingerprint;
+  int32_t pageIndex;
+  int32_t width;
+  int32_t height;
+  uint32_t payloadBytes;
+};
+
+static_assert(sizeof(ThumbnailHeader) == 32, "thumbnail header layout");
+
+static inline uint16_t PackRgb565(uint32_t r, uint32_t g, uint32_t b) {
+  return static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+static inline uint16_t *PixelRow(uint16_t *pixels, int stride, int row) {
+  return reinterpret_cast<uint16_t *>(reinterpret_cast<uint8_t *>(pixels) + static_cast<size_t>(row) * stride);
+}
+
+static inline const uint16_t *PixelRow(const uint16_t *pixels, int stride, int row) {
+  return reinterpret_cast<const uint16_t *>(reinterpret_cast<const uint8_t *>(pixels) + static_cast<size_t>(row) * stride);
+}
+
+void DownscaleToRgb565(const uint8_t *source, int sourceStride, int width, int height, uint16_t *pixels, int stride) {
+  for (int y = 0; y < height; y++) {
+    const uint8_t *top = source + static_cast<size_t>(2 * y) * sourceStride;
+    const uint8_t *bottom = top + sourceStride;
+    uint16_t *out = PixelRow(pixels, stride, y);
+    int x = 0;
+#if defined(__ARM_NEON)
+    // 16 source pixels of each row, split into channels, make 8 output pixels.
+    for (; x + 8 <= width; x += 8) {
+      uint8x16x4_t a = vld4q_u8(top + x * 8);
+      uint8x16x4_t b = vld4q_u8(bottom + x * 8);
+      uint8x8_t r = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[0]), b.val[0]), 2);
+      uint8x8_t g = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[1]), b.val[1]), 2);
+      uint8x8_t bl = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[2]), b.val[2]), 2);
+      uint16x8_t packed = vshll_n_u8(r, 8);
+      packed = vsriq_n_u16(packed, vshll_n_u8(g, 8), 5);
+      packed = vsriq_n_u16(packed, vshll_n_u8(bl, 8), 11);
+      vst1q_u16(out + x, packed);
+    }
+#elif defined(__SSE2__)
+    // 8 source pixels of each row make 4 output pixels.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    auto average = [&](__m128i upper, __m128i lower) {
+      // Channels of pixels {0, 1} and {2, 3} summed over both rows, then
+      // summed pairwise: two averaged pixels as 16-bit channels.
+      __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(upper, zero), _mm_unpacklo_epi8(lower, zero));
+      __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(upper, zero), _mm_unpackhi_epi8(lower, zero));
+      __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+      return _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+    };
+    for (; x + 4 <= width; x += 4) {
+      const __m128i *a = reinterpret_cast<const __m128i *>(top + x * 8);
+      const __m128i *b = reinterpret_cast<const __m128i *>(bottom + x * 8);
+      __m128i rgba = _mm_packus_epi16(average(_mm_loadu_si128(a), _mm_loadu_si128(b)),
+                                      average(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1)));
+      __m128i packed = _mm_or_si128(
+          _mm_or_si128(_mm_slli_epi32(_mm_and_si128(rgba, _mm_set1_epi32(0xF8)), 8),
+                       _mm_srli_epi32(_mm_and_si128(rgba, _mm_set1_epi32(0xFC00)), 5)),
+          _mm_srli_epi32(_mm_and_si128(rgba, _mm_set1_epi32(0xF80000)), 19));
+      // Narrow the 32-bit lanes with a signed pack, shifted into its range.
+      packed = _mm_packs_epi32(_mm_sub_epi32(packed, bias), _mm_sub_epi32(packed, bias));
+      packed = _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), packed);
+    }
+#endif
+    for (; x < width; x++) {
+      const uint8_t *a = top + x * 8;
+      const uint8_t *b = bottom + x * 8;
+      out[x] = PackRgb565((a[0] + a[4] + b[0] + b[4] + 2) >> 2, (a[1] + a[5] + b[1] + b[5] + 2) >> 2,
+                          (a[2] + a[6] + b[2] + b[6] + 2) >> 2);
+    }
+  }
+}
+
+bool RenderThumbnail(PapyrusSession *session, int pageIndex, int width, int height, std::vector<uint8_t> *scratch,
+                     uint16_t *pixels, int stride) {
+  if (!pixels || width <= 0 || height <= 0 || stride < width * 2) return false;
+  int sourceWidth = width * 2;
+  int sourceHeight = height * 2;
+  int sourceStride = sourceWidth * 4;
+  size_t needed = static_cast<size_t>(sourceStride) * sourceHeight;
+  if (scratch->size() < needed) scratch->resize(needed);
+  if (!RenderPageRegion(session, pageIndex, sourceWidth, sourceHeight, 0, 0, scratch->data(), sourceWidth, sourceHeight,
+                        sourceStride)) {
+    return false;
+  }
+  DownscaleToRgb565(scratch->data(), sourceStride, width, height, pixels, stride);
+  return true;
+}
+
+static void AppendVarint(std::vector<uint8_t> *out, uint32_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+static void AppendPixel(std::vector<uint8_t> *out, uint16_t pixel) {
+  out->push_back(static_cast<uint8_t>(pixel));
+  out->push_back(static_cast<uint8_t>(pixel >> 8));
+}
+
+void EncodeThumbnail(const uint16_t *pixels, int width, int height, int stride, std::vector<uint8_t> *payload) {
+  payload->clear();
+  std::vector<uint16_t> flat;
+  const uint16_t *at = pixels;
+  if (stride != width * 2) {
+    flat.resize(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+      std::copy_n(PixelRow(pixels, stride, y), width, flat.begin() + static_cast<size_t>(y) * width);
+    }
+    at = flat.data();
+  }
+
+  size_t count = static_cast<size_t>(width) * height;
+  size_t literalStart = 0;
+  auto flushLiterals = [&](size_t end) {
+    if (end == literalStart) return;
+    AppendVarint(payload, static_cast<uint32_t>(end - literalStart - 1) << 1);
+    for (size_t i = literalStart; i < end; i++) AppendPixel(payload, at[i]);
+  };
+  size_t i = 0;
+  while (i < count) {
+    size_t run = 1;
+    while (i + run < count && at[i + run] == at[i]) run++;
+    if (run >= kMinRun) {
+      flushLiterals(i);
+      AppendVarint(payload, (static_cast<uint32_t>(run - 1) << 1) | 1);
+      AppendPixel(payload, at[i]);
+      literalStart = i + run;
+    }
+    i += run;
+  }
+  flushLiterals(count);
+}
+
+bool DecodeThumbnail(const uint8_t *payload, size_t size, uint16_t *pixels, int width, int height, int stride) {
+  if (width <= 0 || height <= 0) return false;
+  const uint8_t *at = payload;
+  const uint8_t *end = payload + size;
+  size_t left = static_cast<size_t>(width) * height;
+  int x = 0;
+  int y = 0;
+  while (left > 0) {
+    uint32_t token = 0;
+    int shift = 0;
+    for (;;) {
+      if (at == end || shift > 28) return false;
+      uint8_t byte = *at++;
+      token |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      shift += 7;
+      if (!(byte & 0x80)) break;
+    }
+    bool run = token & 1;
+    size_t count = static_cast<size_t>(token >> 1) + 1;
+    if (count > left || static_cast<size_t>(end - at) < (run ? 2 : count * 2)) return false;
+    left -= count;
+    uint16_t value = run ? static_cast<uint16_t>(at[0] | (at[1] << 8)) : 0;
+    if (run) at += 2;
+    while (count > 0) {
+      uint16_t *row = PixelRow(pixels, stride, y);
+      int span = static_cast<int>(std::min<size_t>(count, static_cast<size_t>(width - x)));
+      if (run) {
+        std::fill_n(row + x, span, value);
+      } else {
+        for (int k = 0; k < span; k++, at += 2) row[x + k] = static_cast<uint16_t>(at[0] | (at[1] << 8));
+      }
+      count -= span;
+      x += span;
+      if (x == width) {
+        x = 0;
+        y++;
+      }
+    }
+  }
+  return at == end;
+}
+
+// Upper bound of EncodeThumbnail's output: a token of n pixels takes at most n
+// bytes of varint plus 2 per pixel for literals, or 2 once for a run.
+static size_t MaxPayloadBytes(int width, int height) {
+  return static_cast<size_t>(width) * height * 3;
+}
+
+static bool ReadThumbnail(const std::string &path, uint64_t fingerprint, int pageIndex, int width, int height,
+                          uint16_t *pixels, int stride) {
+  FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file) return false;
+  ThumbnailHeader header;
+  std::vector<uint8_t> payload;
+  bool read = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == kThumbnailMagic &&
+              header.version == kThumbnailVersion && header.fingerprint == fingerprint && header.pageIndex == pageIndex &&
+              header.width == width && header.height == height &&
+              header.payloadBytes <= MaxPayloadBytes(width, height);
+  if (read) {
+    payload.resize(header.payloadBytes);
+    read = std::fread(payload.data(), 1, payload.size(), file) == payload.size();
+  }
+  std::fclose(file);
+  return read && DecodeThumbnail(payload.data(), payload.size(), pixels, width, height, stride);
+}
+
+static void WriteThumbnail(const std::string &path, uint64_t fingerprint, int pageIndex, int width, int height,
+                           const uint16_t *pixels, int stride) {
+  std::vector<uint8_t> payload;
+  EncodeThumbnail(pixels, width, height, stride, &payload);
+  ThumbnailHeader header = {
+    kThumbnailMagic, kThumbnailVersion, fingerprint, pageIndex, width, height, static_cast<uint32_t>(payload.size()),
+  };
+  std::string temporary = path + ".tmp";
+  FILE *file = std::fopen(temporary.c_str(), "wb");
+  if (!file) {
+    LOGE("Failed to create %s", temporary.c_str());
+    return;
+  }
+  bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 std::fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+  written = std::fclose(file) == 0 && written;
+  if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+    LOGE("Failed to write %s", path.c_str());
+    std::remove(temporary.c_str());
+  }
+}
+
+ThumbnailResult LoadThumbnail(PapyrusSession *session, const char *directory, int pageIndex, int width, int height,
+                              uint16_t *pixels, int stride) {
+  if (!session || !session->document || pageIndex < 0 || pageIndex >= session->pageCount) return kThumbnailFailed;
+  if (width <= 0 || height <= 0 || width > kThumbnailMaxSide || height > kThumbnailMaxSide) return kThumbnailFailed;
+
+  uint64_t fingerprint = directory ? DocumentFingerprint(session) : 0;
+  std::string path;
+  if (fingerprint != 0) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/%016" PRIx64 "-%d-%dx%d.ppth", fingerprint, pageIndex, width, height);
+    path = std::string(directory) + name;
+    if (ReadThumbnail(path, fingerprint, pageIndex, width, height, pixels, stride)) {
+      // The age of a file is when it was last shown, for pruning the cache.
+      utimes(path.c_str(), nullptr);
+      if (session->stats) session->stats->Add(kStatThumbnailCacheHits);
+      return kThumbnailCached;
+    }
+  }
+
+  if (!RenderThumbnail(session, pageIndex, width, height, &session->thumbnailScratch, pixels, stride)) {
+    return kThumbnailFailed;
+  }
+  if (session->stats) session->stats->Add(kStatThumbnailsRendered);
+  if (!path.empty()) WriteThumbnail(path, fingerprint, pageIndex, width, height, pixels, stride);
+  return kThumbnailRendered;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "papyrus_session.h"
+
+// Page thumbnails for sidebars. A thumbnail is rendered at twice its size,
+// box-filtered down to RGB_565 and kept on disk under a cache directory, named
+// after the document's fingerprint (papyrus_search_index.h), the page and the
+// size, so reopening a document shows its sidebar without rendering again.
+//
+// Cached files are run-length encoded RGB_565:
+//
+//   header  magic, version, fingerprint, pageIndex, width, height, payloadBytes
+//   payload tokens over the pixels in row order: a LEB128 varint n, then
+//           (n >> 1) + 1 copies of one pixel when n is odd, or (n >> 1) + 1
+//           literal pixels when it is even; pixels are little-endian uint16
+//
+// Runs of page background make a text page a few KiB.
+
+enum ThumbnailResult : int {
+  kThumbnailFailed,
+  kThumbnailCached,
+  kThumbnailRendered,
+};
+
+// Fills pixels (width x height RGB_565, rows stride bytes apart) with the
+// page scaled to that size. Read from directory when a thumbnail of that size
+// is cached there, otherwise rendered and written there; directory may be
+// null, and documents that cannot be fingerprinted are never cached.
+ThumbnailResult LoadThumbnail(PapyrusSession *session, const char *directory, int pageIndex, int width, int height,
+                              uint16_t *pixels, int stride);
+
+// Renders the page at 2 * width x 2 * height into scratch and downscales it
+// into pixels. scratch only grows, so a sidebar of same-sized thumbnails
+// renders every one into the same buffer.
+bool RenderThumbnail(PapyrusSession *session, int pageIndex, int width, int height, std::vector<uint8_t> *scratch,
+                     uint16_t *pixels, int stride);
+
+// Averages each 2x2 block of source (2 * width x 2 * height RGBA_8888, rows
+// sourceStride bytes apart) into one RGB_565 pixel.
+void DownscaleToRgb565(const uint8_t *source, int sourceStride, int width, int height, uint16_t *pixels, int stride);
+
+// Run-length encodes width x height RGB_565 pixels into payload (replacing its
+// contents), and back. DecodeThumbnail fails on a payload that does not cover
+// exactly width x height pixels.
+void EncodeThumbnail(const uint16_t *pixels, int width, int height, int stride, std::vector<uint8_t> *payload);
+bool DecodeThumbnail(const uint8_t *payload, size_t size, uint16_t *pixels, int width, int height, int stride);
@@ -0,0 +1,32 @@
+package com.papyrus.engine;
+
+import java.nio.ByteBuffer;
+
+final class PapyrusDocumentSession {
+  static final boolean AVAILABLE;
+
+  static {
+    boolean available = false;
+    try {
+      System.loadLibrary("papyrus_text");
+      available = true;
+    } catch (Throwable ignored) {
+      available = false;
+    }
+    AVAILABLE = available;
+  }
+
+  // Maps [offset, offset + length) of fd; length < 0 runs to the end of the
+  // file. fd may be closed once this returns.
+  static native long nativeOpenFd(int fd, long offset, long length, long stats);
+
+  // Reads a direct buffer in place; it must stay reachable until nativeClose.
+  static native long nativeOpenBuffer(ByteBuffer buffer, long stats);
+
+  static native int nativeGetPageCount(long session);
+
+  // Extracts a page's text into the session cache ahead of search/selection.
+  static native void nativePrewarm(long session, int pageIndex);
+
+  static native void nativeClose(long session);
+}
@@ -0,0 +1,159 @@
+package com.papyrus.engine;
+
+import android.content.res.AssetFileDescriptor;
+import android.os.ParcelFileDescriptor;
+import android.util.Base64;
+
+import com.shockwave.pdfium.PdfDocument;
+import com.shockwave.pdfium.PdfiumCore;
+
+import java.io.Closeable;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+
+// The bytes of a loaded document, read where they are rather than copied to
+// the cache directory. A whole file is opened by both PdfiumCore and the native
+// session through one descriptor. An asset (a range of the APK) and in-memory
+// bytes (a direct buffer) are read by the native session alone, which maps the
+// range or reads the buffer in place: PdfiumCore only opens a whole file or a
+// byte[], either of which would be another copy of the document. Only without
+// the native library does PdfiumCore get such a copy. Closed after the
+// document and session.
+final class PapyrusDocumentSource implements Closeable {
+  // Base64 decoded per slice, so the heap never holds more than one slice.
+  private static final int BASE64_SLICE_CHARS = 64 * 1024;
+  private static final int CHUNK_BYTES = 64 * 1024;
+
+  private ParcelFileDescriptor descriptor;
+  private AssetFileDescriptor asset;
+  private final long offset;
+  private final long length;
+  // Read by the native session in place; must stay reachable until it closes.
+  private ByteBuffer buffer;
+
+  private PapyrusDocumentSource(ParcelFileDescriptor descriptor, AssetFileDescriptor asset, long offset, long length,
+                                ByteBuffer buffer) {
+    this.descriptor = descriptor;
+    this.asset = asset;
+    this.offset = offset;
+    this.length = length;
+    this.buffer = buffer;
+  }
+
+  // A whole file; takes ownership of descriptor.
+  static PapyrusDocumentSource ofFile(ParcelFileDescriptor descriptor) {
+    return new PapyrusDocumentSource(descriptor, null, 0, -1, null);
+  }
+
+  // An uncompressed asset: a range of the APK. Takes ownership of asset.
+  static PapyrusDocumentSource ofAsset(AssetFileDescriptor asset) {
+    return new PapyrusDocumentSource(asset.getParcelFileDescriptor(), asset, asset.getStartOffset(), asset.getLength(), null);
+  }
+
+  // A direct buffer holding the whole document, from its start to its capacity.
+  static PapyrusDocumentSource ofBuffer(ByteBuffer buffer) {
+    return new PapyrusDocumentSource(null, null, 0, -1, buffer);
+  }
+
+  // Decodes base64 straight into a direct buffer, one slice at a time. Text
+  // that does not split into whole slices, such as line-wrapped base64, is
+  // decoded in one go instead.
+  static PapyrusDocumentSource ofBase64(String base64) {
+    int chars = base64.length();
+    if (chars % 4 == 0) {
+      int padding = chars == 0 ? 0 : base64.charAt(chars - 1) != '=' ? 0 : base64.charAt(chars - 2) == '=' ? 2 : 1;
+      ByteBuffer decoded = ByteBuffer.allocateDirect(chars / 4 * 3 - padding);
+      try {
+        for (int at = 0; at < chars; at += BASE64_SLICE_CHARS) {
+          decoded.put(Base64.decode(base64.substring(at, Math.min(chars, at + BASE64_SLICE_CHARS)), Base64.DEFAULT));
+        }
+        if (!decoded.hasRemaining()) return ofBuffer(decoded);
+      } catch (IllegalArgumentException | BufferOverflowException misaligned) {
+        // Whitespace or padding inside the text; decode it whole below.
+      }
+    }
+    byte[] bytes = Base64.decode(base64, Base64.DEFAULT);
+    ByteBuffer decoded = ByteBuffer.allocateDirect(bytes.length);
+    decoded.put(bytes);
+    return ofBuffer(decoded);
+  }
+
+  // Reads a stream to its end into a direct buffer, e.g. a compressed asset,
+  // which has no range of the APK to map. sizeHint is the expected length.
+  static PapyrusDocumentSource ofStream(InputStream input, int sizeHint) throws IOException {
+    try {
+      ByteBuffer read = ByteBuffer.allocateDirect(Math.max(sizeHint, CHUNK_BYTES));
+      byte[] chunk = new byte[CHUNK_BYTES];
+      int count;
+      while ((count = input.read(chunk)) != -1) {
+        if (read.remaining() < count) {
+          ByteBuffer grown = ByteBuffer.allocateDirect(Math.max(read.capacity() * 2, read.position() + count));
+          read.flip();
+          grown.put(read);
+          read = grown;
+        }
+        read.put(chunk, 0, count);
+      }
+      if (read.position() == read.capacity()) return ofBuffer(read);
+      // Direct buffers cannot shrink; the session reads up to the capacity.
+      ByteBuffer exact = ByteBuffer.allocateDirect(read.position());
+      read.flip();
+      exact.put(read);
+      return ofBuffer(exact);
+    } finally {
+      input.close();
+    }
+  }
+
+  // The PdfiumCore document over a whole file. null for sources the native
+  // session reads alone; without the native library, a copy of their bytes.
+  PdfDocument openCore(PdfiumCore pdfium) throws IOException {
+    if (asset == null && buffer == null) return pdfium.newDocument(descriptor);
+    if (PapyrusDocumentSession.AVAILABLE) return null;
+    return pdfium.newDocument(readBytes());
+  }
+
+  // Opens the native session over the same bytes; 0 when it cannot.
+  long openSession(long stats) {
+    if (buffer != null) return PapyrusDocumentSession.nativeOpenBuffer(buffer, stats);
+    if (descriptor == null) return 0;
+    return PapyrusDocumentSession.nativeOpenFd(descriptor.getFd(), offset, length, stats);
+  }
+
+  private byte[] readBytes() throws IOException {
+    if (buffer != null) {
+      byte[] bytes = new byte[buffer.capacity()];
+      ByteBuffer view = buffer.duplicate();
+      view.clear();
+      view.get(bytes);
+      return bytes;
+    }
+    byte[] bytes = new byte[(int) length];
+    try (InputStream input = asset.createInputStream()) {
+      int at = 0;
+      while (at < bytes.length) {
+        int read = input.read(bytes, at, bytes.length - at);
+        if (read < 0) throw new IOException("Unexpected end of PDF asset");
+        at += read;
+      }
+    }
+    return bytes;
+  }
+
+  @Override
+  public void close() {
+    try {
+      if (asset != null) {
+        asset.close();
+      } else if (descriptor != null) {
+        descriptor.close();
+      }
+    } catch (IOException ignored) {
+    }
+    asset = null;
+    descriptor = null;
+    buffer = null;
+  }
+}
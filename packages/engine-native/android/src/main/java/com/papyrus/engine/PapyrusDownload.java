@@ -0,0 +1,334 @@
+package com.papyrus.engine;
+
+import android.os.ParcelFileDescriptor;
+
+import java.io.Closeable;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.RandomAccessFile;
+import java.net.HttpURLConnection;
+import java.net.URL;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+
+// An HTTP download of a PDF into a cache file that PDFium reads while it is
+// still arriving (PapyrusProgressive). The body streams in order on one
+// thread; ranges the reader needs sooner, such as a page the user jumped to,
+// are fetched with Range requests on a second one when the server accepts
+// them. Every write is reported to the native source before readers are woken.
+final class PapyrusDownload implements Closeable {
+  private static final int CHUNK_BYTES = 64 * 1024;
+  // A read that delivers nothing for this long fails the download, which
+  // wakes everything waiting on it.
+  private static final int STALL_MS = 30_000;
+
+  final File file;
+  final long length;
+  private final String uri;
+  private final boolean acceptsRanges;
+  private final HttpURLConnection connection;
+  private final RandomAccessFile output;
+  private final FileChannel channel;
+  // Guarded by progress; 0 once closed so no thread reports into a freed source.
+  private long source;
+  private final Object progress = new Object();
+  private long version;
+  private long streamed;
+  private final ArrayDeque<long[]> requests = new ArrayDeque<>();
+  // Guarded by progress; run once the download completes, fails or closes.
+  private final ArrayList<Runnable> doneListeners = new ArrayList<>();
+  // Guarded by progress; run once, on the next change of progress().
+  private final ArrayList<Runnable> progressListeners = new ArrayList<>();
+  private volatile boolean complete = false;
+  private volatile boolean failed = false;
+  private volatile boolean closed = false;
+  private Thread streamThread;
+  private Thread rangeThread;
+
+  private PapyrusDownload(String uri, File file, HttpURLConnection connection, long length, boolean acceptsRanges, long source)
+      throws IOException {
+    this.uri = uri;
+    this.file = file;
+    this.connection = connection;
+    this.length = length;
+    this.acceptsRanges = acceptsRanges;
+    this.source = source;
+    this.output = new RandomAccessFile(file, "rw");
+    this.output.setLength(length);
+    this.channel = output.getChannel();
+  }
+
+  // Connects to uri and sizes file for the body. null when the response has
+  // no length, in which case the caller downloads the file whole.
+  static PapyrusDownload connect(String uri, File file) throws IOException {
+    HttpURLConnection connection = (HttpURLConnection) new URL(uri).openConnection();
+    connection.setRequestProperty("Accept-Encoding", "identity");
+    connection.setReadTimeout(STALL_MS);
+    connection.connect();
+    if (connection.getResponseCode() >= 400) {
+      connection.disconnect();
+      throw new IOException("Failed to download PDF");
+    }
+    long length = connection.getContentLengthLong();
+    if (length <= 0) {
+      connection.disconnect();
+      return null;
+    }
+    boolean acceptsRanges = "bytes".equalsIgnoreCase(connection.getHeaderField("Accept-Ranges"));
+
+    long source;
+    try (ParcelFileDescriptor descriptor = ParcelFileDescriptor.open(file,
+        ParcelFileDescriptor.MODE_READ_WRITE | ParcelFileDescriptor.MODE_CREATE)) {
+      source = PapyrusProgressive.nativeSourceCreate(descriptor.getFd(), length);
+    }
+    if (source == 0) {
+      connection.disconnect();
+      return null;
+    }
+    try {
+      return new PapyrusDownload(uri, file, connection, length, acceptsRanges, source);
+    } catch (IOException error) {
+      PapyrusProgressive.nativeSourceRelease(source);
+      connection.disconnect();
+      throw error;
+    }
+  }
+
+  void start() {
+    streamThread = new Thread(this::stream, "papyrus-download");
+    streamThread.setDaemon(true);
+    streamThread.start();
+    if (acceptsRanges) {
+      rangeThread = new Thread(this::fetchRanges, "papyrus-download-ranges");
+      rangeThread.setDaemon(true);
+      rangeThread.start();
+    }
+  }
+
+  // The native source handle; valid until close().
+  long source() {
+    synchronized (progress) {
+      return source;
+    }
+  }
+
+  // Runs listener once the download completes, fails or is closed: on the
+  // thread that ends it, or right away if it already has.
+  void whenDone(Runnable listener) {
+    synchronized (progress) {
+      if (!complete && !isStopped()) {
+        doneListeners.add(listener);
+        return;
+      }
+    }
+    listener.run();
+  }
+
+  boolean isComplete() {
+    return complete;
+  }
+
+  // True once no more bytes will arrive without the file being complete.
+  boolean isStopped() {
+    return failed || closed;
+  }
+
+  // Changes whenever bytes arrive or the download stops; taken before checking
+  // the document so awaitProgress and whenProgress cannot miss a write in
+  // between.
+  long progress() {
+    synchronized (progress) {
+      return version;
+    }
+  }
+
+  // Waits until progress() moves past mark. False if the download stopped or
+  // nothing arrived within timeoutMs.
+  boolean awaitProgress(long mark, long timeoutMs) {
+    long deadline = System.currentTimeMillis() + timeoutMs;
+    synchronized (progress) {
+      while (version == mark && !complete && !isStopped()) {
+        long left = deadline - System.currentTimeMillis();
+        if (left <= 0) return false;
+        try {
+          progress.wait(left);
+        } catch (InterruptedException interrupted) {
+          Thread.currentThread().interrupt();
+          return false;
+        }
+      }
+      return version != mark || complete;
+    }
+  }
+
+  // Runs listener once progress() moves past mark: on the thread that moves it,
+  // or right away if it already has. Unlike awaitProgress it never blocks, so
+  // scheduler jobs use it to requeue themselves instead of waiting.
+  void whenProgress(long mark, Runnable listener) {
+    synchronized (progress) {
+      if (version == mark && !complete && !isStopped()) {
+        progressListeners.add(listener);
+        return;
+      }
+    }
+    listener.run();
+  }
+
+  // Queues the ranges PDFium asked for that the sequential stream has not
+  // reached yet. Without range support they simply arrive in order.
+  void requestPending() {
+    synchronized (progress) {
+      if (source == 0) return;
+      long[] pending = PapyrusProgressive.nativeSourceTakeRequests(source);
+      if (pending == null || !acceptsRanges) return;
+      for (int i = 0; i + 1 < pending.length; i += 2) {
+        if (pending[i] + pending[i + 1] <= streamed) continue;
+        requests.add(new long[] {pending[i], pending[i + 1]});
+      }
+      progress.notifyAll();
+    }
+  }
+
+  @Override
+  public void close() {
+    synchronized (progress) {
+      if (closed) return;
+      closed = true;
+      if (source != 0) {
+        PapyrusProgressive.nativeSourceRelease(source);
+        source = 0;
+      }
+      requests.clear();
+      progress.notifyAll();
+    }
+    finish();
+    connection.disconnect();
+    if (streamThread != null) streamThread.interrupt();
+    if (rangeThread != null) rangeThread.interrupt();
+    try {
+      output.close();
+    } catch (IOException ignored) {
+    }
+  }
+
+  private void finish() {
+    ArrayList<Runnable> listeners;
+    synchronized (progress) {
+      listeners = new ArrayList<>(doneListeners);
+      doneListeners.clear();
+    }
+    for (Runnable listener : listeners) {
+      listener.run();
+    }
+    progressed();
+  }
+
+  // Runs the progress listeners; called without the lock after version moved.
+  private void progressed() {
+    ArrayList<Runnable> listeners;
+    synchronized (progress) {
+      if (progressListeners.isEmpty()) return;
+      listeners = new ArrayList<>(progressListeners);
+      progressListeners.clear();
+    }
+    for (Runnable listener : listeners) {
+      listener.run();
+    }
+  }
+
+  private void stream() {
+    try (InputStream input = connection.getInputStream()) {
+      byte[] chunk = new byte[CHUNK_BYTES];
+      long position = 0;
+      int read;
+      while (!closed && position < length && (read = input.read(chunk, 0, (int) Math.min(chunk.length, length - position))) != -1) {
+        write(chunk, read, position);
+        position += read;
+        synchronized (progress) {
+          streamed = position;
+        }
+      }
+      if (closed) return;
+      if (position < length) throw new IOException("PDF download ended early");
+      synchronized (progress) {
+        complete = true;
+        version++;
+        progress.notifyAll();
+      }
+    } catch (IOException error) {
+      synchronized (progress) {
+        failed = !closed;
+        version++;
+        progress.notifyAll();
+      }
+    } finally {
+      connection.disconnect();
+    }
+    finish();
+  }
+
+  private void fetchRanges() {
+    while (true) {
+      long[] range;
+      synchronized (progress) {
+        while (requests.isEmpty() && !closed && !complete && !failed) {
+          try {
+            progress.wait();
+          } catch (InterruptedException interrupted) {
+            return;
+          }
+        }
+        if (closed || complete || failed) return;
+        range = requests.poll();
+        // The sequential stream may have caught up while this one waited.
+        if (range[0] + range[1] <= streamed) continue;
+      }
+      try {
+        fetchRange(range[0], range[1]);
+      } catch (IOException ignored) {
+        // The sequential stream still delivers these bytes, just later.
+      }
+    }
+  }
+
+  private void fetchRange(long offset, long size) throws IOException {
+    HttpURLConnection ranged = (HttpURLConnection) new URL(uri).openConnection();
+    ranged.setRequestProperty("Accept-Encoding", "identity");
+    ranged.setReadTimeout(STALL_MS);
+    ranged.setRequestProperty("Range", "bytes=" + offset + "-" + (offset + size - 1));
+    try {
+      ranged.connect();
+      if (ranged.getResponseCode() != HttpURLConnection.HTTP_PARTIAL) return;
+      try (InputStream input = ranged.getInputStream()) {
+        byte[] chunk = new byte[(int) Math.min(CHUNK_BYTES, size)];
+        long position = offset;
+        long end = offset + size;
+        int read;
+        while (!closed && position < end && (read = input.read(chunk, 0, (int) Math.min(chunk.length, end - position))) != -1) {
+          write(chunk, read, position);
+          position += read;
+        }
+      }
+    } finally {
+      ranged.disconnect();
+    }
+  }
+
+  private void write(byte[] bytes, int count, long position) throws IOException {
+    ByteBuffer buffer = ByteBuffer.wrap(bytes, 0, count);
+    long at = position;
+    while (buffer.hasRemaining()) {
+      at += channel.write(buffer, at);
+    }
+    synchronized (progress) {
+      if (source == 0) return;
+      PapyrusProgressive.nativeSourceReceived(source, position, count);
+      version++;
+      progress.notifyAll();
+    }
+    progressed();
+  }
+}
@@ -1,36 +1,69 @@
 package com.papyrus.engine;
 
 import android.content.Context;
-import android.os.ParcelFileDescriptor;
 
+import com.facebook.react.bridge.Promise;
 import com.shockwave.pdfium.PdfDocument;
 import com.shockwave.pdfium.PdfiumCore;
 
 import java.io.File;
-import java.io.IOException;
 import java.util.Map;
 import java.util.UUID;
 import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicInteger;
 
 final class PapyrusEngineStore {
   static final class EngineState {
     final PdfiumCore pdfium;
     final Object pdfiumLock = new Object();
-    volatile boolean isSearching = false;
+    final PapyrusScheduler scheduler = new PapyrusScheduler("papyrus-engine");
+    final PapyrusStats stats = new PapyrusStats();
+    final PapyrusTilePool tiles = new PapyrusTilePool();
+    final PapyrusPageCache pageCache = new PapyrusPageCache();
+    final PapyrusThumbnailPool thumbnails = new PapyrusThumbnailPool();
+    volatile int searchWorkers = 1;
+    volatile boolean prewarm = false;
+    volatile boolean progressive = false;
+    // Where search indexes are kept, or null when they are disabled.
+    volatile File searchIndexDir;
+    // Where thumbnails are cached, or null when they are not.
+    volatile File thumbnailDir;
+    // Coalescing key for the current-page prewarm job.
+    final Object prewarmKey = new Object();
+    // Coalescing key for the background search index build.
+    final Object searchIndexKey = new Object();
+    // null when the session reads the source alone (PapyrusDocumentSource).
     PdfDocument document;
-    ParcelFileDescriptor fileDescriptor;
-    String sourcePath;
+    PapyrusDocumentSource source;
+    // Set while a progressive load is downloading; document stays null until
+    // the download completes and the session reads the partial file meanwhile.
+    volatile PapyrusDownload download;
+    long session;
+    final Map<Integer, PapyrusSearchCursor> searchCursors = new ConcurrentHashMap<>();
+    final AtomicInteger nextSearchCursorId = new AtomicInteger(1);
+    final Map<Integer, PapyrusTextExport> textExports = new ConcurrentHashMap<>();
+    final AtomicInteger nextTextExportId = new AtomicInteger(1);
 
     EngineState(PdfiumCore pdfium) {
       this.pdfium = pdfium;
     }
+
+    // True once either PdfiumCore or the native session can read the document.
+    boolean hasDocument() {
+      return document != null || session != 0;
+    }
   }
 
+  // How long opening a document waits for a download that delivers nothing.
+  private static final long DOWNLOAD_STALL_MS = 30_000;
+
   private static final Map<String, EngineState> ENGINES = new ConcurrentHashMap<>();
 
   static String createEngine(Context context) {
     String engineId = UUID.randomUUID().toString();
-    ENGINES.put(engineId, new EngineState(new PdfiumCore(context)));
+    EngineState state = new EngineState(new PdfiumCore(context));
+    state.thumbnailDir = new File(context.getCacheDir(), "papyrus-thumbnails");
+    ENGINES.put(engineId, state);
     return engineId;
   }
 
@@ -41,31 +74,208 @@ final class PapyrusEngineStore {
   static void destroyEngine(String engineId) {
     EngineState state = ENGINES.remove(engineId);
     if (state == null) return;
+    state.scheduler.shutdown();
+    synchronized (state.pdfiumLock) {
+      closeSession(state);
+    }
+    state.stats.close();
+    state.tiles.clear();
+    state.thumbnails.clear();
+    state.pageCache.clear();
     if (state.document != null) {
       state.pdfium.closeDocument(state.document);
       state.document = null;
     }
-    if (state.fileDescriptor != null) {
-      try {
-        state.fileDescriptor.close();
-      } catch (IOException ignored) {
-      }
-      state.fileDescriptor = null;
+    if (state.source != null) {
+      state.source.close();
+      state.source = null;
+    }
+    if (state.download != null) {
+      state.download.close();
+      state.download = null;
     }
   }
 
-  static void setDocument(EngineState state, PdfDocument document, ParcelFileDescriptor fd, String sourcePath) {
+  static void setDocument(EngineState state, PdfDocument document, PapyrusDocumentSource source) {
+    synchronized (state.pdfiumLock) {
+      closeSession(state);
+    }
     if (state.document != null) {
       state.pdfium.closeDocument(state.document);
     }
-    if (state.fileDescriptor != null) {
+    if (state.source != null) {
+      state.source.close();
+    }
+    if (state.download != null) {
+      state.download.close();
+      state.download = null;
+    }
+    state.document = document;
+    state.source = source;
+    state.pageCache.clear();
+    synchronized (state.pdfiumLock) {
+      openSession(state);
+    }
+  }
+
+  // Page count from PdfiumCore, or from the session while downloading. Called
+  // with pdfiumLock held.
+  static int pageCount(EngineState state) {
+    if (state.document != null) return state.pdfium.getPageCount(state.document);
+    return state.session != 0 ? PapyrusDocumentSession.nativeGetPageCount(state.session) : 0;
+  }
+
+  // {width, height} of the page in points as the session reads it, or null.
+  static float[] sessionPageSize(EngineState state, int pageIndex) {
+    if (!PapyrusRender.AVAILABLE) return null;
+    try {
+      synchronized (state.pdfiumLock) {
+        return state.session != 0 ? PapyrusRender.nativeGetPageSize(state.session, pageIndex) : null;
+      }
+    } catch (Throwable ignored) {
+      return null;
+    }
+  }
+
+  // Replaces the loaded document with a download in progress, read by a
+  // progressive session until it completes. The session is 0 if it could not
+  // be opened.
+  static void setDownload(EngineState state, PapyrusDownload download) {
+    setDocument(state, null, null);
+    state.download = download;
+    synchronized (state.pdfiumLock) {
       try {
-        state.fileDescriptor.close();
-      } catch (IOException ignored) {
+        state.session = PapyrusProgressive.nativeOpen(download.source(), state.stats.handle());
+      } catch (Throwable ignored) {
+        state.session = 0;
       }
     }
+  }
+
+  // Hands the finished download to PdfiumCore. The session keeps reading the
+  // same file, now complete, so nothing already cached is invalidated.
+  static void completeDownload(EngineState state, PapyrusDownload download, PdfDocument document, PapyrusDocumentSource source) {
+    if (state.download != download) {
+      state.pdfium.closeDocument(document);
+      source.close();
+      return;
+    }
     state.document = document;
-    state.fileDescriptor = fd;
-    state.sourcePath = sourcePath;
+    state.source = source;
+    state.download = null;
+    download.close();
+  }
+
+  // Waits until the progressive session has loaded its document and returns
+  // the page count, or -1 if it never will.
+  static int awaitDocument(EngineState state, PapyrusDownload download) {
+    while (true) {
+      long mark = download.progress();
+      int status;
+      synchronized (state.pdfiumLock) {
+        if (state.download != download || state.session == 0) return -1;
+        status = PapyrusProgressive.nativePollDocument(state.session);
+        if (status == PapyrusProgressive.DOCUMENT_READY) {
+          return PapyrusDocumentSession.nativeGetPageCount(state.session);
+        }
+      }
+      if (status == PapyrusProgressive.DOCUMENT_ERROR || download.isComplete()) return -1;
+      download.requestPending();
+      if (!download.awaitProgress(mark, DOWNLOAD_STALL_MS)) return -1;
+    }
+  }
+
+  // True if pageIndex can be read now; asks for its data otherwise.
+  static boolean isPageReady(EngineState state, int pageIndex) {
+    PapyrusDownload download = state.download;
+    if (download == null) return true;
+    boolean ready;
+    synchronized (state.pdfiumLock) {
+      if (state.download != download) return true;
+      ready = state.session != 0 && PapyrusProgressive.nativeIsPageReady(state.session, pageIndex);
+    }
+    if (!ready) download.requestPending();
+    return ready;
+  }
+
+  // False if pageIndex can be read now, or never will because the download
+  // stopped. Otherwise asks for its data and returns true; retry runs once more
+  // of the download arrives, so the caller can give up the scheduler thread
+  // instead of waiting on it.
+  static boolean waitForPage(EngineState state, int pageIndex, Runnable retry) {
+    PapyrusDownload download = state.download;
+    if (download == null) return false;
+    long mark = download.progress();
+    if (isPageReady(state, pageIndex) || download.isStopped()) return false;
+    download.whenProgress(mark, retry);
+    return true;
+  }
+
+  // Queues job for when pageIndex can be read; while the page downloads the
+  // job is requeued on each progress of the download rather than run.
+  static void submitForPage(EngineState state, int priority, Promise promise, int pageIndex, Runnable job) {
+    state.scheduler.submit(priority, promise, () -> {
+      if (waitForPage(state, pageIndex, () -> submitForPage(state, priority, promise, pageIndex, job))) return;
+      job.run();
+    });
+  }
+
+  // Queues job once the download in progress has finished or stopped, and
+  // right away when there is none; for work that reads across pages.
+  static void submitAfterDownload(EngineState state, int priority, Promise promise, Runnable job) {
+    PapyrusDownload download = state.download;
+    if (download == null) {
+      state.scheduler.submit(priority, promise, job);
+    } else {
+      download.whenDone(() -> state.scheduler.submit(priority, promise, job));
+    }
+  }
+
+  static void trimMemory(int level) {
+    for (EngineState state : ENGINES.values()) {
+      state.pageCache.trimMemory(level);
+      state.tiles.clear();
+      state.thumbnails.clear();
+    }
+  }
+
+  private static void openSession(EngineState state) {
+    if (!PapyrusDocumentSession.AVAILABLE || state.source == null) return;
+    try {
+      state.session = state.source.openSession(state.stats.handle());
+    } catch (Throwable ignored) {
+      state.session = 0;
+    }
+  }
+
+  static int addSearchCursor(EngineState state, long handle) {
+    int cursorId = state.nextSearchCursorId.getAndIncrement();
+    state.searchCursors.put(cursorId, new PapyrusSearchCursor(handle));
+    return cursorId;
+  }
+
+  static int addTextExport(EngineState state, long handle, boolean toFile) {
+    int exportId = state.nextTextExportId.getAndIncrement();
+    state.textExports.put(exportId, new PapyrusTextExport(handle, toFile));
+    return exportId;
+  }
+
+  private static void closeSession(EngineState state) {
+    for (PapyrusSearchCursor cursor : state.searchCursors.values()) {
+      cursor.cancel();
+      cursor.close();
+    }
+    state.searchCursors.clear();
+    // An export still writing leaves no file behind.
+    for (PapyrusTextExport textExport : state.textExports.values()) {
+      textExport.close();
+    }
+    state.textExports.clear();
+    if (state.session == 0) return;
+    try {
+      PapyrusDocumentSession.nativeClose(state.session);
+    } catch (Throwable ignored) {
+    }
+    state.session = 0;
   }
 }
@@ -0,0 +1,27 @@
+package com.papyrus.engine;
+
+import java.nio.ByteBuffer;
+
+final class PapyrusMetadata {
+  static final boolean AVAILABLE;
+
+  static {
+    boolean available = false;
+    try {
+      System.loadLibrary("papyrus_text");
+      available = true;
+    } catch (Throwable ignored) {
+      available = false;
+    }
+    AVAILABLE = available;
+  }
+
+  // Size, rotation and label of every page, without loading any.
+  static native ByteBuffer nativeGetPageMetadata(long session);
+
+  // The page's links, indexed on first use so later taps do not load it.
+  static native ByteBuffer nativeGetPageLinks(long session, int pageIndex);
+
+  // The link under a normalized point, if any.
+  static native ByteBuffer nativeGetLinkAt(long session, int pageIndex, float x, float y);
+}
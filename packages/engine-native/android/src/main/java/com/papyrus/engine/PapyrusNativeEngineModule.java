@@ -1,7 +1,10 @@
 package com.papyrus.engine;
 
+import android.content.ComponentCallbacks2;
 import android.content.ContentResolver;
 import android.content.Context;
+import android.content.res.AssetFileDescriptor;
+import android.content.res.Configuration;
 import android.net.Uri;
 import android.os.ParcelFileDescriptor;
 import android.view.View;
@@ -22,21 +25,64 @@ import com.facebook.react.uimanager.UIManagerModule;
 import com.shockwave.pdfium.PdfDocument;
 
 import java.io.File;
+import java.io.FileNotFoundException;
 import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.net.HttpURLConnection;
 import java.net.URL;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
+import java.util.function.LongUnaryOperator;
 
 public class PapyrusNativeEngineModule extends ReactContextBaseJavaModule {
+  // Pages per search worker in each searchText batch: one native shard
+  // (kSearchShardPages) apiece, so every worker has a shard to scan.
+  private static final int SEARCH_TEXT_BATCH_PAGES = 8;
+  // searchText stops on the page that reaches this many hits, and returns
+  // that page whole.
+  private static final int SEARCH_TEXT_MAX_HITS = 200;
+  // Terms beyond this many are ignored by searchTermsStart.
+  private static final int SEARCH_MAX_TERMS = 1000;
+  // Pages indexed per scheduler job, and index files kept in the cache.
+  private static final int SEARCH_INDEX_BATCH_PAGES = 8;
+  private static final int SEARCH_INDEX_MAX_FILES = 32;
+  // 64 KiB chunks a text export writes to its file per scheduler job.
+  private static final int EXPORT_FILE_BATCH_CHUNKS = 16;
+  // Bytes of cached thumbnails kept across documents.
+  private static final long THUMBNAIL_CACHE_BYTES = 16L * 1024 * 1024;
+
   private final ReactApplicationContext reactContext;
   private final ExecutorService executor = Executors.newSingleThreadExecutor();
+  private final ComponentCallbacks2 memoryCallbacks = new ComponentCallbacks2() {
+    @Override
+    public void onTrimMemory(int level) {
+      PapyrusEngineStore.trimMemory(level);
+    }
+
+    @Override
+    public void onLowMemory() {
+      PapyrusEngineStore.trimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE);
+    }
+
+    @Override
+    public void onConfigurationChanged(Configuration configuration) {
+    }
+  };
 
   public PapyrusNativeEngineModule(ReactApplicationContext reactContext) {
     super(reactContext);
     this.reactContext = reactContext;
+    reactContext.registerComponentCallbacks(memoryCallbacks);
+  }
+
+  @Override
+  public void invalidate() {
+    reactContext.unregisterComponentCallbacks(memoryCallbacks);
+    super.invalidate();
   }
 
   @Override
@@ -54,6 +100,31 @@ public class PapyrusNativeEngineModule extends ReactContextBaseJavaModule {
     PapyrusEngineStore.destroyEngine(engineId);
   }
 
+  @ReactMethod
+  public void configure(String engineId, ReadableMap options) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || options == null) return;
+    if (options.hasKey("searchWorkers") && options.getType("searchWorkers") == ReadableType.Number) {
+      int cores = Runtime.getRuntime().availableProcessors();
+      state.searchWorkers = Math.max(1, Math.min(cores, options.getInt("searchWorkers")));
+    }
+    if (options.hasKey("prewarm") && options.getType("prewarm") == ReadableType.Boolean) {
+      state.prewarm = options.getBoolean("prewarm");
+    }
+    if (options.hasKey("renderCacheBytes") && options.getType("renderCacheBytes") == ReadableType.Number) {
+      state.pageCache.setBudget((long) options.getDouble("renderCacheBytes"));
+    }
+    if (options.hasKey("progressive") && options.getType("progressive") == ReadableType.Boolean) {
+      state.progressive = options.getBoolean("progressive");
+    }
+    if (options.hasKey("searchIndex") && options.getType("searchIndex") == ReadableType.Boolean) {
+      state.searchIndexDir = options.getBoolean("searchIndex") ? new File(reactContext.getCacheDir(), "papyrus-search-index") : null;
+    }
+    if (options.hasKey("thumbnailCache") && options.getType("thumbnailCache") == ReadableType.Boolean) {
+      state.thumbnailDir = options.getBoolean("thumbnailCache") ? new File(reactContext.getCacheDir(), "papyrus-thumbnails") : null;
+    }
+  }
+
   @ReactMethod
   public void load(final String engineId, final ReadableMap source, final Promise promise) {
     executor.execute(() -> {
@@ -64,31 +135,192 @@ public class PapyrusNativeEngineModule extends ReactContextBaseJavaModule {
           return;
         }
 
-        File file = materializeSource(source, reactContext);
-        if (file == null) {
+        if (state.progressive && isHttpSource(source) && PapyrusProgressive.isSupported()) {
+          PapyrusDownload download = PapyrusDownload.connect(source.getString("uri"), createTempFile(reactContext));
+          if (download != null) {
+            loadProgressive(state, download, promise);
+            return;
+          }
+        }
+
+        PapyrusDocumentSource documentSource = openSource(source, reactContext);
+        if (documentSource == null) {
           promise.reject("papyrus_invalid_source", "Unsupported PDF source");
           return;
         }
 
-        ParcelFileDescriptor fd = ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY);
-        PdfDocument document = state.pdfium.newDocument(fd);
-        PapyrusEngineStore.setDocument(state, document, fd, file.getAbsolutePath());
+        PdfDocument document;
+        try {
+          document = documentSource.openCore(state.pdfium);
+        } catch (Throwable error) {
+          documentSource.close();
+          throw error;
+        }
+        PapyrusEngineStore.setDocument(state, document, documentSource);
+        if (!state.hasDocument()) {
+          PapyrusEngineStore.setDocument(state, null, null);
+          promise.reject("papyrus_load_failed", "Failed to load PDF");
+          return;
+        }
 
-        int pageCount = state.pdfium.getPageCount(document);
+        int pageCount;
+        synchronized (state.pdfiumLock) {
+          pageCount = PapyrusEngineStore.pageCount(state);
+        }
         WritableMap result = Arguments.createMap();
         result.putInt("pageCount", pageCount);
         promise.resolve(result);
+        if (state.prewarm && pageCount > 0) {
+          state.scheduler.submit(PapyrusScheduler.PRIORITY_PREWARM, () -> prewarmPage(state, 0));
+        }
+        startSearchIndex(state);
+        pruneThumbnails(state);
       } catch (Throwable error) {
         promise.reject("papyrus_load_failed", error);
       }
     });
   }
 
+  // Resolves as soon as the session can read the document, typically once the
+  // first page of a linearized file has arrived, while the download goes on.
+  // PdfiumCore takes over the finished file later (finishDownload).
+  private static void loadProgressive(PapyrusEngineStore.EngineState state, PapyrusDownload download, Promise promise) {
+    PapyrusEngineStore.setDownload(state, download);
+    download.whenDone(() -> state.scheduler.submit(PapyrusScheduler.PRIORITY_RENDER, () -> finishDownload(state, download)));
+    download.start();
+    int pageCount = PapyrusEngineStore.awaitDocument(state, download);
+    if (pageCount < 0) {
+      promise.reject("papyrus_load_failed", "Failed to load PDF");
+      return;
+    }
+    WritableMap result = Arguments.createMap();
+    result.putInt("pageCount", pageCount);
+    promise.resolve(result);
+    if (state.prewarm && pageCount > 0) {
+      state.scheduler.submit(PapyrusScheduler.PRIORITY_PREWARM, () -> prewarmPage(state, 0));
+    }
+  }
+
+  private static void finishDownload(PapyrusEngineStore.EngineState state, PapyrusDownload download) {
+    if (state.download != download || !download.isComplete()) return;
+    PapyrusDocumentSource documentSource = null;
+    try {
+      documentSource = openFile(download.file);
+      PdfDocument document = documentSource.openCore(state.pdfium);
+      PapyrusEngineStore.completeDownload(state, download, document, documentSource);
+    } catch (Throwable ignored) {
+      // The session already reads the complete file; only the PdfiumCore
+      // fallback is missing.
+      if (documentSource != null) documentSource.close();
+    }
+    startSearchIndex(state);
+    pruneThumbnails(state);
+  }
+
+  private static boolean isHttpSource(ReadableMap source) {
+    if (!source.hasKey("uri") || source.getType("uri") != ReadableType.String) return false;
+    String uri = source.getString("uri");
+    return uri != null && (uri.startsWith("http://") || uri.startsWith("https://"));
+  }
+
+  // Warms the text of the page the reader moved to; a newer call replaces a
+  // pending one. Ignored unless the engine was configured with prewarm.
+  @ReactMethod
+  public void prewarmPage(String engineId, int pageIndex) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.prewarm || pageIndex < 0) return;
+    state.scheduler.submitCoalesced(PapyrusScheduler.PRIORITY_PREWARM, state.prewarmKey, () -> prewarmPage(state, pageIndex));
+  }
+
+  private static void prewarmPage(PapyrusEngineStore.EngineState state, int pageIndex) {
+    if (!PapyrusDocumentSession.AVAILABLE || !PapyrusEngineStore.isPageReady(state, pageIndex)) return;
+    try {
+      synchronized (state.pdfiumLock) {
+        if (state.session != 0) {
+          PapyrusDocumentSession.nativePrewarm(state.session, pageIndex);
+        }
+      }
+    } catch (Throwable ignored) {
+    }
+  }
+
+  // Opens the persistent search index of the loaded document and indexes the
+  // pages it lacks in the background, one batch per job so every other kind of
+  // work goes first. Searches narrow their pages through whatever is indexed.
+  private static void startSearchIndex(PapyrusEngineStore.EngineState state) {
+    File directory = state.searchIndexDir;
+    if (directory == null || !PapyrusTextSearch.AVAILABLE) return;
+    state.scheduler.submitCoalesced(PapyrusScheduler.PRIORITY_PREWARM, state.searchIndexKey, () -> {
+      long session;
+      int indexed;
+      try {
+        synchronized (state.pdfiumLock) {
+          session = state.session;
+          if (session == 0 || (!directory.isDirectory() && !directory.mkdirs())) return;
+          indexed = PapyrusTextSearch.nativeIndexAttach(session, directory.getPath());
+        }
+      } catch (Throwable ignored) {
+        return;
+      }
+      if (indexed < 0) return;
+      pruneSearchIndexes(directory);
+      buildSearchIndex(state, session);
+    });
+  }
+
+  private static void buildSearchIndex(PapyrusEngineStore.EngineState state, long session) {
+    state.scheduler.submitCoalesced(PapyrusScheduler.PRIORITY_PREWARM, state.searchIndexKey, () -> {
+      int nextPage;
+      try {
+        synchronized (state.pdfiumLock) {
+          if (state.session != session) return;
+          nextPage = PapyrusTextSearch.nativeIndexBuild(session, SEARCH_INDEX_BATCH_PAGES);
+        }
+      } catch (Throwable ignored) {
+        return;
+      }
+      if (nextPage >= 0) buildSearchIndex(state, session);
+    });
+  }
+
+  // Keeps the most recently used index files; attaching one refreshes it.
+  private static void pruneSearchIndexes(File directory) {
+    File[] files = directory.listFiles((dir, name) -> name.endsWith(".pidx"));
+    if (files == null || files.length <= SEARCH_INDEX_MAX_FILES) return;
+    Arrays.sort(files, (a, b) -> Long.compare(b.lastModified(), a.lastModified()));
+    for (int i = SEARCH_INDEX_MAX_FILES; i < files.length; i++) {
+      files[i].delete();
+    }
+  }
+
+  // Drops the least recently shown thumbnails beyond THUMBNAIL_CACHE_BYTES;
+  // showing a cached thumbnail refreshes its file.
+  private static void pruneThumbnails(PapyrusEngineStore.EngineState state) {
+    File directory = state.thumbnailDir;
+    if (directory == null) return;
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_PREWARM, () -> {
+      File[] files = directory.listFiles((dir, name) -> name.endsWith(".ppth"));
+      if (files == null) return;
+      long total = 0;
+      for (File file : files) {
+        total += file.length();
+      }
+      if (total <= THUMBNAIL_CACHE_BYTES) return;
+      Arrays.sort(files, (a, b) -> Long.compare(a.lastModified(), b.lastModified()));
+      for (int i = 0; i < files.length && total > THUMBNAIL_CACHE_BYTES; i++) {
+        long length = files[i].length();
+        if (files[i].delete()) total -= length;
+      }
+    });
+  }
+
   @ReactMethod(isBlockingSynchronousMethod = true)
   public int getPageCount(String engineId) {
     PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
-    if (state == null || state.document == null) return 0;
-    return state.pdfium.getPageCount(state.document);
+    if (state == null || !state.hasDocument()) return 0;
+    synchronized (state.pdfiumLock) {
+      return PapyrusEngineStore.pageCount(state);
+    }
   }
 
   @ReactMethod
@@ -109,52 +341,93 @@ public class PapyrusNativeEngineModule extends ReactContextBaseJavaModule {
     });
   }
 
+  @ReactMethod
+  public void renderThumbnail(final String engineId, final int pageIndex, final int target) {
+    final PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null) return;
+    UIManagerModule uiManager = reactContext.getNativeModule(UIManagerModule.class);
+    if (uiManager == null) return;
+
+    uiManager.addUIBlock(new UIBlock() {
+      @Override
+      public void execute(com.facebook.react.uimanager.NativeViewHierarchyManager nativeViewHierarchyManager) {
+        View view = nativeViewHierarchyManager.resolveView(target);
+        if (view instanceof PapyrusPageView) {
+          ((PapyrusPageView) view).renderThumbnail(state, pageIndex);
+        }
+      }
+    });
+  }
+
   @ReactMethod
   public void renderTextLayer(String engineId, int pageIndex, int target, float scale, float zoom, int rotation) {
+    final PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !PapyrusTextSelect.AVAILABLE) return;
+    UIManagerModule uiManager = reactContext.getNativeModule(UIManagerModule.class);
+    if (uiManager == null) return;
+
+    uiManager.addUIBlock(new UIBlock() {
+      @Override
+      public void execute(com.facebook.react.uimanager.NativeViewHierarchyManager nativeViewHierarchyManager) {
+        View view = nativeViewHierarchyManager.resolveView(target);
+        if (view instanceof PapyrusPageView) {
+          ((PapyrusPageView) view).renderTextLayer(state, pageIndex);
+        }
+      }
+    });
   }
 
   @ReactMethod
   public void getTextContent(String engineId, int pageIndex, Promise promise) {
     PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
-    if (state == null || state.document == null) {
+    if (state == null || !state.hasDocument()) {
       promise.resolve(Arguments.createArray());
       return;
     }
-    String text;
-    synchronized (state.pdfiumLock) {
-      text = extractPageText(state, pageIndex);
-    }
-    WritableArray items = Arguments.createArray();
-    if (text != null && !text.isEmpty()) {
-      WritableMap item = Arguments.createMap();
-      item.putString("str", text);
-      item.putString("dir", "ltr");
-      item.putDouble("width", 0);
-      item.putDouble("height", 0);
-      WritableArray transform = Arguments.createArray();
-      transform.pushDouble(1);
-      transform.pushDouble(0);
-      transform.pushDouble(0);
-      transform.pushDouble(1);
-      transform.pushDouble(0);
-      transform.pushDouble(0);
-      item.putArray("transform", transform);
-      item.putString("fontName", "");
-      items.pushMap(item);
-    }
-    promise.resolve(items);
+    PapyrusEngineStore.submitForPage(state, PapyrusScheduler.PRIORITY_SELECTION, promise, pageIndex, () -> {
+      WritableArray items = null;
+      try {
+        synchronized (state.pdfiumLock) {
+          if (PapyrusTextSelect.AVAILABLE && state.session != 0) {
+            ByteBuffer buffer = PapyrusTextSelect.nativeGetTextRuns(state.session, pageIndex);
+            long decodeStarted = System.nanoTime();
+            PapyrusPacked packed = PapyrusPacked.wrap(buffer, PapyrusPacked.KIND_TEXT_RUNS);
+            if (packed != null) {
+              items = packed.readTextItems();
+              state.stats.record(PapyrusStats.PHASE_MARSHAL, System.nanoTime() - decodeStarted);
+            }
+          }
+        }
+      } catch (Throwable ignored) {
+        items = null;
+      }
+      if (items == null) items = Arguments.createArray();
+      promise.resolve(items);
+    });
   }
 
   @ReactMethod
   public void getPageDimensions(String engineId, int pageIndex, Promise promise) {
     PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
-    if (state == null || state.document == null) {
+    if (state == null || !state.hasDocument()) {
       WritableMap result = Arguments.createMap();
       result.putInt("width", 0);
       result.putInt("height", 0);
       promise.resolve(result);
       return;
     }
+    if (state.document == null) {
+      // Read by the session alone (an asset, in-memory bytes or a download):
+      // it measures the page, once it has arrived if still downloading.
+      PapyrusEngineStore.submitForPage(state, PapyrusScheduler.PRIORITY_RENDER, promise, pageIndex, () -> {
+        float[] size = PapyrusEngineStore.isPageReady(state, pageIndex) ? PapyrusEngineStore.sessionPageSize(state, pageIndex) : null;
+        WritableMap result = Arguments.createMap();
+        result.putInt("width", size != null ? Math.round(size[0]) : 0);
+        result.putInt("height", size != null ? Math.round(size[1]) : 0);
+        promise.resolve(result);
+      });
+      return;
+    }
     int width;
     int height;
     synchronized (state.pdfiumLock) {
@@ -167,310 +440,630 @@ public class PapyrusNativeEngineModule extends ReactContextBaseJavaModule {
     promise.resolve(result);
   }
 
+  // Size, rotation and label of every page in one call, so a scroll view is
+  // laid out without a getPageDimensions round trip per page. Resolves the
+  // packed buffer as base64, like search batches, or null.
   @ReactMethod
-  public void getOutline(String engineId, Promise promise) {
-    executor.execute(() -> {
-      PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
-      if (state == null || state.document == null) {
-        promise.resolve(Arguments.createArray());
-        return;
-      }
+  public void getPageMetadata(String engineId, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.hasDocument() || !PapyrusMetadata.AVAILABLE) {
+      promise.resolve(null);
+      return;
+    }
 
-      PapyrusOutlineItem[] items = null;
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_RENDER, promise, () -> {
+      String encoded = null;
       try {
-        if (PapyrusOutline.AVAILABLE) {
-          if (state.sourcePath != null && !state.sourcePath.isEmpty()) {
-            synchronized (state.pdfiumLock) {
-              items = PapyrusOutline.nativeGetOutlineFile(state.sourcePath);
-            }
-          } else {
-            long docPtr;
-            synchronized (state.pdfiumLock) {
-              docPtr = extractNativeDocPointer(state.document);
-            }
-            if (docPtr != 0) {
-              synchronized (state.pdfiumLock) {
-                items = PapyrusOutline.nativeGetOutline(docPtr);
-              }
+        synchronized (state.pdfiumLock) {
+          if (state.session != 0) {
+            ByteBuffer buffer = PapyrusMetadata.nativeGetPageMetadata(state.session);
+            long decodeStarted = System.nanoTime();
+            PapyrusPacked packed = PapyrusPacked.wrap(buffer, PapyrusPacked.KIND_PAGE_METADATA);
+            if (packed != null) {
+              encoded = packed.toBase64();
+              state.stats.record(PapyrusStats.PHASE_MARSHAL, System.nanoTime() - decodeStarted);
             }
           }
         }
       } catch (Throwable ignored) {
-        items = null;
+        encoded = null;
       }
-
-      WritableArray result = Arguments.createArray();
-      if (items != null) {
-        for (PapyrusOutlineItem item : items) {
-          result.pushMap(serializeOutlineItem(item));
-        }
-      }
-      promise.resolve(result);
+      promise.resolve(encoded);
     });
   }
 
   @ReactMethod
-  public void getPageIndex(String engineId, Object dest, Promise promise) {
-    promise.resolve(null);
+  public void getPageLinks(String engineId, int pageIndex, Promise promise) {
+    linksOnScheduler(engineId, pageIndex, promise, session -> PapyrusMetadata.nativeGetPageLinks(session, pageIndex), false);
   }
 
+  // The link under a normalized point, or null. The page's links are indexed
+  // on the first call, so later taps on it do not load the page.
   @ReactMethod
-  public void searchText(String engineId, String query, Promise promise) {
-    executor.execute(() -> {
-      PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
-      if (state == null || state.document == null || query == null || query.length() < 2) {
-        promise.resolve(Arguments.createArray());
-        return;
-      }
+  public void getLinkAt(String engineId, int pageIndex, double x, double y, Promise promise) {
+    linksOnScheduler(engineId, pageIndex, promise,
+        session -> PapyrusMetadata.nativeGetLinkAt(session, pageIndex, (float) x, (float) y), true);
+  }
 
-      int pageCount = state.pdfium.getPageCount(state.document);
-      state.isSearching = true;
+  private void linksOnScheduler(String engineId, int pageIndex, Promise promise, SessionQuery query, boolean single) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.hasDocument() || pageIndex < 0 || !PapyrusMetadata.AVAILABLE) {
+      promise.resolve(single ? null : Arguments.createArray());
+      return;
+    }
+
+    PapyrusEngineStore.submitForPage(state, PapyrusScheduler.PRIORITY_SELECTION, promise, pageIndex, () -> {
+      Object result = null;
       try {
-        try {
-          if (PapyrusTextSearch.AVAILABLE) {
-            PapyrusTextHit[] hits = null;
-            if (state.sourcePath != null && !state.sourcePath.isEmpty()) {
-              synchronized (state.pdfiumLock) {
-                hits = PapyrusTextSearch.nativeSearchFile(state.sourcePath, query);
-              }
-            } else {
-              long docPtr;
-              synchronized (state.pdfiumLock) {
-                docPtr = extractNativeDocPointer(state.document);
-              }
-              if (docPtr != 0) {
-                synchronized (state.pdfiumLock) {
-                  hits = PapyrusTextSearch.nativeSearch(docPtr, pageCount, query);
-                }
+        synchronized (state.pdfiumLock) {
+          if (state.session != 0) {
+            ByteBuffer buffer = query.run(state.session);
+            PapyrusPacked packed = PapyrusPacked.wrap(buffer, PapyrusPacked.KIND_LINKS);
+            if (packed != null) {
+              if (!single) {
+                result = packed.readLinks();
+              } else if (packed.recordCount() > 0) {
+                result = packed.readLink(0);
               }
             }
+          }
+        }
+      } catch (Throwable ignored) {
+        result = null;
+      }
+      promise.resolve(result != null || single ? result : Arguments.createArray());
+    });
+  }
+
+  @ReactMethod
+  public void getOutline(String engineId, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.hasDocument()) {
+      promise.resolve(Arguments.createArray());
+      return;
+    }
 
-            if (hits != null && hits.length > 0) {
-              WritableArray results = Arguments.createArray();
-              for (PapyrusTextHit hit : hits) {
-                WritableMap result = Arguments.createMap();
-                result.putInt("pageIndex", hit.pageIndex);
-                result.putString("text", hit.text != null ? hit.text : query);
-                result.putInt("matchIndex", hit.matchIndex);
-                if (hit.rects != null && hit.rects.length >= 4) {
-                  WritableArray rects = Arguments.createArray();
-                  for (int i = 0; i + 3 < hit.rects.length; i += 4) {
-                    WritableMap rect = Arguments.createMap();
-                    rect.putDouble("x", hit.rects[i]);
-                    rect.putDouble("y", hit.rects[i + 1]);
-                    rect.putDouble("width", hit.rects[i + 2]);
-                    rect.putDouble("height", hit.rects[i + 3]);
-                    rects.pushMap(rect);
-                  }
-                  result.putArray("rects", rects);
-                }
-                results.pushMap(result);
+    // Bookmarks may live anywhere in the file, so a download finishes first.
+    PapyrusEngineStore.submitAfterDownload(state, PapyrusScheduler.PRIORITY_OUTLINE, promise, () -> {
+      WritableArray result = null;
+      try {
+        if (PapyrusOutline.AVAILABLE) {
+          synchronized (state.pdfiumLock) {
+            if (state.session != 0) {
+              ByteBuffer buffer = PapyrusOutline.nativeGetOutline(state.session);
+              long decodeStarted = System.nanoTime();
+              PapyrusPacked packed = PapyrusPacked.wrap(buffer, PapyrusPacked.KIND_OUTLINE);
+              if (packed != null) {
+                result = packed.readOutline();
+                state.stats.record(PapyrusStats.PHASE_MARSHAL, System.nanoTime() - decodeStarted);
               }
-              promise.resolve(results);
-              return;
             }
           }
-        } catch (Throwable ignored) {
         }
+      } catch (Throwable ignored) {
+        result = null;
+      }
+      promise.resolve(result != null ? result : Arguments.createArray());
+    });
+  }
 
-        String normalizedQuery = query.toLowerCase();
-        WritableArray results = Arguments.createArray();
+  @ReactMethod
+  public void getOutlineChildren(String engineId, int parentId, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.hasDocument() || !PapyrusOutline.AVAILABLE) {
+      promise.resolve(Arguments.createArray());
+      return;
+    }
 
-        for (int pageIndex = 0; pageIndex < pageCount; pageIndex++) {
-          String text;
-          synchronized (state.pdfiumLock) {
-            text = extractPageText(state, pageIndex);
-          }
-          if (text == null || text.isEmpty()) continue;
-
-          String lower = text.toLowerCase();
-          int pos = lower.indexOf(normalizedQuery);
-          int matchIndex = 0;
-          while (pos != -1) {
-            int start = Math.max(0, pos - 20);
-            int end = Math.min(text.length(), pos + normalizedQuery.length() + 20);
-            String preview = text.substring(start, end);
-
-            WritableMap result = Arguments.createMap();
-            result.putInt("pageIndex", pageIndex);
-            result.putString("text", preview);
-            result.putInt("matchIndex", matchIndex++);
-            results.pushMap(result);
-
-            pos = lower.indexOf(normalizedQuery, pos + 1);
+    PapyrusEngineStore.submitAfterDownload(state, PapyrusScheduler.PRIORITY_OUTLINE, promise, () -> {
+      WritableArray result = null;
+      try {
+        synchronized (state.pdfiumLock) {
+          if (state.session != 0) {
+            ByteBuffer buffer = PapyrusOutline.nativeGetOutlineChildren(state.session, parentId);
+            long decodeStarted = System.nanoTime();
+            PapyrusPacked packed = PapyrusPacked.wrap(buffer, PapyrusPacked.KIND_OUTLINE_NODES);
+            if (packed != null) {
+              result = packed.readOutlineNodes();
+              state.stats.record(PapyrusStats.PHASE_MARSHAL, System.nanoTime() - decodeStarted);
+            }
           }
         }
-
-        promise.resolve(results);
-      } finally {
-        state.isSearching = false;
+      } catch (Throwable ignored) {
+        result = null;
       }
+      promise.resolve(result != null ? result : Arguments.createArray());
     });
   }
 
   @ReactMethod
-  public void selectText(String engineId, int pageIndex, double x, double y, double width, double height, Promise promise) {
-    executor.execute(() -> {
-      PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
-      if (state == null || state.document == null || pageIndex < 0) {
+  public void getOutlineDestination(String engineId, int nodeId, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.hasDocument() || !PapyrusOutline.AVAILABLE) {
+      promise.resolve(null);
+      return;
+    }
+
+    PapyrusEngineStore.submitAfterDownload(state, PapyrusScheduler.PRIORITY_SELECTION, promise, () -> {
+      float[] values = null;
+      try {
+        synchronized (state.pdfiumLock) {
+          if (state.session != 0) {
+            values = PapyrusOutline.nativeGetOutlineDestination(state.session, nodeId);
+          }
+        }
+      } catch (Throwable ignored) {
+        values = null;
+      }
+      if (values == null || values.length < 4 || values[0] < 0) {
         promise.resolve(null);
         return;
       }
 
-      if (!PapyrusTextSelect.AVAILABLE) {
-        promise.resolve(null);
+      WritableMap result = Arguments.createMap();
+      result.putInt("pageIndex", (int) values[0]);
+      if (!Float.isNaN(values[1])) result.putDouble("x", values[1]);
+      if (!Float.isNaN(values[2])) result.putDouble("y", values[2]);
+      if (!Float.isNaN(values[3])) result.putDouble("zoom", values[3]);
+      promise.resolve(result);
+    });
+  }
+
+  // Native phase timings and counters of this engine since it was created or
+  // last reset; see PapyrusStats.
+  @ReactMethod
+  public void getNativeStats(String engineId, boolean reset, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null) {
+      promise.resolve(null);
+      return;
+    }
+    promise.resolve(state.stats.snapshot(reset));
+  }
+
+  @ReactMethod
+  public void getPageIndex(String engineId, Object dest, Promise promise) {
+    promise.resolve(null);
+  }
+
+  @ReactMethod
+  public void searchText(String engineId, String query, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.hasDocument() || query == null || query.length() < 2 || !PapyrusTextSearch.AVAILABLE) {
+      promise.resolve(Arguments.createArray());
+      return;
+    }
+
+    // A search scans every page, so it starts once a download has finished.
+    PapyrusEngineStore.submitAfterDownload(state, PapyrusScheduler.PRIORITY_SEARCH, promise, () -> {
+      int cursorId = openSearchCursor(state, session -> PapyrusTextSearch.nativeCursorOpen(session, query, 0));
+      if (cursorId < 0) {
+        promise.resolve(Arguments.createArray());
         return;
       }
+      continueSearchText(state, cursorId, query, Arguments.createArray(), 0, promise);
+    });
+  }
+
+  // Runs one batch per scheduler job so renders and selections queued in the
+  // meantime are served between batches.
+  private void continueSearchText(PapyrusEngineStore.EngineState state,
+                                  int cursorId,
+                                  String query,
+                                  WritableArray results,
+                                  int resultCount,
+                                  Promise promise) {
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_SEARCH, promise, () -> {
+      int pageBatch = SEARCH_TEXT_BATCH_PAGES * Math.max(1, state.searchWorkers);
+      SearchBatch batch = nextSearchBatch(state, cursorId, pageBatch, SEARCH_TEXT_MAX_HITS - resultCount, results, query);
+      int count = resultCount + batch.count;
+
+      if (batch.nextPage < 0 || count >= SEARCH_TEXT_MAX_HITS) {
+        closeSearchCursor(state, cursorId);
+        promise.resolve(results);
+        return;
+      }
+      continueSearchText(state, cursorId, query, results, count, promise);
+    });
+  }
+
+  @ReactMethod
+  public void searchStart(String engineId, String query, ReadableMap options, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || query == null || query.length() < 2 || !PapyrusTextSearch.AVAILABLE) {
+      promise.resolve(-1);
+      return;
+    }
+
+    int flags = searchFlags(options);
+    PapyrusEngineStore.submitAfterDownload(state, PapyrusScheduler.PRIORITY_SEARCH, promise,
+        () -> promise.resolve(openSearchCursor(state, session -> PapyrusTextSearch.nativeCursorOpen(session, query, flags))));
+  }
+
+  // Like searchStart for a list of terms, all found in one pass per page. Hits
+  // come from searchNext and carry the index of their term as patternIndex;
+  // terms shorter than two chars never match.
+  @ReactMethod
+  public void searchTermsStart(String engineId, ReadableArray terms, ReadableMap options, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || terms == null || terms.size() == 0 || !PapyrusTextSearch.AVAILABLE) {
+      promise.resolve(-1);
+      return;
+    }
+
+    String[] list = new String[Math.min(terms.size(), SEARCH_MAX_TERMS)];
+    for (int i = 0; i < list.length; i++) {
+      String term = terms.getType(i) == ReadableType.String ? terms.getString(i) : null;
+      list[i] = term != null && term.length() >= 2 ? term : "";
+    }
+    int flags = searchFlags(options);
+    PapyrusEngineStore.submitAfterDownload(state, PapyrusScheduler.PRIORITY_SEARCH, promise,
+        () -> promise.resolve(openSearchCursor(state, session -> PapyrusTextSearch.nativeTermsOpen(session, list, flags))));
+  }
+
+  @ReactMethod
+  public void searchNext(String engineId, int cursorId, int pageBatch, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null) {
+      promise.resolve(serializeSearchBatch(new SearchBatch(0, null, -1)));
+      return;
+    }
+
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_SEARCH, promise, () ->
+        promise.resolve(serializeSearchBatch(nextSearchBatch(state, cursorId, pageBatch, Integer.MAX_VALUE, null, ""))));
+  }
+
+  @ReactMethod
+  public void searchCancel(String engineId, int cursorId) {
+    // Runs on the calling thread so a batch already scanning on the scheduler
+    // stops at its next page boundary.
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    PapyrusSearchCursor cursor = state != null ? state.searchCursors.get(cursorId) : null;
+    if (cursor != null) {
+      cursor.cancel();
+    }
+  }
+
+  @ReactMethod
+  public void searchClose(String engineId, int cursorId) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null) return;
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_SEARCH, () -> closeSearchCursor(state, cursorId));
+  }
+
+  // Starts exporting the whole document's text as UTF-8, to options.path when
+  // given and otherwise chunk by chunk through exportNext. Pages end with a
+  // form feed when options.pageMarkers is set, a line break otherwise.
+  @ReactMethod
+  public void exportStart(String engineId, ReadableMap options, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !PapyrusTextExport.AVAILABLE) {
+      promise.resolve(-1);
+      return;
+    }
 
-      PapyrusTextSelection selection = null;
+    String path = options != null && options.hasKey("path") && options.getType("path") == ReadableType.String
+        ? options.getString("path")
+        : null;
+    if (path != null && path.startsWith("file://")) {
+      path = Uri.parse(path).getPath();
+    }
+    String filePath = path;
+    int flags = options != null && isTrue(options, "pageMarkers") ? PapyrusTextExport.PAGE_MARKERS : 0;
+    PapyrusEngineStore.submitAfterDownload(state, PapyrusScheduler.PRIORITY_SEARCH, promise, () -> {
+      long handle = 0;
       try {
-        if (state.sourcePath != null && !state.sourcePath.isEmpty()) {
-          synchronized (state.pdfiumLock) {
-            selection = PapyrusTextSelect.nativeSelectTextFile(state.sourcePath, pageIndex, (float) x, (float) y, (float) width, (float) height);
-          }
-        } else {
-          long docPtr;
-          synchronized (state.pdfiumLock) {
-            docPtr = extractNativeDocPointer(state.document);
-          }
-          if (docPtr != 0) {
-            synchronized (state.pdfiumLock) {
-              selection = PapyrusTextSelect.nativeSelectText(docPtr, pageIndex, (float) x, (float) y, (float) width, (float) height);
-            }
+        synchronized (state.pdfiumLock) {
+          if (state.session != 0) {
+            handle = PapyrusTextExport.nativeOpen(state.session, flags, filePath);
           }
         }
       } catch (Throwable ignored) {
-        selection = null;
+        handle = 0;
       }
+      promise.resolve(handle != 0 ? PapyrusEngineStore.addTextExport(state, handle, filePath != null) : -1);
+    });
+  }
 
-      if (selection == null || selection.rects == null || selection.rects.length == 0) {
-        promise.resolve(null);
-        return;
-      }
+  // One step of an export, as a scheduler job so renders queued meanwhile go
+  // first: the next chunk as text, or for a file up to
+  // EXPORT_FILE_BATCH_CHUNKS chunks written. Once done, also where each page
+  // starts; null on error.
+  @ReactMethod
+  public void exportNext(String engineId, int exportId, Promise promise) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null) {
+      promise.resolve(null);
+      return;
+    }
 
-      WritableMap result = Arguments.createMap();
-      result.putString("text", selection.text != null ? selection.text : "");
-      WritableArray rects = Arguments.createArray();
-      for (int i = 0; i + 3 < selection.rects.length; i += 4) {
-        WritableMap rect = Arguments.createMap();
-        rect.putDouble("x", selection.rects[i]);
-        rect.putDouble("y", selection.rects[i + 1]);
-        rect.putDouble("width", selection.rects[i + 2]);
-        rect.putDouble("height", selection.rects[i + 3]);
-        rects.pushMap(rect);
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_SEARCH, promise, () -> promise.resolve(nextExportStep(state, exportId)));
+  }
+
+  @ReactMethod
+  public void exportClose(String engineId, int exportId) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null) return;
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_SEARCH, () -> {
+      PapyrusTextExport textExport = state.textExports.remove(exportId);
+      if (textExport == null) return;
+      synchronized (state.pdfiumLock) {
+        textExport.close();
       }
-      result.putArray("rects", rects);
-      promise.resolve(result);
     });
   }
 
-  private String extractPageText(PapyrusEngineStore.EngineState state, int pageIndex) {
+  private WritableMap nextExportStep(PapyrusEngineStore.EngineState state, int exportId) {
+    PapyrusTextExport textExport = state.textExports.get(exportId);
+    if (textExport == null) return null;
     try {
-      state.pdfium.openPage(state.document, pageIndex);
+      synchronized (state.pdfiumLock) {
+        long handle = textExport.handle();
+        if (handle == 0) return null;
+        WritableMap result = Arguments.createMap();
+        boolean done;
+        if (textExport.toFile) {
+          int status = PapyrusTextExport.nativeWrite(handle, EXPORT_FILE_BATCH_CHUNKS);
+          if (status < 0) return null;
+          done = status == 0;
+        } else {
+          ByteBuffer chunk = PapyrusTextExport.nativeNext(handle);
+          done = chunk == null;
+          if (!done) {
+            // Chunks end on a character boundary, so each decodes on its own.
+            byte[] bytes = new byte[chunk.remaining()];
+            chunk.get(bytes);
+            result.putString("text", new String(bytes, StandardCharsets.UTF_8));
+          }
+        }
+        long[] progress = PapyrusTextExport.nativeProgress(handle);
+        result.putDouble("bytes", progress[0]);
+        result.putDouble("chars", progress[1]);
+        result.putBoolean("done", done);
+        if (done) {
+          result.putArray("pageOffsets", toDoubleArray(PapyrusTextExport.nativePageOffsets(handle, false)));
+          result.putArray("pageByteOffsets", toDoubleArray(PapyrusTextExport.nativePageOffsets(handle, true)));
+        }
+        return result;
+      }
     } catch (Throwable ignored) {
+      return null;
     }
+  }
 
-    try {
-      java.lang.reflect.Method method = null;
-      try {
-        method = state.pdfium.getClass().getDeclaredMethod("getPageText", PdfDocument.class, int.class);
-      } catch (NoSuchMethodException ignored) {
-      }
+  private static WritableArray toDoubleArray(long[] values) {
+    WritableArray array = Arguments.createArray();
+    if (values == null) return array;
+    for (long value : values) {
+      array.pushDouble(value);
+    }
+    return array;
+  }
 
-      if (method == null) {
-        try {
-          method = state.pdfium.getClass().getDeclaredMethod("nativeGetPageText", long.class, int.class);
-        } catch (NoSuchMethodException ignored) {
+  @ReactMethod
+  public void selectText(String engineId, int pageIndex, double x, double y, double width, double height, Promise promise) {
+    selectOnScheduler(engineId, pageIndex, promise, session ->
+        PapyrusTextSelect.nativeSelectText(session, pageIndex, (float) x, (float) y, (float) width, (float) height));
+  }
+
+  @ReactMethod
+  public void selectWordAt(String engineId, int pageIndex, double x, double y, Promise promise) {
+    selectOnScheduler(engineId, pageIndex, promise, session ->
+        PapyrusTextSelect.nativeSelectWordAt(session, pageIndex, (float) x, (float) y));
+  }
+
+  @ReactMethod
+  public void selectLineAt(String engineId, int pageIndex, double x, double y, Promise promise) {
+    selectOnScheduler(engineId, pageIndex, promise, session ->
+        PapyrusTextSelect.nativeSelectLineAt(session, pageIndex, (float) x, (float) y));
+  }
+
+  private interface SessionQuery {
+    ByteBuffer run(long session);
+  }
+
+  private void selectOnScheduler(String engineId, int pageIndex, Promise promise, SessionQuery query) {
+    PapyrusEngineStore.EngineState state = PapyrusEngineStore.getEngine(engineId);
+    if (state == null || !state.hasDocument() || pageIndex < 0 || !PapyrusTextSelect.AVAILABLE) {
+      promise.resolve(null);
+      return;
+    }
+
+    PapyrusEngineStore.submitForPage(state, PapyrusScheduler.PRIORITY_SELECTION, promise, pageIndex, () -> {
+      WritableMap result = null;
+      try {
+        synchronized (state.pdfiumLock) {
+          if (state.session != 0) {
+            ByteBuffer buffer = query.run(state.session);
+            long decodeStarted = System.nanoTime();
+            PapyrusPacked packed = PapyrusPacked.wrap(buffer, PapyrusPacked.KIND_SELECTION);
+            if (packed != null) {
+              result = packed.readSelection();
+              state.stats.record(PapyrusStats.PHASE_MARSHAL, System.nanoTime() - decodeStarted);
+            }
+          }
         }
+      } catch (Throwable ignored) {
+        result = null;
       }
+      promise.resolve(result);
+    });
+  }
 
-      if (method != null) {
-        method.setAccessible(true);
-        Object result;
-        if (method.getParameterTypes().length == 2 && method.getParameterTypes()[0] == PdfDocument.class) {
-          result = method.invoke(state.pdfium, state.document, pageIndex);
-        } else if (method.getParameterTypes().length == 2 && method.getParameterTypes()[0] == long.class) {
-          long docPtr = extractNativeDocPointer(state.document);
-          result = method.invoke(state.pdfium, docPtr, pageIndex);
-        } else {
-          result = null;
+  // Hits of one cursor batch, either appended to a Java-side array or kept
+  // packed (base64) for JS to decode.
+  private static final class SearchBatch {
+    final int count;
+    final String packed;
+    final int nextPage;
+
+    SearchBatch(int count, String packed, int nextPage) {
+      this.count = count;
+      this.packed = packed;
+      this.nextPage = nextPage;
+    }
+  }
+
+  private static int searchFlags(ReadableMap options) {
+    int flags = 0;
+    if (options == null) return flags;
+    if (isTrue(options, "matchCase")) flags |= PapyrusTextSearch.MATCH_CASE;
+    if (isTrue(options, "matchDiacritics")) flags |= PapyrusTextSearch.MATCH_DIACRITICS;
+    if (isTrue(options, "wholeWord")) flags |= PapyrusTextSearch.MATCH_WHOLE_WORD;
+    if (options.hasKey("maxEdits") && options.getType("maxEdits") == ReadableType.Number) {
+      int edits = Math.max(0, Math.min(PapyrusTextSearch.MAX_EDITS, (int) options.getDouble("maxEdits")));
+      flags |= edits << PapyrusTextSearch.EDITS_SHIFT;
+    }
+    return flags;
+  }
+
+  private static boolean isTrue(ReadableMap options, String key) {
+    return options.hasKey(key) && options.getType(key) == ReadableType.Boolean && options.getBoolean(key);
+  }
+
+  // open maps the session to a native cursor handle, 0 if there is nothing to
+  // search for.
+  private int openSearchCursor(PapyrusEngineStore.EngineState state, LongUnaryOperator open) {
+    long handle = 0;
+    try {
+      synchronized (state.pdfiumLock) {
+        if (state.session != 0) {
+          handle = open.applyAsLong(state.session);
         }
-        return result != null ? result.toString() : "";
       }
     } catch (Throwable ignored) {
+      handle = 0;
     }
-
-    return "";
+    return handle != 0 ? PapyrusEngineStore.addSearchCursor(state, handle) : -1;
   }
 
-  private long extractNativeDocPointer(PdfDocument document) {
+  private SearchBatch nextSearchBatch(PapyrusEngineStore.EngineState state,
+                                      int cursorId,
+                                      int pageBatch,
+                                      int maxHits,
+                                      WritableArray appendTo,
+                                      String fallbackText) {
+    PapyrusSearchCursor cursor = state.searchCursors.get(cursorId);
+    if (cursor == null) return new SearchBatch(0, null, -1);
     try {
-      java.lang.reflect.Field field = PdfDocument.class.getDeclaredField("mNativeDocPtr");
-      field.setAccessible(true);
-      Object value = field.get(document);
-      if (value instanceof Long) {
-        return (Long) value;
+      synchronized (state.pdfiumLock) {
+        long handle = cursor.handle();
+        if (handle == 0) return new SearchBatch(0, null, -1);
+        ByteBuffer buffer = PapyrusTextSearch.nativeCursorNext(handle, pageBatch, state.searchWorkers, maxHits);
+        int nextPage = PapyrusTextSearch.nativeCursorPosition(handle);
+        long decodeStarted = System.nanoTime();
+        PapyrusPacked packed = PapyrusPacked.wrap(buffer, PapyrusPacked.KIND_SEARCH_HITS);
+        if (packed == null) return new SearchBatch(0, null, nextPage);
+        String encoded = null;
+        if (appendTo == null) {
+          encoded = packed.toBase64();
+        } else {
+          packed.appendSearchHits(appendTo, fallbackText);
+        }
+        state.stats.record(PapyrusStats.PHASE_MARSHAL, System.nanoTime() - decodeStarted);
+        return new SearchBatch(packed.recordCount(), encoded, nextPage);
       }
     } catch (Throwable ignored) {
+      return new SearchBatch(0, null, -1);
     }
-    return 0;
   }
 
-  private WritableMap serializeOutlineItem(PapyrusOutlineItem item) {
-    WritableMap map = Arguments.createMap();
-    map.putString("title", item.title != null ? item.title : "");
-    map.putInt("pageIndex", item.pageIndex);
-    if (item.children != null && item.children.length > 0) {
-      WritableArray children = Arguments.createArray();
-      for (PapyrusOutlineItem child : item.children) {
-        children.pushMap(serializeOutlineItem(child));
-      }
-      map.putArray("children", children);
+  private void closeSearchCursor(PapyrusEngineStore.EngineState state, int cursorId) {
+    PapyrusSearchCursor cursor = state.searchCursors.remove(cursorId);
+    if (cursor == null) return;
+    synchronized (state.pdfiumLock) {
+      cursor.close();
     }
-    return map;
   }
 
-  private static File materializeSource(ReadableMap source, Context context) throws IOException {
+  private WritableMap serializeSearchBatch(SearchBatch batch) {
+    WritableMap result = Arguments.createMap();
+    if (batch.packed != null) {
+      result.putString("packed", batch.packed);
+    }
+    result.putInt("nextPage", batch.nextPage);
+    result.putBoolean("done", batch.nextPage < 0);
+    return result;
+  }
+
+  // Local files, content URIs backed by a file, assets and in-memory bytes
+  // are read in place; only downloads and streamed content touch the cache dir.
+  private static PapyrusDocumentSource openSource(ReadableMap source, Context context) throws IOException {
     if (source.hasKey("uri") && source.getType("uri") == ReadableType.String) {
       String uriString = source.getString("uri");
       if (uriString == null) return null;
 
       if (uriString.startsWith("http://") || uriString.startsWith("https://")) {
-        return downloadToCache(uriString, context);
+        return openFile(downloadToCache(uriString, context));
       }
 
       if (uriString.startsWith("asset:/")) {
-        return copyFromAsset(uriString.substring("asset:/".length()), context);
+        return openAsset(uriString.substring("asset:/".length()), context);
       }
 
       if (uriString.startsWith("file:///android_asset/")) {
-        return copyFromAsset(uriString.substring("file:///android_asset/".length()), context);
+        return openAsset(uriString.substring("file:///android_asset/".length()), context);
       }
 
       if (uriString.startsWith("content://")) {
-        return copyFromContentUri(Uri.parse(uriString), context);
+        return openContentUri(Uri.parse(uriString), context);
       }
 
       if (uriString.startsWith("file://")) {
-        return new File(Uri.parse(uriString).getPath());
+        return openFile(new File(Uri.parse(uriString).getPath()));
       }
 
-      return new File(uriString);
+      return openFile(new File(uriString));
+    }
+
+    if (source.hasKey("base64") && source.getType("base64") == ReadableType.String) {
+      String base64 = source.getString("base64");
+      if (base64 == null) return null;
+      return PapyrusDocumentSource.ofBase64(base64);
     }
 
     if (source.hasKey("data") && source.getType("data") == ReadableType.Array) {
       ReadableArray array = source.getArray("data");
       if (array == null) return null;
-      byte[] bytes = new byte[array.size()];
+      // Only older callers send an array; it goes straight into the buffer.
+      ByteBuffer buffer = ByteBuffer.allocateDirect(array.size());
       for (int i = 0; i < array.size(); i++) {
-        bytes[i] = (byte) array.getInt(i);
+        buffer.put((byte) array.getInt(i));
       }
-      return writeBytesToCache(bytes, context);
+      return PapyrusDocumentSource.ofBuffer(buffer);
     }
 
     return null;
   }
 
+  private static PapyrusDocumentSource openFile(File file) throws IOException {
+    return PapyrusDocumentSource.ofFile(ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY));
+  }
+
+  // An asset stored uncompressed is mapped where it lies in the APK; a
+  // compressed one has no such range and is inflated into a native buffer.
+  private static PapyrusDocumentSource openAsset(String assetPath, Context context) throws IOException {
+    AssetFileDescriptor asset;
+    try {
+      asset = context.getAssets().openFd(assetPath);
+    } catch (FileNotFoundException compressed) {
+      InputStream input = context.getAssets().open(assetPath);
+      return PapyrusDocumentSource.ofStream(input, input.available());
+    }
+    return PapyrusDocumentSource.ofAsset(asset);
+  }
+
+  private static PapyrusDocumentSource openContentUri(Uri uri, Context context) throws IOException {
+    ContentResolver resolver = context.getContentResolver();
+    ParcelFileDescriptor descriptor = resolver.openFileDescriptor(uri, "r");
+    if (descriptor != null && descriptor.getStatSize() >= 0) {
+      return PapyrusDocumentSource.ofFile(descriptor);
+    }
+    // A pipe or socket from the provider: copy it to a file PDFium can seek.
+    if (descriptor != null) descriptor.close();
+    return openFile(copyFromContentUri(uri, context));
+  }
+
   private static File downloadToCache(String uri, Context context) throws IOException {
     URL url = new URL(uri);
     HttpURLConnection connection = (HttpURLConnection) url.openConnection();
@@ -494,22 +1087,6 @@ public class PapyrusNativeEngineModule extends ReactContextBaseJavaModule {
     return out;
   }
 
-  private static File copyFromAsset(String assetPath, Context context) throws IOException {
-    InputStream inputStream = context.getAssets().open(assetPath);
-    File out = createTempFile(context);
-    writeStreamToFile(inputStream, out);
-    return out;
-  }
-
-  private static File writeBytesToCache(byte[] bytes, Context context) throws IOException {
-    File out = createTempFile(context);
-    FileOutputStream fos = new FileOutputStream(out);
-    fos.write(bytes);
-    fos.flush();
-    fos.close();
-    return out;
-  }
-
   private static File createTempFile(Context context) throws IOException {
     File cacheDir = context.getCacheDir();
     return File.createTempFile("papyrus", ".pdf", cacheDir);
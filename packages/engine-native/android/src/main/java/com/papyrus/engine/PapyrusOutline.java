@@ -1,5 +1,7 @@
 package com.papyrus.engine;
 
+import java.nio.ByteBuffer;
+
 final class PapyrusOutline {
   static final boolean AVAILABLE;
 
@@ -14,7 +16,10 @@ final class PapyrusOutline {
     AVAILABLE = available;
   }
 
-  static native PapyrusOutlineItem[] nativeGetOutline(long docPtr);
+  static native ByteBuffer nativeGetOutline(long session);
+
+  // parentId 0 lists the top level; ids come from earlier results.
+  static native ByteBuffer nativeGetOutlineChildren(long session, int parentId);
 
-  static native PapyrusOutlineItem[] nativeGetOutlineFile(String filePath);
+  static native float[] nativeGetOutlineDestination(long session, int nodeId);
 }
@@ -0,0 +1,247 @@
+package com.papyrus.engine;
+
+import android.util.Base64;
+
+import com.facebook.react.bridge.Arguments;
+import com.facebook.react.bridge.WritableArray;
+import com.facebook.react.bridge.WritableMap;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+// Reads the packed results produced by papyrus_packed.h. The buffers alias
+// native memory owned by the document session, so they must be consumed
+// before the engine's pdfiumLock is released.
+final class PapyrusPacked {
+  static final int KIND_SEARCH_HITS = 1;
+  static final int KIND_SELECTION = 2;
+  static final int KIND_OUTLINE = 3;
+  static final int KIND_OUTLINE_NODES = 4;
+  static final int KIND_TEXT_RUNS = 5;
+  static final int KIND_PAGE_METADATA = 6;
+  static final int KIND_LINKS = 7;
+
+  private static final int MAGIC = 0x314B5050;
+  private static final int HEADER_BYTES = 6 * 4;
+
+  private final ByteBuffer buffer;
+  private final int recordCount;
+  private final int fieldsPerRecord;
+  private final int rectsAt;
+  private final int stringsAt;
+
+  private PapyrusPacked(ByteBuffer buffer) {
+    this.buffer = buffer;
+    this.recordCount = buffer.getInt(8);
+    this.fieldsPerRecord = buffer.getInt(12);
+    int rectCount = buffer.getInt(16);
+    this.rectsAt = HEADER_BYTES + recordCount * fieldsPerRecord * 4;
+    this.stringsAt = rectsAt + rectCount * 16;
+  }
+
+  static PapyrusPacked wrap(ByteBuffer buffer, int kind) {
+    if (buffer == null || buffer.capacity() < HEADER_BYTES) return null;
+    buffer.order(ByteOrder.nativeOrder());
+    if (buffer.getInt(0) != MAGIC || buffer.getInt(4) != kind) return null;
+    return new PapyrusPacked(buffer);
+  }
+
+  int recordCount() {
+    return recordCount;
+  }
+
+  int field(int record, int field) {
+    return buffer.getInt(HEADER_BYTES + (record * fieldsPerRecord + field) * 4);
+  }
+
+  String string(int offset, int length) {
+    char[] chars = new char[length];
+    int at = stringsAt + offset * 2;
+    for (int i = 0; i < length; i++) {
+      chars[i] = buffer.getChar(at + i * 2);
+    }
+    return new String(chars);
+  }
+
+  WritableArray rects(int first, int count) {
+    WritableArray rects = Arguments.createArray();
+    for (int i = first; i < first + count; i++) {
+      int at = rectsAt + i * 16;
+      WritableMap rect = Arguments.createMap();
+      rect.putDouble("x", buffer.getFloat(at));
+      rect.putDouble("y", buffer.getFloat(at + 4));
+      rect.putDouble("width", buffer.getFloat(at + 8));
+      rect.putDouble("height", buffer.getFloat(at + 12));
+      rects.pushMap(rect);
+    }
+    return rects;
+  }
+
+  float rectComponent(int rect, int component) {
+    return buffer.getFloat(rectsAt + rect * 16 + component * 4);
+  }
+
+  // Copies the whole buffer out as base64 so JS can decode it with one
+  // DataView instead of receiving a map per hit over the bridge.
+  String toBase64() {
+    byte[] bytes = new byte[buffer.capacity()];
+    ByteBuffer view = buffer.duplicate();
+    view.clear();
+    view.get(bytes);
+    return Base64.encodeToString(bytes, Base64.NO_WRAP);
+  }
+
+  void appendSearchHits(WritableArray out, String fallbackText) {
+    for (int i = 0; i < recordCount; i++) {
+      WritableMap hit = Arguments.createMap();
+      hit.putInt("pageIndex", field(i, 0));
+      hit.putInt("matchIndex", field(i, 1));
+      int textLength = field(i, 3);
+      hit.putString("text", textLength > 0 ? string(field(i, 2), textLength) : fallbackText);
+      int rectCount = field(i, 5);
+      if (rectCount > 0) {
+        hit.putArray("rects", rects(field(i, 4), rectCount));
+      }
+      if (fieldsPerRecord > 6 && field(i, 6) >= 0) {
+        hit.putInt("patternIndex", field(i, 6));
+      }
+      if (fieldsPerRecord > 7) {
+        hit.putInt("distance", field(i, 7));
+      }
+      out.pushMap(hit);
+    }
+  }
+
+  WritableMap readSelection() {
+    if (recordCount == 0 || field(0, 3) == 0) return null;
+    WritableMap result = Arguments.createMap();
+    result.putString("text", string(field(0, 0), field(0, 1)));
+    result.putArray("rects", rects(field(0, 2), field(0, 3)));
+    return result;
+  }
+
+  // Text items as @papyrus-sdk/types defines them, in page points: the
+  // transform places the run's baseline origin and scales by its font size.
+  WritableArray readTextItems() {
+    WritableArray items = Arguments.createArray();
+    for (int i = 0; i < recordCount; i++) {
+      int pointsRect = field(i, 2) + 1;
+      float x = rectComponent(pointsRect, 0);
+      float baseline = rectComponent(pointsRect, 1);
+      float fontSize = rectComponent(pointsRect, 3);
+      WritableMap item = Arguments.createMap();
+      item.putString("str", string(field(i, 0), field(i, 1)));
+      item.putString("dir", field(i, 4) != 0 ? "rtl" : "ltr");
+      item.putDouble("width", rectComponent(pointsRect, 2));
+      item.putDouble("height", fontSize);
+      WritableArray transform = Arguments.createArray();
+      transform.pushDouble(fontSize);
+      transform.pushDouble(0);
+      transform.pushDouble(0);
+      transform.pushDouble(fontSize);
+      transform.pushDouble(x);
+      transform.pushDouble(baseline);
+      item.putArray("transform", transform);
+      item.putString("fontName", "");
+      items.pushMap(item);
+    }
+    return items;
+  }
+
+  // The runs as plain text in reading order: words joined by spaces, lines by
+  // line breaks.
+  String readRunText() {
+    StringBuilder text = new StringBuilder();
+    int line = -1;
+    for (int i = 0; i < recordCount; i++) {
+      if (i > 0) text.append(field(i, 3) != line ? '\n' : ' ');
+      line = field(i, 3);
+      text.append(string(field(i, 0), field(i, 1)));
+    }
+    return text.toString();
+  }
+
+  // Rebuilds the tree from pre-order records with their depth. Children are
+  // collected per open level and attached when the level closes.
+  WritableArray readOutline() {
+    WritableArray[] children = new WritableArray[maxDepth() + 2];
+    WritableMap[] open = new WritableMap[children.length];
+    children[0] = Arguments.createArray();
+    int depth = -1;
+    for (int i = 0; i < recordCount; i++) {
+      int itemDepth = field(i, 3);
+      while (depth >= itemDepth) {
+        closeLevel(children, open, depth);
+        depth--;
+      }
+      WritableMap item = Arguments.createMap();
+      item.putString("title", string(field(i, 0), field(i, 1)));
+      item.putInt("pageIndex", field(i, 2));
+      open[itemDepth] = item;
+      children[itemDepth + 1] = null;
+      depth = itemDepth;
+    }
+    while (depth >= 0) {
+      closeLevel(children, open, depth);
+      depth--;
+    }
+    return children[0];
+  }
+
+  WritableArray readOutlineNodes() {
+    WritableArray nodes = Arguments.createArray();
+    for (int i = 0; i < recordCount; i++) {
+      WritableMap node = Arguments.createMap();
+      node.putString("title", string(field(i, 0), field(i, 1)));
+      node.putInt("id", field(i, 2));
+      node.putBoolean("hasChildren", field(i, 3) != 0);
+      node.putInt("pageIndex", field(i, 4));
+      nodes.pushMap(node);
+    }
+    return nodes;
+  }
+
+  // Links as {rect, pageIndex} within the document or {rect, uri} leaving it.
+  WritableArray readLinks() {
+    WritableArray links = Arguments.createArray();
+    for (int i = 0; i < recordCount; i++) {
+      links.pushMap(readLink(i));
+    }
+    return links;
+  }
+
+  WritableMap readLink(int record) {
+    WritableMap link = Arguments.createMap();
+    int rect = field(record, 0);
+    WritableMap box = Arguments.createMap();
+    box.putDouble("x", rectComponent(rect, 0));
+    box.putDouble("y", rectComponent(rect, 1));
+    box.putDouble("width", rectComponent(rect, 2));
+    box.putDouble("height", rectComponent(rect, 3));
+    link.putMap("rect", box);
+    if (field(record, 1) >= 0) link.putInt("pageIndex", field(record, 1));
+    if (field(record, 3) > 0) link.putString("uri", string(field(record, 2), field(record, 3)));
+    return link;
+  }
+
+  private static void closeLevel(WritableArray[] children, WritableMap[] open, int depth) {
+    WritableMap item = open[depth];
+    if (children[depth + 1] != null) {
+      item.putArray("children", children[depth + 1]);
+      children[depth + 1] = null;
+    }
+    if (children[depth] == null) {
+      children[depth] = Arguments.createArray();
+    }
+    children[depth].pushMap(item);
+    open[depth] = null;
+  }
+
+  private int maxDepth() {
+    int max = 0;
+    for (int i = 0; i < recordCount; i++) {
+      max = Math.max(max, field(i, 3));
+    }
+    return max;
+  }
+}
@@ -0,0 +1,196 @@
+package com.papyrus.engine;
+
+import android.content.ComponentCallbacks2;
+import android.graphics.Bitmap;
+
+import java.util.ArrayDeque;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+// Rendered page bitmaps of one engine, least recently used first, keyed by
+// (page, width bucket, rotation) and bounded by a byte budget. Page views hold
+// the entry they draw; held entries are never evicted and their bitmaps are
+// only reused once the last holder lets go. Evicted bitmaps are kept as spares
+// so the next render of the same size reuses their memory.
+final class PapyrusPageCache {
+  // Base layers are rendered at a width rounded up to this, so small layout
+  // or scale changes still hit the cache.
+  static final int WIDTH_BUCKET = 64;
+  // Pages rendered ahead of the reader in the scroll direction.
+  static final int PREFETCH_PAGES = 2;
+  private static final int MAX_SPARES = 2;
+
+  static final class Entry {
+    private final PapyrusPageCache owner;
+    final long key;
+    final Bitmap bitmap;
+    private int users;
+    private boolean cached = true;
+
+    private Entry(PapyrusPageCache owner, long key, Bitmap bitmap) {
+      this.owner = owner;
+      this.key = key;
+      this.bitmap = bitmap;
+    }
+
+    void release() {
+      owner.release(this);
+    }
+  }
+
+  private final LinkedHashMap<Long, Entry> entries = new LinkedHashMap<>(16, 0.75f, true);
+  private final ArrayDeque<Bitmap> spares = new ArrayDeque<>();
+  // Coalescing keys of the pending prefetch jobs, one per slot ahead.
+  private final Object[] prefetchKeys = new Object[PREFETCH_PAGES];
+  private long budgetBytes = Runtime.getRuntime().maxMemory() / 8;
+  private long usedBytes;
+  private int epoch;
+  private int lastPage = -1;
+  private int direction = 1;
+
+  PapyrusPageCache() {
+    for (int i = 0; i < prefetchKeys.length; i++) {
+      prefetchKeys[i] = new Object();
+    }
+  }
+
+  static int bucketWidth(int width) {
+    return Math.max(WIDTH_BUCKET, (width + WIDTH_BUCKET - 1) / WIDTH_BUCKET * WIDTH_BUCKET);
+  }
+
+  private static long key(int pageIndex, int width, int rotation) {
+    int quarterTurns = ((rotation % 360 + 360) % 360) / 90;
+    return ((long) pageIndex << 32) | ((long) width << 2) | quarterTurns;
+  }
+
+  Object prefetchKey(int slot) {
+    return prefetchKeys[slot];
+  }
+
+  synchronized void setBudget(long bytes) {
+    budgetBytes = Math.max(0, bytes);
+    trimTo(budgetBytes);
+  }
+
+  // Changes whenever the cache is cleared; a render started under an older
+  // epoch is dropped by put() because it may show the previous document.
+  synchronized int epoch() {
+    return epoch;
+  }
+
+  // Returns the cached entry, held for the caller, or null.
+  synchronized Entry acquire(int pageIndex, int width, int rotation) {
+    Entry entry = entries.get(key(pageIndex, width, rotation));
+    if (entry != null) entry.users++;
+    return entry;
+  }
+
+  synchronized boolean contains(int pageIndex, int width, int rotation) {
+    return entries.containsKey(key(pageIndex, width, rotation));
+  }
+
+  // A bitmap to render into: a spare of the same size, or a new one.
+  synchronized Bitmap obtain(int width, int height) {
+    Iterator<Bitmap> it = spares.iterator();
+    while (it.hasNext()) {
+      Bitmap spare = it.next();
+      if (spare.getWidth() == width && spare.getHeight() == height) {
+        it.remove();
+        return spare;
+      }
+    }
+    return Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
+  }
+
+  // Gives back a bitmap from obtain() that was not put().
+  synchronized void discard(Bitmap bitmap) {
+    spare(bitmap);
+  }
+
+  // Caches a rendered bitmap and returns its entry held for the caller; null
+  // (and the bitmap is taken back) when the cache was cleared since epoch.
+  synchronized Entry put(int epoch, int pageIndex, int width, int rotation, Bitmap bitmap) {
+    if (epoch != this.epoch) {
+      spare(bitmap);
+      return null;
+    }
+    long key = key(pageIndex, width, rotation);
+    Entry entry = entries.get(key);
+    if (entry != null) {
+      spare(bitmap);
+    } else {
+      entry = new Entry(this, key, bitmap);
+      entries.put(key, entry);
+      usedBytes += bitmap.getAllocationByteCount();
+    }
+    entry.users++;
+    trimTo(budgetBytes);
+    return entry;
+  }
+
+  // Records a page a view asked for and returns the reading direction, +1 or
+  // -1, inferred from the previous one.
+  synchronized int noteRequest(int pageIndex) {
+    if (lastPage >= 0 && pageIndex != lastPage) {
+      direction = pageIndex > lastPage ? 1 : -1;
+    }
+    lastPage = pageIndex;
+    return direction;
+  }
+
+  synchronized void clear() {
+    epoch++;
+    lastPage = -1;
+    for (Entry entry : entries.values()) {
+      entry.cached = false;
+      if (entry.users == 0) spare(entry.bitmap);
+    }
+    entries.clear();
+    usedBytes = 0;
+    for (Bitmap spare : spares) {
+      spare.recycle();
+    }
+    spares.clear();
+  }
+
+  // Drops half the cache while the app runs low on memory and everything
+  // not on screen once it is in the background or memory is critical.
+  synchronized void trimMemory(int level) {
+    if (level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL) {
+      trimTo(0);
+    } else if (level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE) {
+      trimTo(usedBytes / 2);
+    }
+    for (Bitmap spare : spares) {
+      spare.recycle();
+    }
+    spares.clear();
+  }
+
+  private synchronized void release(Entry entry) {
+    if (entry.users > 0) entry.users--;
+    if (entry.users == 0 && !entry.cached) spare(entry.bitmap);
+  }
+
+  private void trimTo(long bytes) {
+    Iterator<Map.Entry<Long, Entry>> it = entries.entrySet().iterator();
+    while (usedBytes > bytes && it.hasNext()) {
+      Entry entry = it.next().getValue();
+      if (entry.users > 0) continue;
+      it.remove();
+      entry.cached = false;
+      usedBytes -= entry.bitmap.getAllocationByteCount();
+      spare(entry.bitmap);
+    }
+  }
+
+  private void spare(Bitmap bitmap) {
+    if (bitmap == null || bitmap.isRecycled()) return;
+    if (spares.size() < MAX_SPARES) {
+      spares.push(bitmap);
+    } else {
+      bitmap.recycle();
+    }
+  }
+}
@@ -5,19 +5,79 @@ import android.graphics.Bitmap;
 import android.graphics.Canvas;
 import android.graphics.Paint;
 import android.graphics.Rect;
+import android.graphics.RectF;
 import android.util.AttributeSet;
 import android.view.View;
+import android.view.ViewTreeObserver;
 
 import com.shockwave.pdfium.PdfDocument;
 
-import java.util.concurrent.ExecutorService;
-import java.util.concurrent.Executors;
+import java.io.File;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Iterator;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
 
+// Draws one page. The whole page is rendered once at zoom 1 as a base layer;
+// when zoomed in, only the fixed-size tiles of the zoomed page that are on
+// screen are rendered on top, nearest to the center first, so a deep zoom
+// costs about a screenful of pixels instead of the whole enlarged page. Base
+// layers come from the engine's page cache (PapyrusPageCache), which also
+// renders the next pages ahead of the reader. In a sidebar, the view shows a
+// thumbnail instead (renderThumbnail).
 class PapyrusPageView extends View {
-  private static final ExecutorService RENDER_EXECUTOR = Executors.newSingleThreadExecutor();
+  // How soon a thumbnail of a page still downloading is tried again.
+  private static final long THUMBNAIL_RETRY_MS = 500;
 
-  private final Paint paint = new Paint(Paint.ANTI_ALIAS_FLAG);
-  private Bitmap bitmap;
+  private final Paint paint = new Paint(Paint.ANTI_ALIAS_FLAG | Paint.FILTER_BITMAP_FLAG);
+  // Base layer, held from the engine's page cache while drawn.
+  private PapyrusPageCache.Entry base;
+  private volatile int renderGeneration = 0;
+  private volatile boolean attached = false;
+  private boolean needsRender = false;
+  private PapyrusEngineStore.EngineState lastState;
+  private int lastPageIndex;
+  private float lastScale;
+  private float lastZoom;
+  private int lastRotation;
+  private boolean lastThumbnail;
+
+  // Tile layer, touched on the UI thread only. Tiles are keyed by
+  // (row << 32 | column) on the zoomed page of size tilePageWidth x tilePageHeight.
+  private final Map<Long, Bitmap> tiles = new HashMap<>();
+  private final Set<Long> pendingTiles = new HashSet<>();
+  private PapyrusEngineStore.EngineState tileState;
+  private int tilePageIndex;
+  private int tilePageWidth;
+  private int tilePageHeight;
+  private float tileScale;
+  // Columns (left/right) and rows (top/bottom) worth rendering; read by
+  // queued tile jobs to skip tiles scrolled away before their turn.
+  private volatile Rect wantedTiles;
+  private final Rect visible = new Rect();
+  private final Rect tileSource = new Rect();
+  private final RectF tileDest = new RectF();
+  private final ViewTreeObserver.OnScrollChangedListener scrollListener = () -> {
+    updateTiles();
+    updateThumbnail();
+  };
+  // Coalescing key and generation of the text layer request.
+  private final Object textLayerKey = new Object();
+  private volatile int textLayerGeneration = 0;
+
+  // Thumbnail layer, touched on the UI thread only. thumbnailVisible is also
+  // read by the queued thumbnail job, which leaves views scrolled out of the
+  // sidebar for when they come back.
+  private Bitmap thumbnail;
+  private PapyrusThumbnailPool thumbnailPool;
+  private PapyrusEngineStore.EngineState thumbnailState;
+  private int thumbnailPage;
+  private boolean thumbnailPending;
+  private volatile boolean thumbnailVisible;
 
   PapyrusPageView(Context context) {
     super(context);
@@ -32,8 +92,7 @@ class PapyrusPageView extends View {
               final float scale,
               final float zoom,
               final int rotation) {
-    if (state == null || state.document == null) return;
-    if (state.isSearching) return;
+    if (state == null || !state.hasDocument()) return;
     if (getWidth() == 0 || getHeight() == 0) {
       post(() -> render(state, pageIndex, scale, zoom, rotation));
       return;
@@ -45,42 +104,463 @@ class PapyrusPageView extends View {
     final float targetScale = Math.max(0.1f, scale) * clampedZoom;
     final int renderWidth = Math.max(1, (int) (viewWidth * targetScale));
     final int renderHeight = Math.max(1, (int) (viewHeight * targetScale));
+    final boolean tiled = PapyrusRender.AVAILABLE && state.session != 0;
+    final float baseDivisor = tiled ? Math.max(1.0f, clampedZoom) : 1.0f;
+    final int baseWidth = Math.max(1, (int) (renderWidth / baseDivisor));
+    final int cacheWidth = PapyrusPageCache.bucketWidth(baseWidth);
+    final int cacheHeight = Math.max(1, Math.round(cacheWidth * (float) renderHeight / renderWidth));
+
+    lastState = state;
+    lastPageIndex = pageIndex;
+    lastScale = scale;
+    lastZoom = zoom;
+    lastRotation = rotation;
+    lastThumbnail = false;
+    needsRender = true;
+
+    final int generation = ++renderGeneration;
+    releaseTiles();
+    tileState = null;
+    releaseThumbnail();
+    thumbnailState = null;
+    PapyrusPageCache.Entry cached = state.pageCache.acquire(pageIndex, cacheWidth, rotation);
+    if (cached != null) {
+      showBase(cached);
+    } else {
+      submitBase(state, generation, pageIndex, cacheWidth, cacheHeight, rotation);
+    }
+    prefetch(state, pageIndex, cacheWidth, rotation);
+
+    if (tiled && baseWidth < renderWidth) {
+      tileState = state;
+      tilePageIndex = pageIndex;
+      tilePageWidth = renderWidth;
+      tilePageHeight = renderHeight;
+      tileScale = targetScale;
+      updateTiles();
+    }
+  }
 
-    RENDER_EXECUTOR.execute(() -> {
-      PdfDocument doc = state.document;
-      if (doc == null) return;
+  // Queues the base render; while the page downloads it is queued again on
+  // each progress of the download instead of holding the scheduler thread.
+  private void submitBase(final PapyrusEngineStore.EngineState state, final int generation, final int pageIndex,
+                          final int width, final int height, final int rotation) {
+    state.scheduler.submitCoalesced(PapyrusScheduler.PRIORITY_RENDER, this, () -> {
+      if (!isCurrentRender(generation)) return;
+      if (PapyrusEngineStore.waitForPage(state, pageIndex, () -> {
+        if (isCurrentRender(generation)) submitBase(state, generation, pageIndex, width, height, rotation);
+      })) {
+        return;
+      }
+      PapyrusPageCache.Entry entry = renderBase(state, pageIndex, width, height, rotation);
+      if (entry == null) return;
+      post(() -> {
+        if (generation != renderGeneration) {
+          entry.release();
+          return;
+        }
+        showBase(entry);
+      });
+    });
+  }
 
+  // Draws a thumbnail of the page for sidebars: rendered natively at no more
+  // than PapyrusThumbnailPool.MAX_WIDTH, cached on disk under the engine's
+  // thumbnailDir, and only once the view is on screen, below page renders.
+  // Without the native core it renders the page like render() does.
+  void renderThumbnail(final PapyrusEngineStore.EngineState state, final int pageIndex) {
+    if (state == null || !state.hasDocument()) return;
+    if (!PapyrusRender.AVAILABLE || state.session == 0) {
+      render(state, pageIndex, 1.0f, 1.0f, 0);
+      return;
+    }
+    if (getWidth() == 0 || getHeight() == 0) {
+      post(() -> renderThumbnail(state, pageIndex));
+      return;
+    }
+
+    lastState = state;
+    lastPageIndex = pageIndex;
+    lastThumbnail = true;
+    needsRender = true;
+
+    ++renderGeneration;
+    releaseTiles();
+    tileState = null;
+    if (base != null) {
+      base.release();
+      base = null;
+    }
+    releaseThumbnail();
+    thumbnailState = state;
+    thumbnailPage = pageIndex;
+    thumbnailPending = true;
+    updateThumbnail();
+  }
+
+  // Exposes the page's text, in reading order, to accessibility services as the
+  // view's content description.
+  void renderTextLayer(final PapyrusEngineStore.EngineState state, final int pageIndex) {
+    submitTextLayer(state, ++textLayerGeneration, pageIndex);
+  }
+
+  private void submitTextLayer(final PapyrusEngineStore.EngineState state, final int generation, final int pageIndex) {
+    state.scheduler.submitCoalesced(PapyrusScheduler.PRIORITY_SELECTION, textLayerKey, () -> {
+      if (PapyrusEngineStore.waitForPage(state, pageIndex, () -> {
+        if (generation == textLayerGeneration) submitTextLayer(state, generation, pageIndex);
+      })) {
+        return;
+      }
+      String text = null;
       try {
-        Bitmap rendered = null;
         synchronized (state.pdfiumLock) {
-          if (doc != state.document) return;
-          int pageCount = state.pdfium.getPageCount(doc);
-          if (pageIndex < 0 || pageIndex >= pageCount) return;
+          if (state.session != 0) {
+            PapyrusPacked packed = PapyrusPacked.wrap(
+                PapyrusTextSelect.nativeGetTextRuns(state.session, pageIndex), PapyrusPacked.KIND_TEXT_RUNS);
+            if (packed != null) text = packed.readRunText();
+          }
+        }
+      } catch (Throwable ignored) {
+        text = null;
+      }
+      if (text == null) return;
+      final String pageText = text;
+      post(() -> {
+        if (generation != textLayerGeneration) return;
+        setContentDescription(pageText);
+        setImportantForAccessibility(IMPORTANT_FOR_ACCESSIBILITY_YES);
+      });
+    });
+  }
+
+  // Queues the pending thumbnail once the view is on screen.
+  private void updateThumbnail() {
+    if (thumbnailState == null || !attached) return;
+    thumbnailVisible = getLocalVisibleRect(visible);
+    if (!thumbnailVisible || !thumbnailPending) return;
+    thumbnailPending = false;
+    submitThumbnail();
+  }
+
+  private void submitThumbnail() {
+    final PapyrusEngineStore.EngineState state = thumbnailState;
+    final int generation = renderGeneration;
+    final int pageIndex = thumbnailPage;
+    final int width = Math.min(getWidth(), PapyrusThumbnailPool.MAX_WIDTH);
+    final int height = Math.max(1, Math.round(width * (float) getHeight() / getWidth()));
+    state.scheduler.submitCoalesced(PapyrusScheduler.PRIORITY_THUMBNAIL, this, () -> {
+      if (!isCurrentRender(generation)) return;
+      // Scrolled away, or waiting for its data: tried again once back on
+      // screen, or a little later, so it never holds up the page renders.
+      if (!thumbnailVisible || !PapyrusEngineStore.isPageReady(state, pageIndex)) {
+        postDelayed(() -> retryThumbnail(generation), thumbnailVisible ? THUMBNAIL_RETRY_MS : 0);
+        return;
+      }
+      File directory = state.thumbnailDir;
+      String cachePath = directory != null && (directory.isDirectory() || directory.mkdirs()) ? directory.getPath() : null;
+      Bitmap rendered = state.thumbnails.acquire(width, height);
+      int result;
+      try {
+        synchronized (state.pdfiumLock) {
+          result = state.session != 0
+              ? PapyrusRender.nativeRenderThumbnail(state.session, pageIndex, rendered, cachePath)
+              : PapyrusRender.THUMBNAIL_FAILED;
+        }
+      } catch (Throwable ignored) {
+        result = PapyrusRender.THUMBNAIL_FAILED;
+      }
+      if (result == PapyrusRender.THUMBNAIL_FAILED) {
+        state.thumbnails.release(rendered);
+        return;
+      }
+      post(() -> {
+        if (generation != renderGeneration) {
+          state.thumbnails.release(rendered);
+          return;
+        }
+        showThumbnail(state.thumbnails, rendered);
+      });
+    });
+  }
+
+  private void retryThumbnail(int generation) {
+    if (generation != renderGeneration) return;
+    thumbnailPending = true;
+    updateThumbnail();
+  }
+
+  private void showThumbnail(PapyrusThumbnailPool pool, Bitmap bitmap) {
+    releaseThumbnail();
+    thumbnail = bitmap;
+    thumbnailPool = pool;
+    needsRender = false;
+    invalidate();
+  }
+
+  // Returns the drawn thumbnail to its pool; true if there was one.
+  private boolean releaseThumbnail() {
+    if (thumbnail == null) return false;
+    thumbnailPool.release(thumbnail);
+    thumbnail = null;
+    thumbnailPool = null;
+    return true;
+  }
+
+  private void showBase(PapyrusPageCache.Entry entry) {
+    if (base != null) base.release();
+    base = entry;
+    needsRender = false;
+    invalidate();
+  }
+
+  // Renders a page at width x height into the engine's page cache and returns
+  // the entry held for the caller, or null if the page or document is gone,
+  // or the page's data has not been downloaded yet.
+  static PapyrusPageCache.Entry renderBase(PapyrusEngineStore.EngineState state, int pageIndex, int width, int height,
+                                           int rotation) {
+    if (!state.hasDocument() || !PapyrusEngineStore.isPageReady(state, pageIndex)) return null;
+    Bitmap rendered = null;
+    int epoch;
+    try {
+      synchronized (state.pdfiumLock) {
+        PdfDocument doc = state.document;
+        if (pageIndex < 0 || pageIndex >= PapyrusEngineStore.pageCount(state)) return null;
+        epoch = state.pageCache.epoch();
+        rendered = state.pageCache.obtain(width, height);
+        if (!PapyrusRender.AVAILABLE || state.session == 0
+            || !PapyrusRender.nativeRenderRegion(state.session, pageIndex, rendered, width, height, 0, 0)) {
+          if (doc == null) {
+            state.pageCache.discard(rendered);
+            return null;
+          }
           state.pdfium.openPage(doc, pageIndex);
-          rendered = Bitmap.createBitmap(renderWidth, renderHeight, Bitmap.Config.ARGB_8888);
-          state.pdfium.renderPageBitmap(doc, rendered, pageIndex, 0, 0, renderWidth, renderHeight, true);
+          state.pdfium.renderPageBitmap(doc, rendered, pageIndex, 0, 0, width, height, true);
         }
+      }
+    } catch (Throwable ignored) {
+      if (rendered != null) state.pageCache.discard(rendered);
+      return null;
+    }
+    return state.pageCache.put(epoch, pageIndex, width, rotation, rendered);
+  }
+
+  // Renders the next pages in the reading direction at the lowest priority, at
+  // the same width, so continuous scrolling finds them in the cache. A newer
+  // request replaces the prefetches still queued.
+  private static void prefetch(final PapyrusEngineStore.EngineState state, int pageIndex, final int width, final int rotation) {
+    int direction = state.pageCache.noteRequest(pageIndex);
+    for (int slot = 0; slot < PapyrusPageCache.PREFETCH_PAGES; slot++) {
+      final int page = pageIndex + direction * (slot + 1);
+      if (page < 0) break;
+      state.scheduler.submitCoalesced(PapyrusScheduler.PRIORITY_PREWARM, state.pageCache.prefetchKey(slot), () -> {
+        // Never waits on a download; asking is enough to fetch the page ahead.
+        if (state.pageCache.contains(page, width, rotation) || !PapyrusEngineStore.isPageReady(state, page)) return;
+        int height = prefetchHeight(state, page, width);
+        if (height <= 0) return;
+        PapyrusPageCache.Entry entry = renderBase(state, page, width, height, rotation);
+        if (entry != null) entry.release();
+      });
+    }
+  }
+
+  // The height a view of the given width shows the page at, from its aspect.
+  private static int prefetchHeight(PapyrusEngineStore.EngineState state, int pageIndex, int width) {
+    PdfDocument doc = state.document;
+    if (doc == null) {
+      float[] size = PapyrusEngineStore.sessionPageSize(state, pageIndex);
+      if (size == null || size[0] <= 0 || size[1] <= 0) return 0;
+      return Math.max(1, Math.round(width * size[1] / size[0]));
+    }
+    try {
+      synchronized (state.pdfiumLock) {
+        if (doc != state.document || pageIndex >= state.pdfium.getPageCount(doc)) return 0;
+        state.pdfium.openPage(doc, pageIndex);
+        int pageWidth = state.pdfium.getPageWidthPoint(doc, pageIndex);
+        int pageHeight = state.pdfium.getPageHeightPoint(doc, pageIndex);
+        if (pageWidth <= 0 || pageHeight <= 0) return 0;
+        return Math.max(1, Math.round(width * (float) pageHeight / pageWidth));
+      }
+    } catch (Throwable ignored) {
+      return 0;
+    }
+  }
+
+  // A render is dropped once the view asked for a newer one or left the window,
+  // e.g. a page the list has already scrolled past.
+  private boolean isCurrentRender(int generation) {
+    return attached && generation == renderGeneration;
+  }
 
-        if (rendered == null) return;
-        final Bitmap renderedBitmap = rendered;
+  // Queues the visible tiles that are neither drawn nor queued yet and returns
+  // the ones more than a tile away from the screen to the pool.
+  private void updateTiles() {
+    if (tileState == null || !attached || !getLocalVisibleRect(visible)) return;
+    int tileSize = PapyrusTilePool.TILE_SIZE;
+    int columns = (tilePageWidth + tileSize - 1) / tileSize;
+    int rows = (tilePageHeight + tileSize - 1) / tileSize;
+    int firstColumn = Math.max(0, (int) (visible.left * tileScale) / tileSize);
+    int lastColumn = Math.min(columns - 1, (int) (visible.right * tileScale) / tileSize);
+    int firstRow = Math.max(0, (int) (visible.top * tileScale) / tileSize);
+    int lastRow = Math.min(rows - 1, (int) (visible.bottom * tileScale) / tileSize);
+    Rect wanted = new Rect(Math.max(0, firstColumn - 1), Math.max(0, firstRow - 1),
+        Math.min(columns, lastColumn + 2), Math.min(rows, lastRow + 2));
+    wantedTiles = wanted;
 
-        post(() -> {
-          if (bitmap != null && !bitmap.isRecycled()) {
-            bitmap.recycle();
+    Iterator<Map.Entry<Long, Bitmap>> drawn = tiles.entrySet().iterator();
+    while (drawn.hasNext()) {
+      Map.Entry<Long, Bitmap> entry = drawn.next();
+      if (!wanted.contains(tileColumn(entry.getKey()), tileRow(entry.getKey()))) {
+        tileState.tiles.release(entry.getValue());
+        drawn.remove();
+      }
+    }
+
+    List<Long> missing = new ArrayList<>();
+    for (int row = firstRow; row <= lastRow; row++) {
+      for (int column = firstColumn; column <= lastColumn; column++) {
+        long key = tileKey(column, row);
+        if (!tiles.containsKey(key) && !pendingTiles.contains(key)) missing.add(key);
+      }
+    }
+    final float centerColumn = (firstColumn + lastColumn) / 2.0f;
+    final float centerRow = (firstRow + lastRow) / 2.0f;
+    Collections.sort(missing, (a, b) -> Float.compare(
+        centerDistance(a, centerColumn, centerRow), centerDistance(b, centerColumn, centerRow)));
+    for (long key : missing) {
+      pendingTiles.add(key);
+      submitTile(key);
+    }
+  }
+
+  private void submitTile(final long key) {
+    final PapyrusEngineStore.EngineState state = tileState;
+    final int generation = renderGeneration;
+    final int pageIndex = tilePageIndex;
+    final int pageWidth = tilePageWidth;
+    final int pageHeight = tilePageHeight;
+    final int left = tileColumn(key) * PapyrusTilePool.TILE_SIZE;
+    final int top = tileRow(key) * PapyrusTilePool.TILE_SIZE;
+    state.scheduler.submit(PapyrusScheduler.PRIORITY_RENDER, () -> {
+      Rect wanted = wantedTiles;
+      if (!isCurrentRender(generation) || wanted == null || !wanted.contains(tileColumn(key), tileRow(key))) {
+        post(() -> dropPendingTile(generation, key));
+        return;
+      }
+      Bitmap tile = state.tiles.acquire();
+      boolean rendered = false;
+      try {
+        synchronized (state.pdfiumLock) {
+          if (state.session != 0) {
+            rendered = PapyrusRender.nativeRenderRegion(state.session, pageIndex, tile, pageWidth, pageHeight, left, top);
           }
-          bitmap = renderedBitmap;
-          invalidate();
-        });
+        }
       } catch (Throwable ignored) {
+        rendered = false;
+      }
+      if (!rendered) {
+        state.tiles.release(tile);
+        post(() -> dropPendingTile(generation, key));
+        return;
       }
+      post(() -> {
+        if (generation != renderGeneration) {
+          state.tiles.release(tile);
+          return;
+        }
+        pendingTiles.remove(key);
+        Bitmap previous = tiles.put(key, tile);
+        if (previous != null) state.tiles.release(previous);
+        invalidate();
+      });
     });
   }
 
+  private void dropPendingTile(int generation, long key) {
+    if (generation == renderGeneration) pendingTiles.remove(key);
+  }
+
+  private void releaseTiles() {
+    if (tileState != null) {
+      for (Bitmap tile : tiles.values()) {
+        tileState.tiles.release(tile);
+      }
+    }
+    tiles.clear();
+    pendingTiles.clear();
+    wantedTiles = null;
+  }
+
+  private static long tileKey(int column, int row) {
+    return ((long) row << 32) | (column & 0xFFFFFFFFL);
+  }
+
+  private static int tileColumn(long key) {
+    return (int) key;
+  }
+
+  private static int tileRow(long key) {
+    return (int) (key >>> 32);
+  }
+
+  private static float centerDistance(long key, float centerColumn, float centerRow) {
+    float dx = tileColumn(key) - centerColumn;
+    float dy = tileRow(key) - centerRow;
+    return dx * dx + dy * dy;
+  }
+
+  @Override
+  protected void onAttachedToWindow() {
+    super.onAttachedToWindow();
+    attached = true;
+    getViewTreeObserver().addOnScrollChangedListener(scrollListener);
+    if (needsRender && lastState != null && lastThumbnail) {
+      renderThumbnail(lastState, lastPageIndex);
+    } else if (needsRender && lastState != null) {
+      render(lastState, lastPageIndex, lastScale, lastZoom, lastRotation);
+    } else {
+      updateTiles();
+      updateThumbnail();
+    }
+  }
+
+  @Override
+  protected void onDetachedFromWindow() {
+    attached = false;
+    renderGeneration++;
+    getViewTreeObserver().removeOnScrollChangedListener(scrollListener);
+    releaseTiles();
+    thumbnailVisible = false;
+    // Detached views may never come back, so they must not pin cache entries
+    // or thumbnails; a view that does come back finds its page in the cache.
+    if (base != null) {
+      base.release();
+      base = null;
+      needsRender = lastState != null;
+    }
+    if (releaseThumbnail()) needsRender = lastState != null;
+    super.onDetachedFromWindow();
+  }
+
   @Override
   protected void onDraw(Canvas canvas) {
     super.onDraw(canvas);
-    if (bitmap == null) return;
-    Rect dest = new Rect(0, 0, getWidth(), getHeight());
-    canvas.drawBitmap(bitmap, null, dest, paint);
+    if (base != null) {
+      Rect dest = new Rect(0, 0, getWidth(), getHeight());
+      canvas.drawBitmap(base.bitmap, null, dest, paint);
+    }
+    if (thumbnail != null) {
+      Rect dest = new Rect(0, 0, getWidth(), getHeight());
+      canvas.drawBitmap(thumbnail, null, dest, paint);
+    }
+    int tileSize = PapyrusTilePool.TILE_SIZE;
+    for (Map.Entry<Long, Bitmap> entry : tiles.entrySet()) {
+      int left = tileColumn(entry.getKey()) * tileSize;
+      int top = tileRow(entry.getKey()) * tileSize;
+      int right = Math.min(left + tileSize, tilePageWidth);
+      int bottom = Math.min(top + tileSize, tilePageHeight);
+      tileSource.set(0, 0, right - left, bottom - top);
+      tileDest.set(left / tileScale, top / tileScale, right / tileScale, bottom / tileScale);
+      canvas.drawBitmap(entry.getValue(), tileSource, tileDest, paint);
+    }
   }
 }
@@ -0,0 +1,54 @@
+package com.papyrus.engine;
+
+// Sessions over a PDF that is still downloading (papyrus_progressive.h). A
+// source handle tracks which bytes of the download file have arrived and which
+// ranges PDFium needs next; the session reads through it and is closed with
+// PapyrusDocumentSession.nativeClose like any other.
+final class PapyrusProgressive {
+  static final boolean AVAILABLE;
+
+  static {
+    boolean available = false;
+    try {
+      System.loadLibrary("papyrus_text");
+      available = true;
+    } catch (Throwable ignored) {
+      available = false;
+    }
+    AVAILABLE = available;
+  }
+
+  static final int DOCUMENT_ERROR = -1;
+  static final int DOCUMENT_WAITING = 0;
+  static final int DOCUMENT_READY = 1;
+
+  static boolean isSupported() {
+    if (!AVAILABLE) return false;
+    try {
+      return nativeIsSupported();
+    } catch (Throwable ignored) {
+      return false;
+    }
+  }
+
+  static native boolean nativeIsSupported();
+
+  // fd will hold length bytes once downloaded; it may be closed afterwards.
+  static native long nativeSourceCreate(int fd, long length);
+
+  // Thread-safe: called from the download threads.
+  static native void nativeSourceReceived(long source, long offset, long length);
+
+  // Ranges PDFium asked for since the last call, as {offset, length, ...}, or
+  // null if there are none.
+  static native long[] nativeSourceTakeRequests(long source);
+
+  static native void nativeSourceRelease(long source);
+
+  static native long nativeOpen(long source, long stats);
+
+  // DOCUMENT_READY once the document is loaded and its page count known.
+  static native int nativePollDocument(long session);
+
+  static native boolean nativeIsPageReady(long session, int pageIndex);
+}
@@ -0,0 +1,37 @@
+package com.papyrus.engine;
+
+import android.graphics.Bitmap;
+
+// Rasterizes page regions with the native core (papyrus_render.h) straight
+// into the pixels of an ARGB_8888 bitmap, and page thumbnails
+// (papyrus_thumbnail.h) into RGB_565 ones.
+final class PapyrusRender {
+  static final boolean AVAILABLE;
+  // nativeRenderThumbnail results, as ThumbnailResult.
+  static final int THUMBNAIL_FAILED = 0;
+  static final int THUMBNAIL_CACHED = 1;
+  static final int THUMBNAIL_RENDERED = 2;
+
+  static {
+    boolean available = false;
+    try {
+      System.loadLibrary("papyrus_text");
+      available = true;
+    } catch (Throwable ignored) {
+      available = false;
+    }
+    AVAILABLE = available;
+  }
+
+  // Fills target with the region at (left, top) of the page scaled to
+  // pageWidth x pageHeight pixels.
+  static native boolean nativeRenderRegion(long session, int pageIndex, Bitmap target, int pageWidth, int pageHeight, int left, int top);
+
+  // Fills target (RGB_565) with a thumbnail of the page, read from the cache
+  // under directory when there and written there otherwise; directory may be
+  // null. Returns one of the THUMBNAIL_ results.
+  static native int nativeRenderThumbnail(long session, int pageIndex, Bitmap target, String directory);
+
+  // {width, height} of the page in points, or null if it cannot be loaded yet.
+  static native float[] nativeGetPageSize(long session, int pageIndex);
+}
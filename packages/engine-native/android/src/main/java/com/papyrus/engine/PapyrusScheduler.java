@@ -0,0 +1,136 @@
+package com.papyrus.engine;
+
+import com.facebook.react.bridge.Promise;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.PriorityBlockingQueue;
+import java.util.concurrent.atomic.AtomicLong;
+
+// Runs all PDFium work of one engine on a single thread, highest priority first.
+// Long jobs (search) are split into batches by their callers so that queued
+// renders get the thread between two batches. A job answering a JS call carries
+// its promise, which is rejected if the job throws or never runs because the
+// engine was destroyed first; resolving it is up to the job.
+final class PapyrusScheduler {
+  static final int PRIORITY_RENDER = 0;
+  static final int PRIORITY_SELECTION = 1;
+  static final int PRIORITY_OUTLINE = 2;
+  // Sidebar thumbnails on screen: shown, but second to the page being read.
+  static final int PRIORITY_THUMBNAIL = 3;
+  static final int PRIORITY_SEARCH = 4;
+  // Speculative work nobody waits for yet, e.g. prewarming page text.
+  static final int PRIORITY_PREWARM = 5;
+
+  private static final class Job implements Comparable<Job> {
+    final int priority;
+    final long sequence;
+    final Object coalesceKey;
+    final Promise promise;
+    final Runnable task;
+    volatile boolean cancelled;
+
+    Job(int priority, long sequence, Object coalesceKey, Promise promise, Runnable task) {
+      this.priority = priority;
+      this.sequence = sequence;
+      this.coalesceKey = coalesceKey;
+      this.promise = promise;
+      this.task = task;
+    }
+
+    @Override
+    public int compareTo(Job other) {
+      if (priority != other.priority) return priority < other.priority ? -1 : 1;
+      return Long.compare(sequence, other.sequence);
+    }
+  }
+
+  private final PriorityBlockingQueue<Job> queue = new PriorityBlockingQueue<>();
+  private final Map<Object, Job> pendingByKey = new ConcurrentHashMap<>();
+  private final AtomicLong sequence = new AtomicLong();
+  private final Thread thread;
+  private volatile boolean shutdown = false;
+
+  PapyrusScheduler(String name) {
+    thread = new Thread(this::drain, name);
+    thread.setDaemon(true);
+    thread.start();
+  }
+
+  void submit(int priority, Runnable task) {
+    submit(priority, null, task);
+  }
+
+  // Jobs resubmitting themselves in batches pass the same promise each time.
+  void submit(int priority, Promise promise, Runnable task) {
+    if (shutdown) {
+      reject(promise, null);
+      return;
+    }
+    queue.add(new Job(priority, sequence.getAndIncrement(), null, promise, task));
+    // Raced with shutdown(), which may have drained the queue already.
+    if (shutdown) rejectQueued();
+  }
+
+  // Queues a job that replaces any job still pending under the same key, e.g. a
+  // render for a page view that has since been asked to draw something else.
+  void submitCoalesced(int priority, Object key, Runnable task) {
+    if (shutdown) return;
+    Job job = new Job(priority, sequence.getAndIncrement(), key, null, task);
+    Job previous = pendingByKey.put(key, job);
+    if (previous != null) {
+      previous.cancelled = true;
+    }
+    queue.add(job);
+  }
+
+  void shutdown() {
+    shutdown = true;
+    rejectQueued();
+    pendingByKey.clear();
+    thread.interrupt();
+  }
+
+  private void rejectQueued() {
+    List<Job> dropped = new ArrayList<>();
+    queue.drainTo(dropped);
+    for (Job job : dropped) {
+      reject(job.promise, null);
+    }
+  }
+
+  private static void reject(Promise promise, Throwable error) {
+    if (promise == null) return;
+    if (error != null) {
+      promise.reject("papyrus_engine_error", error);
+    } else {
+      promise.reject("papyrus_engine_closed", "Engine was destroyed");
+    }
+  }
+
+  private void drain() {
+    while (!shutdown) {
+      Job job;
+      try {
+        job = queue.take();
+      } catch (InterruptedException interrupted) {
+        continue;
+      }
+      if (job.coalesceKey != null) {
+        pendingByKey.remove(job.coalesceKey, job);
+      }
+      if (job.cancelled) continue;
+      if (shutdown) {
+        reject(job.promise, null);
+        continue;
+      }
+      try {
+        job.task.run();
+      } catch (Throwable error) {
+        reject(job.promise, error);
+      }
+    }
+  }
+}
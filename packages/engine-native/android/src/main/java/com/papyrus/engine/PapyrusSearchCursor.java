@@ -0,0 +1,28 @@
+package com.papyrus.engine;
+
+final class PapyrusSearchCursor {
+  private long handle;
+
+  PapyrusSearchCursor(long handle) {
+    this.handle = handle;
+  }
+
+  // Read by the engine scheduler while it holds the engine's pdfiumLock; close()
+  // runs under the same lock, so the handle cannot be freed mid-batch.
+  long handle() {
+    return handle;
+  }
+
+  synchronized void cancel() {
+    if (handle != 0) {
+      PapyrusTextSearch.nativeCursorCancel(handle);
+    }
+  }
+
+  synchronized void close() {
+    if (handle != 0) {
+      PapyrusTextSearch.nativeCursorClose(handle);
+      handle = 0;
+    }
+  }
+}
@@ -0,0 +1,106 @@
+package com.papyrus.engine;
+
+import com.facebook.react.bridge.Arguments;
+import com.facebook.react.bridge.WritableArray;
+import com.facebook.react.bridge.WritableMap;
+
+// Per-engine native counters and latency histograms (papyrus_stats.h). Sessions
+// opened by the engine record into the same native object, so the numbers
+// accumulate across documents until reset.
+final class PapyrusStats {
+  static final boolean AVAILABLE;
+
+  static {
+    boolean available = false;
+    try {
+      System.loadLibrary("papyrus_text");
+      available = true;
+    } catch (Throwable ignored) {
+      available = false;
+    }
+    AVAILABLE = available;
+  }
+
+  // Same order as StatPhase / StatCounter.
+  static final int PHASE_MARSHAL = 6;
+  private static final String[] PHASES = {
+    "pageLoad", "textLoad", "glyphs", "textIndex", "find", "preview", "marshal", "render",
+  };
+  private static final String[] COUNTERS = {
+    "textCacheHits", "textCacheMisses", "textCacheEvictions", "pagesScanned", "searchHits", "pagesSkipped",
+    "thumbnailCacheHits", "thumbnailsRendered",
+  };
+
+  private long handle;
+
+  PapyrusStats() {
+    long created = 0;
+    if (AVAILABLE) {
+      try {
+        created = nativeCreate();
+      } catch (Throwable ignored) {
+        created = 0;
+      }
+    }
+    this.handle = created;
+  }
+
+  // Handed to nativeOpen; valid until close(), which runs after the engine's
+  // session is closed.
+  synchronized long handle() {
+    return handle;
+  }
+
+  synchronized void record(int phase, long nanos) {
+    if (handle != 0) {
+      nativeRecord(handle, phase, nanos);
+    }
+  }
+
+  synchronized WritableMap snapshot(boolean reset) {
+    long[] values = handle != 0 ? nativeSnapshot(handle, reset) : null;
+    WritableMap result = Arguments.createMap();
+    WritableMap phases = Arguments.createMap();
+    WritableMap counters = Arguments.createMap();
+    result.putMap("phases", phases);
+    result.putMap("counters", counters);
+    if (values == null || values.length < 3) return result;
+
+    int phaseCount = (int) values[0];
+    int bucketCount = (int) values[1];
+    int counterCount = (int) values[2];
+    int at = 3;
+    for (int phase = 0; phase < phaseCount; phase++) {
+      WritableMap entry = Arguments.createMap();
+      entry.putDouble("count", values[at]);
+      entry.putDouble("totalMs", values[at + 1] / 1e6);
+      entry.putDouble("maxMs", values[at + 2] / 1e6);
+      WritableArray histogram = Arguments.createArray();
+      for (int bucket = 0; bucket < bucketCount; bucket++) {
+        histogram.pushDouble(values[at + 3 + bucket]);
+      }
+      entry.putArray("histogram", histogram);
+      if (phase < PHASES.length) phases.putMap(PHASES[phase], entry);
+      at += 3 + bucketCount;
+    }
+    for (int counter = 0; counter < counterCount && counter < COUNTERS.length; counter++) {
+      counters.putDouble(COUNTERS[counter], values[at + counter]);
+    }
+    return result;
+  }
+
+  synchronized void close() {
+    if (handle != 0) {
+      nativeDestroy(handle);
+      handle = 0;
+    }
+  }
+
+  private static native long nativeCreate();
+
+  private static native void nativeDestroy(long stats);
+
+  private static native void nativeRecord(long stats, int phase, long nanos);
+
+  private static native long[] nativeSnapshot(long stats, boolean reset);
+}
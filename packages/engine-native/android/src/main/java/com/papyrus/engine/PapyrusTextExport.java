@@ -0,0 +1,62 @@
+package com.papyrus.engine;
+
+import java.nio.ByteBuffer;
+
+// A whole-document text export in progress: the natives of
+// papyrus_text_export_jni.cpp and one open export handle.
+final class PapyrusTextExport {
+  static final boolean AVAILABLE;
+
+  // Mirror kExportPageMarkers in papyrus_text_export.h.
+  static final int PAGE_MARKERS = 1;
+
+  static {
+    boolean available = false;
+    try {
+      System.loadLibrary("papyrus_text");
+      available = true;
+    } catch (Throwable ignored) {
+      available = false;
+    }
+    AVAILABLE = available;
+  }
+
+  // path is null to pull the text with nativeNext; 0 if the file cannot be
+  // created.
+  static native long nativeOpen(long session, int flags, String path);
+
+  // The next chunk of UTF-8, ending on a character boundary, or null once
+  // done. Valid until the next call.
+  static native ByteBuffer nativeNext(long export);
+
+  // 1 while pages remain, 0 once the file is in place, -1 on error.
+  static native int nativeWrite(long export, int chunkBudget);
+
+  // {bytes, chars} exported so far.
+  static native long[] nativeProgress(long export);
+
+  // Where each page exported so far starts, in bytes or in UTF-16 chars.
+  static native long[] nativePageOffsets(long export, boolean bytes);
+
+  static native void nativeClose(long export);
+
+  private long handle;
+  final boolean toFile;
+
+  PapyrusTextExport(long handle, boolean toFile) {
+    this.handle = handle;
+    this.toFile = toFile;
+  }
+
+  // Read and closed under the engine's pdfiumLock, like PapyrusSearchCursor.
+  long handle() {
+    return handle;
+  }
+
+  synchronized void close() {
+    if (handle != 0) {
+      nativeClose(handle);
+      handle = 0;
+    }
+  }
+}
@@ -1,6 +1,16 @@
 package com.papyrus.engine;
 
+import java.nio.ByteBuffer;
+
 final class PapyrusTextSearch {
+  // Match option bits for nativeCursorOpen, mirrored in papyrus_text_match.h.
+  static final int MATCH_CASE = 1;
+  static final int MATCH_DIACRITICS = 2;
+  static final int MATCH_WHOLE_WORD = 4;
+  // Edits (0 .. MAX_EDITS) an approximate search tolerates, from this bit up.
+  static final int EDITS_SHIFT = 8;
+  static final int MAX_EDITS = 2;
+
   static final boolean AVAILABLE;
 
   static {
@@ -14,7 +24,26 @@ final class PapyrusTextSearch {
     AVAILABLE = available;
   }
 
-  static native PapyrusTextHit[] nativeSearch(long docPtr, int pageCount, String query);
+  static native long nativeCursorOpen(long session, String query, int flags);
+
+  // A cursor finding every term in one pass per page; its hits carry the
+  // index of their term. Empty terms never match.
+  static native long nativeTermsOpen(long session, String[] terms, int flags);
+
+  // Stops after the page on which the hits reach maxHits, with all of that
+  // page's hits.
+  static native ByteBuffer nativeCursorNext(long cursor, int pageBatch, int workers, int maxHits);
+
+  static native int nativeCursorPosition(long cursor);
+
+  static native void nativeCursorCancel(long cursor);
+
+  static native void nativeCursorClose(long cursor);
+
+  // Persistent trigram index of the session's document, stored in directory.
+  // Returns the pages it already covers, or -1 if the document cannot have one.
+  static native int nativeIndexAttach(long session, String directory);
 
-  static native PapyrusTextHit[] nativeSearchFile(String filePath, String query);
+  // Indexes up to pageBudget more pages; the next page to index, or -1 once done.
+  static native int nativeIndexBuild(long session, int pageBudget);
 }
@@ -1,5 +1,7 @@
 package com.papyrus.engine;
 
+import java.nio.ByteBuffer;
+
 final class PapyrusTextSelect {
   static final boolean AVAILABLE;
 
@@ -14,7 +16,12 @@ final class PapyrusTextSelect {
     AVAILABLE = available;
   }
 
-  static native PapyrusTextSelection nativeSelectText(long docPtr, int pageIndex, float x, float y, float width, float height);
+  static native ByteBuffer nativeSelectText(long session, int pageIndex, float x, float y, float width, float height);
+
+  static native ByteBuffer nativeSelectWordAt(long session, int pageIndex, float x, float y);
+
+  static native ByteBuffer nativeSelectLineAt(long session, int pageIndex, float x, float y);
 
-  static native PapyrusTextSelection nativeSelectTextFile(String filePath, int pageIndex, float x, float y, float width, float height);
+  // Word runs of the page with their boxes and font sizes (kPackedTextRuns).
+  static native ByteBuffer nativeGetTextRuns(long session, int pageIndex);
 }
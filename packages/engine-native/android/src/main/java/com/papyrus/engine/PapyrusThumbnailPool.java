@@ -0,0 +1,43 @@
+package com.papyrus.engine;
+
+import android.graphics.Bitmap;
+
+import java.util.ArrayDeque;
+import java.util.Iterator;
+
+// RGB_565 thumbnail bitmaps shared by the page views of one engine. A sidebar
+// shows its thumbnails at one size, so scrolling it keeps reusing the same few
+// buffers instead of allocating one per page.
+final class PapyrusThumbnailPool {
+  // Thumbnails are rendered at most this wide and drawn scaled up in larger
+  // views; the native core renders them at twice this and filters them down.
+  static final int MAX_WIDTH = 256;
+  private static final int MAX_IDLE = 16;
+
+  private final ArrayDeque<Bitmap> idle = new ArrayDeque<>();
+
+  synchronized Bitmap acquire(int width, int height) {
+    Iterator<Bitmap> candidates = idle.iterator();
+    while (candidates.hasNext()) {
+      Bitmap bitmap = candidates.next();
+      if (bitmap.getWidth() == width && bitmap.getHeight() == height) {
+        candidates.remove();
+        return bitmap;
+      }
+    }
+    return Bitmap.createBitmap(width, height, Bitmap.Config.RGB_565);
+  }
+
+  synchronized void release(Bitmap bitmap) {
+    if (bitmap == null || bitmap.isRecycled()) return;
+    idle.push(bitmap);
+    if (idle.size() > MAX_IDLE) idle.pollLast().recycle();
+  }
+
+  synchronized void clear() {
+    for (Bitmap bitmap : idle) {
+      bitmap.recycle();
+    }
+    idle.clear();
+  }
+}
@@ -0,0 +1,35 @@
+package com.papyrus.engine;
+
+import android.graphics.Bitmap;
+
+import java.util.ArrayDeque;
+
+// Fixed-size tile bitmaps shared by the page views of one engine, so zooming
+// and scrolling reuse the same pixel buffers instead of allocating per tile.
+final class PapyrusTilePool {
+  static final int TILE_SIZE = 256;
+  private static final int MAX_IDLE = 64;
+
+  private final ArrayDeque<Bitmap> idle = new ArrayDeque<>();
+
+  synchronized Bitmap acquire() {
+    Bitmap tile = idle.poll();
+    return tile != null ? tile : Bitmap.createBitmap(TILE_SIZE, TILE_SIZE, Bitmap.Config.ARGB_8888);
+  }
+
+  synchronized void release(Bitmap tile) {
+    if (tile == null || tile.isRecycled()) return;
+    if (idle.size() < MAX_IDLE) {
+      idle.push(tile);
+    } else {
+      tile.recycle();
+    }
+  }
+
+  synchronized void clear() {
+    for (Bitmap tile : idle) {
+      tile.recycle();
+    }
+    idle.clear();
+  }
+}
@@ -10,12 +10,18 @@ import {
   RenderTargetType,
   TextItem,
   OutlineItem,
+  OutlineDestination,
   FileLike,
+  PageLink,
+  PageMetadata,
+  SearchOptions,
   SearchResult,
   TextSelection,
 } from '@papyrus-sdk/types';
 
 const MODULE_NAME = 'PapyrusNativeEngine';
+const SEARCH_FIRST_BATCH_PAGES = 4;
+const SEARCH_MAX_BATCH_PAGES = 64;
 
 const BASE64_CHARS = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
 const BASE64_LOOKUP = (() => {
@@ -104,6 +110,95 @@ const encodeBase64 = (bytes: Uint8Array): string => {
   return output;
 };
 
+// Packed search hits produced by papyrus_packed.h (Android): a 6 x int32
+// header, 6 int32 fields per hit (7 with the patternIndex of a terms search, 8
+// with the distance of an approximate one), a float32 rect table and a UTF-16
+// pool.
+const PACKED_MAGIC = 0x314b5050;
+const PACKED_KIND_SEARCH_HITS = 1;
+const PACKED_KIND_PAGE_METADATA = 6;
+const PACKED_HEADER_BYTES = 24;
+
+const decodePackedSearchHits = (packed: string): SearchResult[] => {
+  const bytes = decodeBase64(packed);
+  if (bytes.length < PACKED_HEADER_BYTES) return [];
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  if (view.getInt32(0, true) !== PACKED_MAGIC || view.getInt32(4, true) !== PACKED_KIND_SEARCH_HITS) return [];
+
+  const recordCount = view.getInt32(8, true);
+  const fields = view.getInt32(12, true);
+  const rectCount = view.getInt32(16, true);
+  const rectsAt = PACKED_HEADER_BYTES + recordCount * fields * 4;
+  const stringsAt = rectsAt + rectCount * 16;
+
+  const results: SearchResult[] = new Array(recordCount);
+  for (let i = 0; i < recordCount; i += 1) {
+    const at = PACKED_HEADER_BYTES + i * fields * 4;
+    const textOffset = view.getInt32(at + 8, true);
+    const textLength = view.getInt32(at + 12, true);
+    const rectFirst = view.getInt32(at + 16, true);
+    const hitRects = view.getInt32(at + 20, true);
+
+    let text = '';
+    for (let c = 0; c < textLength; c += 1) {
+      text += String.fromCharCode(view.getUint16(stringsAt + (textOffset + c) * 2, true));
+    }
+    const rects = [];
+    for (let r = rectFirst; r < rectFirst + hitRects; r += 1) {
+      const rectAt = rectsAt + r * 16;
+      rects.push({
+        x: view.getFloat32(rectAt, true),
+        y: view.getFloat32(rectAt + 4, true),
+        width: view.getFloat32(rectAt + 8, true),
+        height: view.getFloat32(rectAt + 12, true),
+      });
+    }
+    results[i] = {
+      pageIndex: view.getInt32(at, true),
+      matchIndex: view.getInt32(at + 4, true),
+      text,
+      ...(rects.length > 0 ? { rects } : {}),
+      ...(fields > 6 && view.getInt32(at + 24, true) >= 0 ? { patternIndex: view.getInt32(at + 24, true) } : {}),
+      ...(fields > 7 ? { distance: view.getInt32(at + 28, true) } : {}),
+    };
+  }
+  return results;
+};
+
+// Page metadata packed the same way: a (labelOffset, labelLength, rotation)
+// record per page and its (0, 0, width, height) rect in points.
+const decodePackedPageMetadata = (packed: string): PageMetadata[] => {
+  const bytes = decodeBase64(packed);
+  if (bytes.length < PACKED_HEADER_BYTES) return [];
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  if (view.getInt32(0, true) !== PACKED_MAGIC || view.getInt32(4, true) !== PACKED_KIND_PAGE_METADATA) return [];
+
+  const recordCount = view.getInt32(8, true);
+  const fields = view.getInt32(12, true);
+  const rectCount = view.getInt32(16, true);
+  const rectsAt = PACKED_HEADER_BYTES + recordCount * fields * 4;
+  const stringsAt = rectsAt + rectCount * 16;
+
+  const pages: PageMetadata[] = new Array(recordCount);
+  for (let i = 0; i < recordCount; i += 1) {
+    const at = PACKED_HEADER_BYTES + i * fields * 4;
+    const labelOffset = view.getInt32(at, true);
+    const labelLength = view.getInt32(at + 4, true);
+    const rotation = view.getInt32(at + 8, true);
+    let label = '';
+    for (let c = 0; c < labelLength; c += 1) {
+      label += String.fromCharCode(view.getUint16(stringsAt + (labelOffset + c) * 2, true));
+    }
+    pages[i] = {
+      width: view.getFloat32(rectsAt + i * 16 + 8, true),
+      height: view.getFloat32(rectsAt + i * 16 + 12, true),
+      ...(rotation >= 0 ? { rotation } : {}),
+      ...(labelLength > 0 ? { label } : {}),
+    };
+  }
+  return pages;
+};
+
 const isLoadRequest = (input: DocumentLoadInput): input is DocumentLoadRequest =>
   typeof input === 'object' && input !== null && 'source' in input && 'type' in input;
 
@@ -140,30 +235,180 @@ const inferDocumentType = (source: DocumentSource): DocumentType => {
   return 'pdf';
 };
 
+// Bytes cross the bridge as one base64 string rather than an array of
+// numbers; the native side decodes them straight into the buffer it opens.
 type NativeDocumentSource = {
   uri?: string;
-  data?: ArrayBuffer | Uint8Array;
+  base64?: string;
 };
 
+type NativeEngineOptions = {
+  searchWorkers?: number;
+  prewarm?: boolean;
+  renderCacheBytes?: number;
+  progressive?: boolean;
+  searchIndex?: boolean;
+  thumbnailCache?: boolean;
+};
+
+type NativeSearchFlags = {
+  matchCase?: boolean;
+  matchDiacritics?: boolean;
+  wholeWord?: boolean;
+  maxEdits?: number;
+};
+
+type NativeSearchBatch = {
+  /** Base64 of the packed hit buffer; see decodePackedSearchHits. */
+  packed?: string;
+  nextPage: number;
+  done: boolean;
+};
+
+export type NativeStatsPhase = {
+  count: number;
+  totalMs: number;
+  maxMs: number;
+  /** Bucket `b` counts calls under 2^(b + 1) µs; the last bucket is open-ended. */
+  histogram: number[];
+};
+
+/** Android native hot-path timings and counters; see `NativeDocumentEngine.getNativeStats`. */
+export type NativeStats = {
+  phases: Partial<
+    Record<
+      'pageLoad' | 'textLoad' | 'glyphs' | 'textIndex' | 'find' | 'preview' | 'marshal' | 'render',
+      NativeStatsPhase
+    >
+  >;
+  counters: Partial<
+    Record<
+      | 'textCacheHits'
+      | 'textCacheMisses'
+      | 'textCacheEvictions'
+      | 'pagesScanned'
+      | 'searchHits'
+      | 'pagesSkipped'
+      | 'thumbnailCacheHits'
+      | 'thumbnailsRendered',
+      number
+    >
+  >;
+};
+
+export type TextExportOptions = {
+  /** Writes the text to this file (path or file:// URI) instead of handing it to onChunk. */
+  path?: string;
+  /** Receives the text in order, in chunks of up to 64 KiB of UTF-8; awaited before the next one is read. */
+  onChunk?: (text: string) => void | Promise<void>;
+  /** Ends each page with a form feed instead of a line break. */
+  pageMarkers?: boolean;
+};
+
+/** Sizes of a finished text export; see `NativeDocumentEngine.exportText`. */
+export type TextExportResult = {
+  /** Length in UTF-8 bytes. */
+  bytes: number;
+  /** Length in JS string units. */
+  chars: number;
+  /** Where each page's text starts, in JS string units. */
+  pageOffsets: number[];
+  /** Where each page's text starts, in bytes of the UTF-8 file. */
+  pageByteOffsets: number[];
+};
+
+type NativeTextExportStep = {
+  text?: string;
+  bytes: number;
+  chars: number;
+  done: boolean;
+  pageOffsets?: number[];
+  pageByteOffsets?: number[];
+};
+
+// The search in progress; cursorId stays -1 until its cursor has opened.
+type ActiveSearch = { cursorId: number; cancelled: boolean };
+
 type NativeEngineModule = {
   createEngine?: () => string;
   destroyEngine?: (engineId: string) => void;
+  configure?: (engineId: string, options: NativeEngineOptions) => void;
+  prewarmPage?: (engineId: string, pageIndex: number) => void;
   load?: (engineId: string, source: NativeDocumentSource) => Promise<{ pageCount?: number } | void>;
   getPageCount?: (engineId: string) => number;
   renderPage?: (engineId: string, pageIndex: number, target: number, scale: number, zoom: number, rotation: number) => void;
   renderTextLayer?: (engineId: string, pageIndex: number, target: number, scale: number, zoom: number, rotation: number) => void;
+  renderThumbnail?: (engineId: string, pageIndex: number, target: number) => void;
   getTextContent?: (engineId: string, pageIndex: number) => Promise<TextItem[]>;
   getPageDimensions?: (engineId: string, pageIndex: number) => Promise<{ width: number; height: number }>;
+  /** Base64 of the packed page metadata; see decodePackedPageMetadata. */
+  getPageMetadata?: (engineId: string) => Promise<string | null>;
+  getPageLinks?: (engineId: string, pageIndex: number) => Promise<PageLink[]>;
+  getLinkAt?: (engineId: string, pageIndex: number, x: number, y: number) => Promise<PageLink | null>;
   searchText?: (engineId: string, query: string) => Promise<SearchResult[]>;
+  searchStart?: (engineId: string, query: string, options: NativeSearchFlags) => Promise<number>;
+  searchTermsStart?: (engineId: string, terms: string[], options: NativeSearchFlags) => Promise<number>;
+  searchNext?: (engineId: string, cursorId: number, pageBatch: number) => Promise<NativeSearchBatch>;
+  searchCancel?: (engineId: string, cursorId: number) => void;
+  searchClose?: (engineId: string, cursorId: number) => void;
   selectText?: (engineId: string, pageIndex: number, x: number, y: number, width: number, height: number) => Promise<TextSelection | null>;
+  selectWordAt?: (engineId: string, pageIndex: number, x: number, y: number) => Promise<TextSelection | null>;
+  selectLineAt?: (engineId: string, pageIndex: number, x: number, y: number) => Promise<TextSelection | null>;
   getOutline?: (engineId: string) => Promise<OutlineItem[]>;
+  getOutlineChildren?: (engineId: string, parentId: number) => Promise<OutlineItem[]>;
+  getOutlineDestination?: (engineId: string, nodeId: number) => Promise<OutlineDestination | null>;
   getPageIndex?: (engineId: string, dest: any) => Promise<number | null>;
+  getNativeStats?: (engineId: string, reset: boolean) => Promise<NativeStats | null>;
+  exportStart?: (engineId: string, options: { path?: string; pageMarkers?: boolean }) => Promise<number>;
+  exportNext?: (engineId: string, exportId: number) => Promise<NativeTextExportStep | null>;
+  exportClose?: (engineId: string, exportId: number) => void;
 };
 
 export type PapyrusPageViewProps = ViewProps & {
   engineId?: string;
 };
 
+export type NativeDocumentEngineOptions = {
+  /**
+   * Number of worker threads used to scan pages during `searchText` (Android).
+   * Defaults to 1; values above the device core count are clamped natively.
+   */
+  searchWorkers?: number;
+  /**
+   * Extracts the text of the first page after `load`, and of each page
+   * reached with `goToPage`, in the background (Android), so the first
+   * search or selection there does not pay for it. Defaults to false.
+   */
+  prewarm?: boolean;
+  /**
+   * Memory budget in bytes for rendered pages kept for scrolling back and
+   * rendered ahead in the scroll direction (Android). Defaults to an eighth
+   * of the app's heap limit; trimmed when the system reports memory pressure.
+   */
+  renderCacheBytes?: number;
+  /**
+   * Resolves `load` of an http(s) PDF as soon as its first page has arrived
+   * instead of after the whole download (Android). Pages the reader jumps to
+   * are fetched ahead with range requests when the server supports them;
+   * search and the outline wait for the download to finish. Works best with
+   * linearized ("fast web view") files. Defaults to false.
+   */
+  progressive?: boolean;
+  /**
+   * Keeps a trigram index of each document's text in the app cache directory
+   * (Android). It is built in the background after load and reused whenever
+   * the same file is opened again, so searches only extract the pages that
+   * can match. Defaults to false.
+   */
+  searchIndex?: boolean;
+  /**
+   * Keeps the thumbnails drawn by `renderThumbnail` in the app cache
+   * directory (Android), so a document's sidebar shows again without
+   * rendering when the same file is reopened. Defaults to true.
+   */
+  thumbnailCache?: boolean;
+};
+
 export const PapyrusPageView = requireNativeComponent<PapyrusPageViewProps>('PapyrusPageView');
 
 export class NativeDocumentEngine extends BaseDocumentEngine {
@@ -173,11 +418,25 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
   private currentPage: number = 1;
   private zoom: number = 1.0;
   private rotation: number = 0;
+  private activeSearch: ActiveSearch | null = null;
+  private prewarm: boolean = false;
+  private pageMetadata: PageMetadata[] = [];
 
-  constructor() {
+  constructor(options: NativeDocumentEngineOptions = {}) {
     super();
     this.nativeModule = (NativeModules as any)[MODULE_NAME] ?? null;
     this.engineId = this.nativeModule?.createEngine ? this.nativeModule.createEngine() : 'default';
+    const nativeOptions: NativeEngineOptions = {};
+    if (typeof options.searchWorkers === 'number') nativeOptions.searchWorkers = options.searchWorkers;
+    if (typeof options.prewarm === 'boolean') nativeOptions.prewarm = options.prewarm;
+    if (typeof options.renderCacheBytes === 'number') nativeOptions.renderCacheBytes = options.renderCacheBytes;
+    if (typeof options.progressive === 'boolean') nativeOptions.progressive = options.progressive;
+    if (typeof options.searchIndex === 'boolean') nativeOptions.searchIndex = options.searchIndex;
+    if (typeof options.thumbnailCache === 'boolean') nativeOptions.thumbnailCache = options.thumbnailCache;
+    if (Object.keys(nativeOptions).length > 0) {
+      this.nativeModule?.configure?.(this.engineId, nativeOptions);
+    }
+    this.prewarm = options.prewarm === true;
   }
 
   async load(input: DocumentLoadInput): Promise<void> {
@@ -188,6 +447,7 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
 
     const native = this.assertNativeModule();
     const normalized = await this.normalizeSource(source);
+    this.pageMetadata = [];
     const result = native.load ? await native.load(this.engineId, normalized) : undefined;
 
     if (result && typeof result.pageCount === 'number') {
@@ -199,6 +459,7 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
     }
 
     this.currentPage = 1;
+    this.pageMetadata = await this.fetchPageMetadata();
   }
 
   getPageCount(): number {
@@ -211,6 +472,9 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
 
   goToPage(page: number): void {
     if (page >= 1 && page <= this.pageCount) {
+      if (this.prewarm && page !== this.currentPage) {
+        this.nativeModule?.prewarmPage?.(this.engineId, page - 1);
+      }
       this.currentPage = page;
     }
   }
@@ -244,6 +508,17 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
     native.renderPage(this.engineId, pageIndex, viewTag, scale, this.zoom, this.rotation);
   }
 
+  async renderThumbnail(pageIndex: number, target: any): Promise<void> {
+    const native = this.assertNativeModule();
+    if (!native.renderThumbnail) {
+      await this.renderPage(pageIndex, target, 1);
+      return;
+    }
+    const viewTag = this.toNativeViewTag(target);
+    if (viewTag === null) return;
+    native.renderThumbnail(this.engineId, pageIndex, viewTag);
+  }
+
   async renderTextLayer(pageIndex: number, target: any, scale: number): Promise<void> {
     const native = this.assertNativeModule();
     if (!native.renderTextLayer) return;
@@ -259,11 +534,50 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
   }
 
   async getPageDimensions(pageIndex: number): Promise<{ width: number; height: number }> {
+    const known = this.pageMetadata[pageIndex];
+    if (known && known.width > 0 && known.height > 0) {
+      return { width: Math.round(known.width), height: Math.round(known.height) };
+    }
     const native = this.assertNativeModule();
     if (!native.getPageDimensions) return { width: 0, height: 0 };
     return native.getPageDimensions(this.engineId, pageIndex);
   }
 
+  /**
+   * Size, rotation and label of every page, read natively in one call after
+   * `load` without loading any page (Android). Sizes of a progressive
+   * download are 0 until it completes; asking again then fills them in.
+   */
+  async getPageMetadata(): Promise<PageMetadata[]> {
+    if (this.pageMetadata.some((page) => page.width <= 0)) {
+      this.pageMetadata = await this.fetchPageMetadata();
+    }
+    return this.pageMetadata.slice();
+  }
+
+  async getPageLinks(pageIndex: number): Promise<PageLink[]> {
+    const native = this.assertNativeModule();
+    if (!native.getPageLinks) return [];
+    return native.getPageLinks(this.engineId, pageIndex);
+  }
+
+  /**
+   * Link under a point in normalized coordinates (Android). The page's links
+   * are indexed natively on the first call, so later taps do not load it.
+   */
+  async getLinkAt(pageIndex: number, point: { x: number; y: number }): Promise<PageLink | null> {
+    const native = this.assertNativeModule();
+    if (!native.getLinkAt) return null;
+    return native.getLinkAt(this.engineId, pageIndex, point.x, point.y);
+  }
+
+  private async fetchPageMetadata(): Promise<PageMetadata[]> {
+    const native = this.assertNativeModule();
+    if (!native.getPageMetadata) return [];
+    const packed = await native.getPageMetadata(this.engineId);
+    return packed ? decodePackedPageMetadata(packed) : [];
+  }
+
   async selectText(
     pageIndex: number,
     rect: { x: number; y: number; width: number; height: number }
@@ -273,16 +587,181 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
     return native.selectText(this.engineId, pageIndex, rect.x, rect.y, rect.width, rect.height);
   }
 
+  async selectWordAt(pageIndex: number, point: { x: number; y: number }): Promise<TextSelection | null> {
+    const native = this.assertNativeModule();
+    if (!native.selectWordAt) return null;
+    return native.selectWordAt(this.engineId, pageIndex, point.x, point.y);
+  }
+
+  async selectLineAt(pageIndex: number, point: { x: number; y: number }): Promise<TextSelection | null> {
+    const native = this.assertNativeModule();
+    if (!native.selectLineAt) return null;
+    return native.selectLineAt(this.engineId, pageIndex, point.x, point.y);
+  }
+
+  // The whole tree, as before lazy outlines; getOutlineChildren lists large
+  // outlines one level at a time instead.
   async getOutline(): Promise<OutlineItem[]> {
     const native = this.assertNativeModule();
-    if (!native.getOutline) return [];
-    return native.getOutline(this.engineId);
+    if (native.getOutline) return native.getOutline(this.engineId);
+    if (!native.getOutlineChildren) return [];
+    return this.loadOutlineLevel(0);
+  }
+
+  private async loadOutlineLevel(parentId: number): Promise<OutlineItem[]> {
+    const items = await this.assertNativeModule().getOutlineChildren!(this.engineId, parentId);
+    for (const item of items) {
+      if (!item.hasChildren || item.id === undefined) continue;
+      item.children = await this.loadOutlineLevel(item.id);
+      delete item.hasChildren;
+    }
+    return items;
+  }
+
+  async getOutlineChildren(parent?: OutlineItem): Promise<OutlineItem[]> {
+    const native = this.assertNativeModule();
+    if (parent?.children) return parent.children;
+    if (!native.getOutlineChildren) return parent ? [] : this.getOutline();
+    if (parent && parent.id === undefined) return [];
+    return native.getOutlineChildren(this.engineId, parent?.id ?? 0);
   }
 
-  async searchText(query: string): Promise<SearchResult[]> {
+  async getOutlineDestination(item: OutlineItem): Promise<OutlineDestination | null> {
     const native = this.assertNativeModule();
-    if (!native.searchText) return [];
-    return native.searchText(this.engineId, query);
+    if (!native.getOutlineDestination || item.id === undefined) {
+      return item.pageIndex >= 0 ? { pageIndex: item.pageIndex } : null;
+    }
+    return native.getOutlineDestination(this.engineId, item.id);
+  }
+
+  /**
+   * Native timings and counters accumulated by this engine (Android). With
+   * `reset`, the counters restart after this sample, so periodic calls return
+   * deltas. Resolves to null where the platform does not collect them.
+   */
+  async getNativeStats(reset: boolean = false): Promise<NativeStats | null> {
+    const native = this.assertNativeModule();
+    if (!native.getNativeStats) return null;
+    return native.getNativeStats(this.engineId, reset);
+  }
+
+  /**
+   * Exports the whole document's text as UTF-8 (Android), to `options.path`
+   * or through `options.onChunk`, one page at a time: native memory stays at
+   * one chunk and one page however long the document is, and pages read for
+   * the export skip the text cache. Resolves to null if the export could not
+   * start or failed midway, in which case no file is left at `path`.
+   */
+  async exportText(options: TextExportOptions = {}): Promise<TextExportResult | null> {
+    const native = this.assertNativeModule();
+    if (!native.exportStart || !native.exportNext) return null;
+    const exportId = await native.exportStart(this.engineId, { path: options.path, pageMarkers: options.pageMarkers });
+    if (exportId < 0) return null;
+
+    try {
+      for (;;) {
+        const step = await native.exportNext(this.engineId, exportId);
+        if (!step) return null;
+        if (step.text) await options.onChunk?.(step.text);
+        if (step.done) {
+          return {
+            bytes: step.bytes,
+            chars: step.chars,
+            pageOffsets: step.pageOffsets ?? [],
+            pageByteOffsets: step.pageByteOffsets ?? [],
+          };
+        }
+      }
+    } finally {
+      native.exportClose?.(this.engineId, exportId);
+    }
+  }
+
+  async searchText(query: string, options: SearchOptions = {}): Promise<SearchResult[]> {
+    const native = this.assertNativeModule();
+    this.cancelActiveSearch();
+
+    if (!native.searchStart || !native.searchNext) {
+      if (!native.searchText) return [];
+      const search = this.beginSearch();
+      const results = await native.searchText(this.engineId, query);
+      if (search.cancelled) return [];
+      if (this.activeSearch === search) this.activeSearch = null;
+      options.onResults?.(results);
+      return results;
+    }
+
+    const search = this.beginSearch();
+    const cursorId = await native.searchStart(this.engineId, query, this.searchFlags(options));
+    return this.collectSearch(search, cursorId, options);
+  }
+
+  /**
+   * Finds every term of a glossary in one pass over each page instead of one
+   * search per term (Android). Each result carries the index of its term in
+   * `terms` as `patternIndex`; terms shorter than two characters never match.
+   * Replaces any search in progress, like searchText.
+   */
+  async searchTerms(terms: string[], options: SearchOptions = {}): Promise<SearchResult[]> {
+    const native = this.assertNativeModule();
+    this.cancelActiveSearch();
+    if (!native.searchTermsStart || !native.searchNext || terms.length === 0) return [];
+    const search = this.beginSearch();
+    const cursorId = await native.searchTermsStart(this.engineId, terms, this.searchFlags(options));
+    return this.collectSearch(search, cursorId, options);
+  }
+
+  private searchFlags(options: SearchOptions): NativeSearchFlags {
+    return {
+      matchCase: options.matchCase,
+      matchDiacritics: options.matchDiacritics,
+      wholeWord: options.wholeWord,
+      maxEdits: options.maxEdits,
+    };
+  }
+
+  // Registers a search before its cursor is opened, so a search started while
+  // the cursor is still opening supersedes this one.
+  private beginSearch(): ActiveSearch {
+    const search: ActiveSearch = { cursorId: -1, cancelled: false };
+    this.activeSearch = search;
+    return search;
+  }
+
+  // Reads a native search cursor batch by batch until it is exhausted,
+  // cancelled or has maxResults hits, then closes it. Approximate hits are
+  // kept closest first across batches, in page order within a distance.
+  private async collectSearch(search: ActiveSearch, cursorId: number, options: SearchOptions): Promise<SearchResult[]> {
+    const native = this.assertNativeModule();
+    if (search.cancelled || cursorId < 0 || !native.searchNext) {
+      if (cursorId >= 0) native.searchClose?.(this.engineId, cursorId);
+      if (this.activeSearch === search) this.activeSearch = null;
+      return [];
+    }
+    search.cursorId = cursorId;
+
+    const results: SearchResult[] = [];
+    let pageBatch = SEARCH_FIRST_BATCH_PAGES;
+    try {
+      while (!search.cancelled) {
+        const batch = await native.searchNext(this.engineId, cursorId, pageBatch);
+        if (search.cancelled) break;
+        const hits = batch.packed ? decodePackedSearchHits(batch.packed) : [];
+        if (hits.length > 0) {
+          results.push(...hits);
+          if (options.maxEdits) results.sort((a, b) => (a.distance ?? 0) - (b.distance ?? 0));
+          options.onResults?.(results.slice());
+        }
+        if (batch.done) break;
+        if (options.maxResults !== undefined && results.length >= options.maxResults) break;
+        pageBatch = Math.min(SEARCH_MAX_BATCH_PAGES, pageBatch * 2);
+      }
+    } finally {
+      if (this.activeSearch === search) this.activeSearch = null;
+      native.searchClose?.(this.engineId, cursorId);
+    }
+
+    return options.maxResults !== undefined ? results.slice(0, options.maxResults) : results;
   }
 
   async getPageIndex(dest: any): Promise<number | null> {
@@ -292,9 +771,19 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
   }
 
   destroy(): void {
+    this.cancelActiveSearch();
     this.nativeModule?.destroyEngine?.(this.engineId);
   }
 
+  private cancelActiveSearch(): void {
+    const search = this.activeSearch;
+    if (!search) return;
+    search.cancelled = true;
+    this.activeSearch = null;
+    // A search whose cursor is still opening closes it once it arrives.
+    if (search.cursorId >= 0) this.nativeModule?.searchCancel?.(this.engineId, search.cursorId);
+  }
+
   private assertNativeModule(): NativeEngineModule {
     if (!this.nativeModule) {
       throw new Error(`[Papyrus] Native module "${MODULE_NAME}" not found. Did you run pod install / gradle sync?`);
@@ -306,17 +795,21 @@ export class NativeDocumentEngine extends BaseDocumentEngine {
     if (typeof source === 'string') {
       const dataUri = parseDataUri(source);
       if (dataUri?.isBase64) {
-        return { data: decodeBase64(dataUri.data) };
+        return { base64: dataUri.data };
       }
       if (looksLikeUri(source)) return { uri: source };
-      if (isLikelyBase64(source)) return { data: decodeBase64(source) };
+      if (isLikelyBase64(source)) return { base64: source };
       return { uri: source };
     }
     if (this.isUriSource(source)) return { uri: source.uri };
-    if (this.isDataSource(source)) return { data: source.data };
-    if (this.isFileLike(source)) return { data: await source.arrayBuffer() };
-    if (source instanceof ArrayBuffer || source instanceof Uint8Array) return { data: source };
-    return { data: source as ArrayBuffer };
+    if (this.isDataSource(source)) return { base64: encodeBase64(this.toBytes(source.data)) };
+    if (this.isFileLike(source)) return { base64: encodeBase64(new Uint8Array(await source.arrayBuffer())) };
+    if (source instanceof ArrayBuffer || source instanceof Uint8Array) return { base64: encodeBase64(this.toBytes(source)) };
+    return { base64: encodeBase64(new Uint8Array(source as ArrayBuffer)) };
+  }
+
+  private toBytes(data: ArrayBuffer | Uint8Array): Uint8Array {
+    return data instanceof Uint8Array ? data : new Uint8Array(data);
   }
 
   private isUriSource(source: DocumentSource): source is { uri: string } {
@@ -549,8 +1042,10 @@ export class WebViewDocumentEngine extends BaseDocumentEngine {
     return await this.request<{ width: number; height: number }>('get-page-dimensions', { pageIndex });
   }
 
-  async searchText(query: string): Promise<SearchResult[]> {
-    return await this.request<SearchResult[]>('search-text', { query });
+  async searchText(query: string, options: SearchOptions = {}): Promise<SearchResult[]> {
+    const results = await this.request<SearchResult[]>('search-text', { query });
+    options.onResults?.(results);
+    return results;
   }
 
   async selectText(
@@ -718,9 +1213,9 @@ export class MobileDocumentEngine extends BaseDocumentEngine {
   private webEngine: WebViewDocumentEngine;
   private activeEngine: DocumentEngine;
 
-  constructor() {
+  constructor(options: NativeDocumentEngineOptions = {}) {
     super();
-    this.pdfEngine = new NativeDocumentEngine();
+    this.pdfEngine = new NativeDocumentEngine(options);
     this.webEngine = new WebViewDocumentEngine();
     this.activeEngine = this.pdfEngine;
   }
@@ -776,6 +1271,14 @@ export class MobileDocumentEngine extends BaseDocumentEngine {
     await this.activeEngine.renderPage(pageIndex, target, scale);
   }
 
+  async renderThumbnail(pageIndex: number, target: any): Promise<void> {
+    if (typeof this.activeEngine.renderThumbnail === 'function') {
+      await this.activeEngine.renderThumbnail(pageIndex, target);
+      return;
+    }
+    await this.activeEngine.renderPage(pageIndex, target, 1);
+  }
+
   async renderTextLayer(pageIndex: number, container: any, scale: number): Promise<void> {
     await this.activeEngine.renderTextLayer(pageIndex, container, scale);
   }
@@ -788,9 +1291,37 @@ export class MobileDocumentEngine extends BaseDocumentEngine {
     return await this.activeEngine.getPageDimensions(pageIndex);
   }
 
-  async searchText(query: string): Promise<SearchResult[]> {
+  async getPageMetadata(): Promise<PageMetadata[]> {
+    if (typeof this.activeEngine.getPageMetadata === 'function') {
+      return await this.activeEngine.getPageMetadata();
+    }
+    return [];
+  }
+
+  async getPageLinks(pageIndex: number): Promise<PageLink[]> {
+    if (typeof this.activeEngine.getPageLinks === 'function') {
+      return await this.activeEngine.getPageLinks(pageIndex);
+    }
+    return [];
+  }
+
+  async getLinkAt(pageIndex: number, point: { x: number; y: number }): Promise<PageLink | null> {
+    if (typeof this.activeEngine.getLinkAt === 'function') {
+      return await this.activeEngine.getLinkAt(pageIndex, point);
+    }
+    return null;
+  }
+
+  async searchText(query: string, options?: SearchOptions): Promise<SearchResult[]> {
     if (typeof this.activeEngine.searchText === 'function') {
-      return await this.activeEngine.searchText(query);
+      return await this.activeEngine.searchText(query, options);
+    }
+    return [];
+  }
+
+  async searchTerms(terms: string[], options?: SearchOptions): Promise<SearchResult[]> {
+    if (typeof this.activeEngine.searchTerms === 'function') {
+      return await this.activeEngine.searchTerms(terms, options);
     }
     return [];
   }
@@ -805,14 +1336,50 @@ export class MobileDocumentEngine extends BaseDocumentEngine {
     return null;
   }
 
+  async selectWordAt(pageIndex: number, point: { x: number; y: number }): Promise<TextSelection | null> {
+    if (typeof this.activeEngine.selectWordAt === 'function') {
+      return await this.activeEngine.selectWordAt(pageIndex, point);
+    }
+    return null;
+  }
+
+  async selectLineAt(pageIndex: number, point: { x: number; y: number }): Promise<TextSelection | null> {
+    if (typeof this.activeEngine.selectLineAt === 'function') {
+      return await this.activeEngine.selectLineAt(pageIndex, point);
+    }
+    return null;
+  }
+
   async getOutline(): Promise<OutlineItem[]> {
     return await this.activeEngine.getOutline();
   }
 
+  async getOutlineChildren(parent?: OutlineItem): Promise<OutlineItem[]> {
+    if (typeof this.activeEngine.getOutlineChildren === 'function') {
+      return await this.activeEngine.getOutlineChildren(parent);
+    }
+    return parent ? parent.children ?? [] : await this.activeEngine.getOutline();
+  }
+
+  async getOutlineDestination(item: OutlineItem): Promise<OutlineDestination | null> {
+    if (typeof this.activeEngine.getOutlineDestination === 'function') {
+      return await this.activeEngine.getOutlineDestination(item);
+    }
+    return item.pageIndex >= 0 ? { pageIndex: item.pageIndex } : null;
+  }
+
   async getPageIndex(dest: any): Promise<number | null> {
     return await this.activeEngine.getPageIndex(dest);
   }
 
+  async getNativeStats(reset: boolean = false): Promise<NativeStats | null> {
+    return await this.pdfEngine.getNativeStats(reset);
+  }
+
+  async exportText(options: TextExportOptions = {}): Promise<TextExportResult | null> {
+    return await this.pdfEngine.exportText(options);
+  }
+
   destroy(): void {
     this.pdfEngine.destroy();
     this.webEngine.destroy();
@@ -89,6 +89,7 @@ RCT_EXPORT_METHOD(load:(NSString *)engineId
                   resolver:(RCTPromiseResolveBlock)resolve
                   rejecter:(RCTPromiseRejectBlock)reject) {
   NSString *uri = source[@"uri"];
+  id base64Object = source[@"base64"];
   id dataObject = source[@"data"];
 
   void (^loadFromData)(NSData *) = ^(NSData *data) {
@@ -129,6 +130,16 @@ RCT_EXPORT_METHOD(load:(NSString *)engineId
     return;
   }
 
+  if ([base64Object isKindOfClass:[NSString class]]) {
+    NSData *data = [[NSData alloc] initWithBase64EncodedString:(NSString *)base64Object options:NSDataBase64DecodingIgnoreUnknownCharacters];
+    if (!data) {
+      reject(@"papyrus_invalid_source", @"Invalid base64 PDF data", nil);
+      return;
+    }
+    loadFromData(data);
+    return;
+  }
+
   if ([dataObject isKindOfClass:[NSData class]]) {
     loadFromData((NSData *)dataObject);
     return;
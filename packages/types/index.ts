@@ -40,6 +40,48 @@ export interface SearchResult {
   text: string;
   matchIndex: number;
   rects?: { x: number; y: number; width: number; height: number }[];
+  /** Index of the matched term in the list given to searchTerms. */
+  patternIndex?: number;
+  /** Edits between the query and the matched text, for searches with maxEdits. */
+  distance?: number;
+}
+
+export interface SearchOptions {
+  /** Called with the accumulated results each time an engine finds more hits. */
+  onResults?: (results: SearchResult[]) => void;
+  /** Stops the search once this many results were collected. */
+  maxResults?: number;
+  /** Distinguish upper and lower case. Default: false. */
+  matchCase?: boolean;
+  /** Distinguish accented letters from their base letter (é vs e). Default: false. */
+  matchDiacritics?: boolean;
+  /** Only match whole words. Default: false. */
+  wholeWord?: boolean;
+  /**
+   * Also match text up to this many typos away (0 .. 2), such as OCR errors;
+   * results come closest first. Default: 0.
+   */
+  maxEdits?: number;
+}
+
+/** Layout data of one page, known without loading it (see getPageMetadata). */
+export interface PageMetadata {
+  /** Size in points with the page's own rotation applied; 0 while unknown. */
+  width: number;
+  height: number;
+  /** The page's own rotation in degrees, once known. */
+  rotation?: number;
+  /** Label the document gives the page, such as "iv" or "A-3". */
+  label?: string;
+}
+
+export interface PageLink {
+  /** Normalized to the page (0..1), y growing downwards. */
+  rect: { x: number; y: number; width: number; height: number };
+  /** Target page of a link within the document. */
+  pageIndex?: number;
+  /** Target of a link leaving the document. */
+  uri?: string;
 }
 
 export interface TextSelection {
@@ -61,6 +103,18 @@ export interface OutlineItem {
   title: string;
   pageIndex: number;
   children?: OutlineItem[];
+  /** Handle for lazily loaded outlines; pass the item to getOutlineChildren. */
+  id?: number;
+  /** Set when children exist but were not loaded yet. */
+  hasChildren?: boolean;
+}
+
+export interface OutlineDestination {
+  pageIndex: number;
+  /** Position on the page in PDF points, when the destination specifies it. */
+  x?: number;
+  y?: number;
+  zoom?: number;
 }
 
 export interface PapyrusConfig {
@@ -119,6 +173,9 @@ export interface DocumentEngine {
    * target: HTMLCanvasElement no Web ou NativeHandle no RN.
    */
   renderPage(pageIndex: number, target: any, scale: number): Promise<void>;
+
+  /** Small, cached preview of the page for sidebars; falls back to renderPage where missing. */
+  renderThumbnail?(pageIndex: number, target: any): Promise<void>;
   
   /** 
    * Renderiza a camada de texto para seleção.
@@ -128,9 +185,25 @@ export interface DocumentEngine {
   
   getTextContent(pageIndex: number): Promise<TextItem[]>;
   getPageDimensions(pageIndex: number): Promise<{ width: number, height: number }>;
-  searchText?(query: string): Promise<SearchResult[]>;
+  /** Size, rotation and label of every page at once, for laying out a scroll view. */
+  getPageMetadata?(): Promise<PageMetadata[]>;
+  getPageLinks?(pageIndex: number): Promise<PageLink[]>;
+  /** Link under a point (normalized coordinates 0..1), or null. */
+  getLinkAt?(pageIndex: number, point: { x: number; y: number }): Promise<PageLink | null>;
+  searchText?(query: string, options?: SearchOptions): Promise<SearchResult[]>;
+  /** Finds every term of a list in one pass; each result carries its patternIndex. */
+  searchTerms?(terms: string[], options?: SearchOptions): Promise<SearchResult[]>;
   selectText?(pageIndex: number, rect: { x: number; y: number; width: number; height: number }): Promise<TextSelection | null>;
+  /** Palavra sob o ponto (coordenadas normalizadas 0..1). */
+  selectWordAt?(pageIndex: number, point: { x: number; y: number }): Promise<TextSelection | null>;
+  /** Linha inteira sob o ponto (coordenadas normalizadas 0..1). */
+  selectLineAt?(pageIndex: number, point: { x: number; y: number }): Promise<TextSelection | null>;
+  /** The whole outline tree, children included. */
   getOutline(): Promise<OutlineItem[]>;
+  /** Children of a lazily loaded outline item (top level when parent is omitted). */
+  getOutlineChildren?(parent?: OutlineItem): Promise<OutlineItem[]>;
+  /** Full destination (page plus position and zoom) of a lazily loaded outline item. */
+  getOutlineDestination?(item: OutlineItem): Promise<OutlineDestination | null>;
   getPageIndex(dest: any): Promise<number | null>;
   getRenderTargetType?(): RenderTargetType;
   destroy(): void;
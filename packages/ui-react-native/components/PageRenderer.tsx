@@ -187,6 +187,11 @@ const PageRenderer: React.FC<PageRendererProps> = ({
 
   const selectAtPoint = async (x: number, y: number) => {
     if (!layout.width || !layout.height) return;
+    if (engine.selectWordAt) {
+      const selection = await engine.selectWordAt(pageIndex, { x: x / layout.width, y: y / layout.height });
+      applySelectionResult(selection);
+      return;
+    }
     const size = 26;
     const half = size / 2;
     const left = clamp(x - half, 0, Math.max(0, layout.width - size));
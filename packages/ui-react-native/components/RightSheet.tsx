@@ -73,6 +73,10 @@ const PageThumbnail: React.FC<{
     if (!layoutReady || !useNativePreview) return;
     const viewTag = findNodeHandle(viewRef.current);
     if (!viewTag) return;
+    if (engine.renderThumbnail) {
+      void engine.renderThumbnail(pageIndex, viewTag);
+      return;
+    }
     const isNative = Platform.OS === 'android' || Platform.OS === 'ios';
     const renderScale = isNative ? 2.0 / Math.max(zoom, 0.5) : 2.0;
     void engine.renderPage(pageIndex, viewTag, renderScale);
@@ -115,38 +119,76 @@ const OutlineNode: React.FC<{
   item: OutlineItem;
   depth?: number;
   isDark: boolean;
+  engine: DocumentEngine;
   onSelect: (pageIndex: number) => void;
   untitledLabel: string;
-}> = ({ item, depth = 0, isDark, onSelect, untitledLabel }) => {
-  const hasChildren = item.children && item.children.length > 0;
+}> = ({ item, depth = 0, isDark, engine, onSelect, untitledLabel }) => {
+  // Lazily loaded outlines only report hasChildren; their children are
+  // fetched the first time the node is expanded.
+  const isLazy = Boolean(item.hasChildren) && !item.children;
+  const [children, setChildren] = useState<OutlineItem[] | undefined>(item.children);
+  const [expanded, setExpanded] = useState(!isLazy);
+  const [loading, setLoading] = useState(false);
+  const hasChildren = isLazy || Boolean(children && children.length > 0);
   const isClickable = item.pageIndex >= 0;
 
+  const toggleExpanded = async () => {
+    if (expanded) {
+      setExpanded(false);
+      return;
+    }
+    if (!children && engine.getOutlineChildren) {
+      setLoading(true);
+      try {
+        setChildren(await engine.getOutlineChildren(item));
+      } finally {
+        setLoading(false);
+      }
+    }
+    setExpanded(true);
+  };
+
   return (
     <View>
-      <Pressable
-        onPress={() => {
-          if (isClickable) onSelect(item.pageIndex);
-        }}
-        style={[styles.outlineRow, { paddingLeft: 12 + depth * 12 }]}
-      >
-        <Text
-          style={[
-            styles.outlineText,
-            isDark && styles.outlineTextDark,
-            !isClickable && styles.outlineTextMuted,
-          ]}
-          numberOfLines={2}
+      <View style={[styles.outlineRow, styles.outlineRowInner, { paddingLeft: 12 + depth * 12 }]}>
+        <Pressable
+          onPress={() => {
+            if (isClickable) onSelect(item.pageIndex);
+          }}
+          style={styles.outlineTitle}
         >
-          {item.title || untitledLabel}
-        </Text>
-      </Pressable>
+          <Text
+            style={[
+              styles.outlineText,
+              isDark && styles.outlineTextDark,
+              !isClickable && styles.outlineTextMuted,
+            ]}
+            numberOfLines={2}
+          >
+            {item.title || untitledLabel}
+          </Text>
+        </Pressable>
+        {isLazy ? (
+          <Pressable onPress={() => void toggleExpanded()} hitSlop={8} style={styles.outlineToggle}>
+            {loading ? (
+              <ActivityIndicator size="small" />
+            ) : (
+              <View style={expanded ? styles.outlineToggleExpanded : undefined}>
+                <IconChevronRight size={14} color={isDark ? '#e5e7eb' : '#6b7280'} />
+              </View>
+            )}
+          </Pressable>
+        ) : null}
+      </View>
       {hasChildren &&
-        item.children!.map((child, index) => (
+        expanded &&
+        children?.map((child, index) => (
           <OutlineNode
-            key={`${child.title}-${index}`}
+            key={child.id !== undefined ? `node-${child.id}` : `${child.title}-${index}`}
             item={child}
             depth={depth + 1}
             isDark={isDark}
+            engine={engine}
             onSelect={onSelect}
             untitledLabel={untitledLabel}
           />
@@ -182,6 +224,7 @@ const RightSheet: React.FC<RightSheetProps> = ({ engine }) => {
   const [query, setQuery] = useState('');
   const [isSearching, setIsSearching] = useState(false);
   const searchService = useMemo(() => new SearchService(engine), [engine]);
+  const searchRequestRef = useRef(0);
   const isDark = uiTheme === 'dark';
   const accentSoft = withAlpha(accentColor, 0.2);
   const accentStrong = withAlpha(accentColor, 0.35);
@@ -202,15 +245,24 @@ const RightSheet: React.FC<RightSheetProps> = ({ engine }) => {
   const handleSearch = async () => {
     const trimmed = query.trim();
     if (!trimmed) {
+      searchRequestRef.current += 1;
       setSearch('', []);
+      setIsSearching(false);
       return;
     }
+    const requestId = ++searchRequestRef.current;
     setIsSearching(true);
     try {
-      const results = await searchService.search(trimmed);
+      const results = await searchService.search(trimmed, {
+        onResults: (partial) => {
+          if (requestId !== searchRequestRef.current) return;
+          setDocumentState({ searchQuery: trimmed, searchResults: partial });
+        },
+      });
+      if (requestId !== searchRequestRef.current) return;
       setSearch(trimmed, results);
     } finally {
-      setIsSearching(false);
+      if (requestId === searchRequestRef.current) setIsSearching(false);
     }
   };
 
@@ -394,9 +446,10 @@ const RightSheet: React.FC<RightSheetProps> = ({ engine }) => {
                   ) : (
                     outline.map((item, index) => (
                       <OutlineNode
-                        key={`${item.title}-${index}`}
+                        key={item.id !== undefined ? `node-${item.id}` : `${item.title}-${index}`}
                         item={item}
                         isDark={isDark}
+                        engine={engine}
                         untitledLabel={t.untitled}
                         onSelect={(pageIndex) => {
                           engine.goToPage(pageIndex + 1);
@@ -727,6 +780,22 @@ const styles = StyleSheet.create({
     borderBottomWidth: 1,
     borderBottomColor: 'rgba(148, 163, 184, 0.18)',
   },
+  outlineRowInner: {
+    flexDirection: 'row',
+    alignItems: 'center',
+    paddingRight: 12,
+  },
+  outlineTitle: {
+    flex: 1,
+  },
+  outlineToggle: {
+    width: 24,
+    alignItems: 'center',
+    justifyContent: 'center',
+  },
+  outlineToggleExpanded: {
+    transform: [{ rotate: '90deg' }],
+  },
   outlineText: {
     fontSize: 12,
     fontWeight: '600',